@@ -149,13 +149,22 @@ float snoise(vec3 p)
 
 void main(void)
 {
-	varTexCoord = inTexCoord0.st;
+#ifdef COMPACT_VERTEX
+	// Map block meshes store positions and texture coordinates as scaled integers
+	vec4 vertexPosition = vec4(inVertexPosition.xyz * float(COMPACT_POS_STEP) +
+		float(COMPACT_POS_ORIGIN), 1.0);
+	vec2 vertexTexCoord = inTexCoord0.st * float(COMPACT_TCOORD_STEP);
+#else
+	vec4 vertexPosition = inVertexPosition;
+	vec2 vertexTexCoord = inTexCoord0.st;
+#endif
+	varTexCoord = vertexTexCoord;
 
 	float disp_x;
 	float disp_z;
 // OpenGL < 4.3 does not support continued preprocessor lines
 #if (MATERIAL_TYPE == TILE_MATERIAL_WAVING_LEAVES && ENABLE_WAVING_LEAVES) || (MATERIAL_TYPE == TILE_MATERIAL_WAVING_PLANTS && ENABLE_WAVING_PLANTS)
-	vec4 pos2 = mWorld * inVertexPosition;
+	vec4 pos2 = mWorld * vertexPosition;
 	float tOffset = (pos2.x + pos2.y) * 0.001 + pos2.z * 0.002;
 	disp_x = (smoothTriangleWave(animationTimer * 23.0 + tOffset) +
 		smoothTriangleWave(animationTimer * 11.0 + tOffset)) * 0.4;
@@ -164,7 +173,7 @@ void main(void)
 		smoothTriangleWave(animationTimer * 13.0 + tOffset)) * 0.5;
 #endif
 
-	vec4 pos = inVertexPosition;
+	vec4 pos = vertexPosition;
 #if MATERIAL_WAVING_LIQUID && ENABLE_WAVING_WATER
 	// Generate waves with Perlin-type noise.
 	// The constants are calibrated such that they roughly
@@ -220,8 +229,8 @@ void main(void)
 	if (f_shadow_strength > 0.0) {
 #if MATERIAL_TYPE == TILE_MATERIAL_WAVING_PLANTS && ENABLE_WAVING_PLANTS
 		// The shadow shaders don't apply waving when creating the shadow-map.
-		// We are using the not waved inVertexPosition to avoid ugly self-shadowing.
-		vec4 shadow_pos = inVertexPosition;
+		// We are using the not waved vertexPosition to avoid ugly self-shadowing.
+		vec4 shadow_pos = vertexPosition;
 #else
 		vec4 shadow_pos = pos;
 #endif
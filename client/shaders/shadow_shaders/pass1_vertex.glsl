@@ -34,10 +34,18 @@ vec4 applyPerspectiveDistortion(in vec4 position)
 
 void main()
 {
-	vec4 pos = LightMVP * gl_Vertex;
+#ifdef COMPACT_VERTEX
+	vec4 vertexPosition = vec4(gl_Vertex.xyz * float(COMPACT_POS_STEP) +
+		float(COMPACT_POS_ORIGIN), 1.0);
+	vec4 vertexTexCoord = vec4(gl_MultiTexCoord0.st * float(COMPACT_TCOORD_STEP), 0.0, 1.0);
+#else
+	vec4 vertexPosition = gl_Vertex;
+	vec4 vertexTexCoord = gl_MultiTexCoord0;
+#endif
+	vec4 pos = LightMVP * vertexPosition;
 
 	tPos = applyPerspectiveDistortion(pos);
 
 	gl_Position = vec4(tPos.xyz, 1.0);
-	gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
+	gl_TexCoord[0] = gl_TextureMatrix[0] * vertexTexCoord;
 }
@@ -85,6 +85,10 @@ class CMeshBuffer final : public IMeshBuffer
 	/** should be called if the mesh changed. */
 	void recalculateBoundingBox() override
 	{
+		// packed positions are in user defined units, use setBoundingBox()
+		if constexpr (!CVertexBuffer<T>::HasFloatAttributes)
+			return;
+
 		if (Vertices->getCount()) {
 			BoundingBox.reset(Vertices->getPosition(0));
 			const irr::u32 vsize = Vertices->getCount();
@@ -105,8 +109,10 @@ class CMeshBuffer final : public IMeshBuffer
 
 		auto *vt = static_cast<const T *>(vertices);
 		Vertices->Data.insert(Vertices->Data.end(), vt, vt + numVertices);
-		for (u32 i = vertexCount; i < getVertexCount(); i++)
-			BoundingBox.addInternalPoint(Vertices->getPosition(i));
+		if constexpr (CVertexBuffer<T>::HasFloatAttributes) {
+			for (u32 i = vertexCount; i < getVertexCount(); i++)
+				BoundingBox.addInternalPoint(Vertices->getPosition(i));
+		}
 
 		Indices->Data.insert(Indices->Data.end(), indices, indices + numIndices);
 		if (vertexCount != 0) {
@@ -145,5 +151,7 @@ typedef CMeshBuffer<video::S3DVertex> SMeshBuffer;
 typedef CMeshBuffer<video::S3DVertex2TCoords> SMeshBufferLightMap;
 //! Meshbuffer with vertices having tangents stored, e.g. for normal mapping
 typedef CMeshBuffer<video::S3DVertexTangents> SMeshBufferTangents;
+//! Meshbuffer with packed vertices
+typedef CMeshBuffer<video::S3DVertexCompact> SMeshBufferCompact;
 } // end namespace scene
 } // end namespace irr
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <type_traits>
 #include <vector>
 #include "IVertexBuffer.h"
 
@@ -23,6 +24,10 @@ template <class T>
 class CVertexBuffer final : public IVertexBuffer
 {
 public:
+	//! Whether the attributes are floats that can be accessed by reference.
+	//! The accessors must not be used otherwise.
+	static constexpr bool HasFloatAttributes = !std::is_same_v<T, video::S3DVertexCompact>;
+
 	//! Default constructor for empty buffer
 	CVertexBuffer() {}
 
@@ -48,32 +53,50 @@ class CVertexBuffer final : public IVertexBuffer
 
 	const core::vector3df &getPosition(u32 i) const override
 	{
-		return Data[i].Pos;
+		if constexpr (HasFloatAttributes)
+			return Data[i].Pos;
+		else
+			IRR_CODE_UNREACHABLE();
 	}
 
 	core::vector3df &getPosition(u32 i) override
 	{
-		return Data[i].Pos;
+		if constexpr (HasFloatAttributes)
+			return Data[i].Pos;
+		else
+			IRR_CODE_UNREACHABLE();
 	}
 
 	const core::vector3df &getNormal(u32 i) const override
 	{
-		return Data[i].Normal;
+		if constexpr (HasFloatAttributes)
+			return Data[i].Normal;
+		else
+			IRR_CODE_UNREACHABLE();
 	}
 
 	core::vector3df &getNormal(u32 i) override
 	{
-		return Data[i].Normal;
+		if constexpr (HasFloatAttributes)
+			return Data[i].Normal;
+		else
+			IRR_CODE_UNREACHABLE();
 	}
 
 	const core::vector2df &getTCoords(u32 i) const override
 	{
-		return Data[i].TCoords;
+		if constexpr (HasFloatAttributes)
+			return Data[i].TCoords;
+		else
+			IRR_CODE_UNREACHABLE();
 	}
 
 	core::vector2df &getTCoords(u32 i) override
 	{
-		return Data[i].TCoords;
+		if constexpr (HasFloatAttributes)
+			return Data[i].TCoords;
+		else
+			IRR_CODE_UNREACHABLE();
 	}
 
 	E_HARDWARE_MAPPING getHardwareMappingHint() const override
@@ -126,6 +149,8 @@ typedef CVertexBuffer<video::S3DVertex> SVertexBuffer;
 typedef CVertexBuffer<video::S3DVertex2TCoords> SVertexBufferLightMap;
 //! Buffer with vertices having tangents stored, e.g. for normal mapping
 typedef CVertexBuffer<video::S3DVertexTangents> SVertexBufferTangents;
+//! Buffer with packed vertices
+typedef CVertexBuffer<video::S3DVertexCompact> SVertexBufferCompact;
 
 } // end namespace scene
 } // end namespace irr
@@ -20,6 +20,7 @@ namespace video
 {
 
 class IVideoDriver;
+class IShaderBinaryCache;
 class IShaderConstantSetCallBack;
 
 //! Interface making it possible to create and use programs running on the GPU.
@@ -138,6 +139,13 @@ class IGPUProgrammingServices
 	\param material Number of the material type. Must not be a built-in
 	material. */
 	virtual void deleteShaderMaterial(s32 material) = 0;
+
+	//! Sets the cache for linked shader programs.
+	/** Shader materials added afterwards are loaded from and stored into
+	the cache if the driver supports program binaries. The cache is not
+	grabbed, so it must stay alive until it is unset again.
+	\param cache The cache, or nullptr to stop using one. */
+	virtual void setShaderBinaryCache(IShaderBinaryCache *cache) = 0;
 };
 
 } // end namespace video
@@ -227,6 +227,9 @@ class IMeshBuffer : public virtual IReferenceCounted
 			case video::EVT_TANGENTS:
 				ret += sizeof(video::S3DVertexTangents) * getVertexCount();
 				break;
+			case video::EVT_COMPACT:
+				ret += sizeof(video::S3DVertexCompact) * getVertexCount();
+				break;
 		}
 		switch (getIndexType()) {
 			case video::EIT_16BIT:
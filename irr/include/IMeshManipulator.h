@@ -136,6 +136,10 @@ class IMeshManipulator : public virtual IReferenceCounted
 		if (!buffer)
 			return true;
 
+		// packed vertices can't be passed to the functor
+		if (buffer->getVertexType() == video::EVT_COMPACT)
+			return false;
+
 		core::aabbox3df bufferbox{{0, 0, 0}};
 		for (u32 i = 0; i < buffer->getVertexCount(); ++i) {
 			switch (buffer->getVertexType()) {
@@ -151,6 +155,8 @@ class IMeshManipulator : public virtual IReferenceCounted
 				video::S3DVertexTangents *verts = (video::S3DVertexTangents *)buffer->getVertices();
 				func(verts[i]);
 			} break;
+			default:
+				break;
 			}
 			if (boundingBoxUpdate) {
 				if (0 == i)
@@ -0,0 +1,40 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "irrTypes.h"
+#include <string>
+
+namespace irr
+{
+namespace video
+{
+
+//! Interface for keeping linked shader programs across runs.
+/** Drivers that can save program binaries use this to skip compiling and
+linking programs whose sources did not change. Binaries are only valid for
+the exact driver that made them, so implementations have to tell drivers
+(and driver versions) apart themselves. A binary that the driver rejects is
+replaced by a freshly linked one. */
+class IShaderBinaryCache
+{
+public:
+	virtual ~IShaderBinaryCache() = default;
+
+	//! Looks up the binary of a program.
+	/** \param source Identifies the program: all of its sources and the
+	parameters it was linked with.
+	\param format Receives the driver specific format of the binary.
+	\param binary Receives the binary.
+	\return True if a binary was found. */
+	virtual bool loadProgram(const std::string &source, u32 &format,
+			std::string &binary) = 0;
+
+	//! Stores the binary of a program, see loadProgram.
+	virtual void storeProgram(const std::string &source, u32 format,
+			const std::string &binary) = 0;
+};
+
+} // end namespace video
+} // end namespace irr
@@ -27,7 +27,11 @@ enum E_VERTEX_TYPE
 	/** Usually used for tangent space normal mapping.
 		Usually tangent and binormal get send to shaders as texture coordinate sets 1 and 2.
 	*/
-	EVT_TANGENTS
+	EVT_TANGENTS,
+
+	//! Vertex with packed attributes, video::S3DVertexCompact.
+	/** Only usable with shaders that know how to scale the attributes. */
+	EVT_COMPACT
 };
 
 //! Array holding the built in vertex type names
@@ -35,6 +39,7 @@ const char *const sBuiltInVertexTypeNames[] = {
 		"standard",
 		"2tcoords",
 		"tangents",
+		"compact",
 		0,
 	};
 
@@ -272,6 +277,37 @@ struct S3DVertexTangents : public S3DVertex
 	}
 };
 
+//! Vertex with fixed point attributes, about half the size of S3DVertex.
+/** Position and texture coordinates are stored as 16 bit integers, in units
+	chosen by the user; shaders have to scale them back. The normal is
+	normalized to -127..127 by the driver. As the attributes are not floats,
+	they can't be accessed through the generic mesh buffer accessors.
+*/
+struct S3DVertexCompact
+{
+	//! Position, in user defined steps
+	s16 Pos[3] = {};
+
+	//! Unused, keeps the following members aligned
+	s16 Padding = 0;
+
+	//! Normal vector, the fourth component is unused
+	s8 Normal[4] = {};
+
+	//! Color
+	SColor Color{0xffffffff};
+
+	//! Texture coordinates, in user defined steps
+	s16 TCoords[2] = {};
+
+	static E_VERTEX_TYPE getType()
+	{
+		return EVT_COMPACT;
+	}
+};
+
+static_assert(sizeof(S3DVertexCompact) == 20, "unexpected vertex padding");
+
 inline u32 getVertexPitchFromType(E_VERTEX_TYPE vertexType)
 {
 	switch (vertexType) {
@@ -279,6 +315,8 @@ inline u32 getVertexPitchFromType(E_VERTEX_TYPE vertexType)
 		return sizeof(video::S3DVertex2TCoords);
 	case video::EVT_TANGENTS:
 		return sizeof(video::S3DVertexTangents);
+	case video::EVT_COMPACT:
+		return sizeof(video::S3DVertexCompact);
 	default:
 		return sizeof(video::S3DVertex);
 	}
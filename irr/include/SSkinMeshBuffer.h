@@ -159,6 +159,8 @@ struct SSkinMeshBuffer final : public IMeshBuffer
 			recalculateBoundingBox(Vertices_Tangents);
 			break;
 		}
+		default:
+			break;
 		}
 	}
 
@@ -170,6 +170,15 @@ SMesh *CMeshManipulator::createMeshCopy(scene::IMesh *mesh) const
 			clone->addMeshBuffer(buffer);
 			buffer->drop();
 		} break;
+		case video::EVT_COMPACT: {
+			SMeshBufferCompact *buffer = new SMeshBufferCompact();
+			buffer->Material = mb->getMaterial();
+			copyVertices(mb->getVertexBuffer(), buffer->Vertices);
+			copyIndices(mb->getIndexBuffer(), buffer->Indices);
+			buffer->setBoundingBox(mb->getBoundingBox());
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
+		} break;
 		} // end switch
 
 	} // end for all mesh buffers
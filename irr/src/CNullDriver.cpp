@@ -1678,6 +1678,11 @@ void CNullDriver::deleteShaderMaterial(s32 material)
 	ref.Name.clear();
 }
 
+void CNullDriver::setShaderBinaryCache(IShaderBinaryCache *cache)
+{
+	ShaderBinaryCache = cache;
+}
+
 //! Creates a render target texture.
 ITexture *CNullDriver::addRenderTargetTexture(const core::dimension2d<u32> &size,
 		const io::path &name, const ECOLOR_FORMAT format)
@@ -489,6 +489,11 @@ class CNullDriver : public IVideoDriver, public IGPUProgrammingServices
 
 	virtual void deleteShaderMaterial(s32 material) override;
 
+	void setShaderBinaryCache(IShaderBinaryCache *cache) override;
+
+	//! Returns the cache for linked shader programs, may be null
+	IShaderBinaryCache *getShaderBinaryCache() const { return ShaderBinaryCache; }
+
 	//! Returns a pointer to the mesh manipulator.
 	scene::IMeshManipulator *getMeshManipulator() override;
 
@@ -729,6 +734,8 @@ class CNullDriver : public IVideoDriver, public IGPUProgrammingServices
 	bool RangeFog;
 	bool AllowZWriteOnTransparent;
 
+	IShaderBinaryCache *ShaderBinaryCache = nullptr;
+
 	bool FeatureEnabled[video::EVDF_COUNT];
 };
 
@@ -277,6 +277,13 @@ bool COpenGLDriver::updateVertexHardwareBuffer(SHWBufferLink_opengl *HWBuffer)
 				po[i].Color.toOpenGLColor((u8 *)&(pb[i].Color));
 			}
 		} break;
+		case EVT_COMPACT: {
+			S3DVertexCompact *pb = reinterpret_cast<S3DVertexCompact *>(buffer.pointer());
+			const S3DVertexCompact *po = static_cast<const S3DVertexCompact *>(vertices);
+			for (u32 i = 0; i < vertexCount; i++) {
+				po[i].Color.toOpenGLColor((u8 *)&(pb[i].Color));
+			}
+		} break;
 		default: {
 			return false;
 		}
@@ -695,6 +702,9 @@ void COpenGLDriver::drawVertexPrimitiveList(const void *vertices, u32 vertexCoun
 			case EVT_TANGENTS:
 				glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexTangents), &(static_cast<const S3DVertexTangents *>(vertices))[0].Color);
 				break;
+			case EVT_COMPACT:
+				glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexCompact), &(static_cast<const S3DVertexCompact *>(vertices))[0].Color);
+				break;
 			}
 		} else {
 			// avoid passing broken pointer to OpenGL
@@ -774,6 +784,29 @@ void COpenGLDriver::drawVertexPrimitiveList(const void *vertices, u32 vertexCoun
 				glTexCoordPointer(3, GL_FLOAT, sizeof(S3DVertexTangents), buffer_offset(48));
 		}
 		break;
+	case EVT_COMPACT:
+		// integer positions and texture coordinates are converted as is,
+		// the shader has to scale them
+		if (vertices) {
+			glNormalPointer(GL_BYTE, sizeof(S3DVertexCompact), &(static_cast<const S3DVertexCompact *>(vertices))[0].Normal);
+			glTexCoordPointer(2, GL_SHORT, sizeof(S3DVertexCompact), &(static_cast<const S3DVertexCompact *>(vertices))[0].TCoords);
+			glVertexPointer(3, GL_SHORT, sizeof(S3DVertexCompact), &(static_cast<const S3DVertexCompact *>(vertices))[0].Pos);
+		} else {
+			glNormalPointer(GL_BYTE, sizeof(S3DVertexCompact), buffer_offset(8));
+			glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexCompact), buffer_offset(12));
+			glTexCoordPointer(2, GL_SHORT, sizeof(S3DVertexCompact), buffer_offset(16));
+			glVertexPointer(3, GL_SHORT, sizeof(S3DVertexCompact), 0);
+		}
+
+		if (Feature.MaxTextureUnits > 0 && CacheHandler->getTextureCache()[1]) {
+			CacheHandler->setClientActiveTexture(GL_TEXTURE0 + 1);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			if (vertices)
+				glTexCoordPointer(2, GL_SHORT, sizeof(S3DVertexCompact), &(static_cast<const S3DVertexCompact *>(vertices))[0].TCoords);
+			else
+				glTexCoordPointer(2, GL_SHORT, sizeof(S3DVertexCompact), buffer_offset(16));
+		}
+		break;
 	}
 
 	renderArray(indexList, primitiveCount, pType, iType);
@@ -820,6 +853,13 @@ void COpenGLDriver::getColorBuffer(const void *vertices, u32 vertexCount, E_VERT
 			++p;
 		}
 	} break;
+	case EVT_COMPACT: {
+		const S3DVertexCompact *p = static_cast<const S3DVertexCompact *>(vertices);
+		for (i = 0; i < vertexCount; i += 4) {
+			p->Color.toOpenGLColor(&ColorBuffer[i]);
+			++p;
+		}
+	} break;
 	}
 }
 
@@ -968,6 +1008,9 @@ void COpenGLDriver::draw2DVertexPrimitiveList(const void *vertices, u32 vertexCo
 			case EVT_TANGENTS:
 				glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexTangents), &(static_cast<const S3DVertexTangents *>(vertices))[0].Color);
 				break;
+			case EVT_COMPACT:
+				glColorPointer(colorSize, GL_UNSIGNED_BYTE, sizeof(S3DVertexCompact), &(static_cast<const S3DVertexCompact *>(vertices))[0].Color);
+				break;
 			}
 		} else {
 			// avoid passing broken pointer to OpenGL
@@ -1025,6 +1068,9 @@ void COpenGLDriver::draw2DVertexPrimitiveList(const void *vertices, u32 vertexCo
 			glVertexPointer(2, GL_FLOAT, sizeof(S3DVertexTangents), buffer_offset(0));
 		}
 
+		break;
+	case EVT_COMPACT:
+		// not meant for 2D drawing
 		break;
 	}
 
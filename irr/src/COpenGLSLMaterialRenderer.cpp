@@ -25,6 +25,7 @@
 #include "COpenGLMaterialRenderer.h"
 
 #include "COpenGLCoreFeature.h"
+#include "GLProgramBinary.h"
 
 namespace irr
 {
@@ -142,6 +143,26 @@ void COpenGLSLMaterialRenderer::init(s32 &outMaterialTypeNr,
 	if (!createProgram())
 		return;
 
+	// Only programs made through the GL 2.0 API can be cached
+	IShaderBinaryCache *binaryCache = Program2 ? Driver->getShaderBinaryCache() : nullptr;
+	if (binaryCache && !isProgramBinarySupported())
+		binaryCache = nullptr;
+	std::string binaryKey;
+	if (binaryCache) {
+		std::string extra;
+		if (geometryShaderProgram) {
+			extra = std::to_string(inType) + " " + std::to_string(outType) +
+					" " + std::to_string(verticesOut);
+		}
+		binaryKey = makeProgramBinaryKey(vertexShaderProgram, pixelShaderProgram,
+				geometryShaderProgram, extra);
+		if (loadProgramBinary(binaryCache, Program2, binaryKey)) {
+			if (linkProgram(true))
+				outMaterialTypeNr = Driver->addMaterialRenderer(this);
+			return;
+		}
+	}
+
 #if defined(GL_ARB_vertex_shader) && defined(GL_ARB_fragment_shader)
 	if (vertexShaderProgram)
 		if (!createShader(GL_VERTEX_SHADER_ARB, vertexShaderProgram))
@@ -174,8 +195,12 @@ void COpenGLSLMaterialRenderer::init(s32 &outMaterialTypeNr,
 	}
 #endif
 
+	if (binaryCache)
+		prepareProgramBinary(Program2);
 	if (!linkProgram())
 		return;
+	if (binaryCache)
+		storeProgramBinary(binaryCache, Program2, binaryKey);
 
 	// register myself as new material
 	outMaterialTypeNr = Driver->addMaterialRenderer(this);
@@ -344,10 +369,11 @@ bool COpenGLSLMaterialRenderer::createShader(GLenum shaderType, const char *shad
 	return true;
 }
 
-bool COpenGLSLMaterialRenderer::linkProgram()
+bool COpenGLSLMaterialRenderer::linkProgram(bool fromBinary)
 {
 	if (Program2) {
-		Driver->extGlLinkProgram(Program2);
+		if (!fromBinary)
+			Driver->extGlLinkProgram(Program2);
 
 		GLint status = 0;
 
@@ -91,7 +91,9 @@ class COpenGLSLMaterialRenderer : public IMaterialRenderer, public IMaterialRend
 
 	bool createProgram();
 	bool createShader(GLenum shaderType, const char *shader);
-	bool linkProgram();
+	//! Links the program and reads its uniforms. If `fromBinary` is set,
+	//! Program2 was loaded from a binary and is only checked.
+	bool linkProgram(bool fromBinary = false);
 
 	COpenGLDriver *Driver;
 	IShaderConstantSetCallBack *CallBack;
@@ -0,0 +1,84 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "GLProgramBinary.h"
+
+#include "IShaderBinaryCache.h"
+#include "mt_opengl.h"
+#include "os.h"
+
+namespace irr
+{
+namespace video
+{
+
+bool isProgramBinarySupported()
+{
+	if (!GL.GetProgramBinary || !GL.ProgramBinary || !GL.ProgramParameteri)
+		return false;
+
+	// Contexts without support reject the query, leaving the value as is
+	int formats = 0;
+	GL.GetIntegerv(GL.NUM_PROGRAM_BINARY_FORMATS, &formats);
+	GL.GetError();
+	return formats > 0;
+}
+
+std::string makeProgramBinaryKey(const c8 *vertexShaderProgram,
+		const c8 *pixelShaderProgram, const c8 *geometryShaderProgram,
+		const std::string &extra)
+{
+	std::string key;
+	for (const c8 *source : {vertexShaderProgram, pixelShaderProgram, geometryShaderProgram}) {
+		if (source)
+			key.append(source);
+		// separate the parts so that moving text between them changes the key
+		key.push_back('\0');
+	}
+	key.append(extra);
+	return key;
+}
+
+bool loadProgramBinary(IShaderBinaryCache *cache, u32 program, const std::string &key)
+{
+	u32 format;
+	std::string binary;
+	if (!cache->loadProgram(key, format, binary))
+		return false;
+
+	GL.ProgramBinary(program, format, binary.data(), binary.size());
+
+	// The driver may reject binaries, e.g. after it was updated
+	int status = 0;
+	GL.GetProgramiv(program, GL.LINK_STATUS, &status);
+	if (!status) {
+		os::Printer::log("GLSL: cached program binary was rejected, recompiling", ELL_DEBUG);
+		return false;
+	}
+	return true;
+}
+
+void prepareProgramBinary(u32 program)
+{
+	GL.ProgramParameteri(program, GL.PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+}
+
+void storeProgramBinary(IShaderBinaryCache *cache, u32 program, const std::string &key)
+{
+	int length = 0;
+	GL.GetProgramiv(program, GL.PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::string binary(length, '\0');
+	unsigned int format = 0;
+	GL.GetProgramBinary(program, length, &length, &format, binary.data());
+	if (length <= 0)
+		return;
+	binary.resize(length);
+
+	cache->storeProgram(key, format, binary);
+}
+
+} // end namespace video
+} // end namespace irr
@@ -0,0 +1,39 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include "irrTypes.h"
+#include <string>
+
+namespace irr
+{
+namespace video
+{
+
+class IShaderBinaryCache;
+
+// Helpers for keeping linked GLSL programs in an IShaderBinaryCache,
+// shared by the GLSL material renderers. They use the current context.
+
+//! Whether the context can save and load program binaries
+bool isProgramBinarySupported();
+
+//! Builds the key that identifies a program in the cache. `extra` should
+//! describe any state that is set on the program before linking.
+std::string makeProgramBinaryKey(const c8 *vertexShaderProgram,
+		const c8 *pixelShaderProgram, const c8 *geometryShaderProgram,
+		const std::string &extra = "");
+
+//! Tries to load a program that has no shaders attached from the cache.
+//! \return True if the program is linked afterwards.
+bool loadProgramBinary(IShaderBinaryCache *cache, u32 program, const std::string &key);
+
+//! Asks the driver to keep the binary. Call this before linking.
+void prepareProgramBinary(u32 program);
+
+//! Stores a linked program in the cache
+void storeProgramBinary(IShaderBinaryCache *cache, u32 program, const std::string &key);
+
+} // end namespace video
+} // end namespace irr
@@ -94,6 +94,16 @@ static const VertexType vtTangents = {
 
 #pragma GCC diagnostic pop
 
+static const VertexType vtCompact = {
+		sizeof(S3DVertexCompact),
+		{
+				{EVA_POSITION, 3, GL_SHORT, VertexAttribute::Mode::Regular, offsetof(S3DVertexCompact, Pos)},
+				{EVA_NORMAL, 3, GL_BYTE, VertexAttribute::Mode::Normalized, offsetof(S3DVertexCompact, Normal)},
+				{EVA_COLOR, 4, GL_UNSIGNED_BYTE, VertexAttribute::Mode::Normalized, offsetof(S3DVertexCompact, Color)},
+				{EVA_TCOORD0, 2, GL_SHORT, VertexAttribute::Mode::Regular, offsetof(S3DVertexCompact, TCoords)},
+		},
+};
+
 static const VertexType &getVertexTypeDescription(E_VERTEX_TYPE type)
 {
 	switch (type) {
@@ -103,6 +113,8 @@ static const VertexType &getVertexTypeDescription(E_VERTEX_TYPE type)
 		return vt2TCoords;
 	case EVT_TANGENTS:
 		return vtTangents;
+	case EVT_COMPACT:
+		return vtCompact;
 	default:
 		IRR_CODE_UNREACHABLE();
 	}
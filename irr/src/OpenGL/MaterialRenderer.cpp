@@ -5,6 +5,7 @@
 #include "MaterialRenderer.h"
 
 #include "EVertexAttributes.h"
+#include "GLProgramBinary.h"
 #include "IGPUProgrammingServices.h"
 #include "IShaderConstantSetCallBack.h"
 #include "IVideoDriver.h"
@@ -109,19 +110,38 @@ void COpenGL3MaterialRenderer::init(s32 &outMaterialTypeNr,
 	if (!Program)
 		return;
 
-	if (vertexShaderProgram)
-		if (!createShader(GL_VERTEX_SHADER, vertexShaderProgram))
-			return;
+	IShaderBinaryCache *binaryCache = Driver->getShaderBinaryCache();
+	if (binaryCache && !isProgramBinarySupported())
+		binaryCache = nullptr;
+	std::string binaryKey;
+	bool fromBinary = false;
+	if (binaryCache) {
+		binaryKey = makeProgramBinaryKey(vertexShaderProgram, pixelShaderProgram, nullptr);
+		fromBinary = loadProgramBinary(binaryCache, Program, binaryKey);
+	}
 
-	if (pixelShaderProgram)
-		if (!createShader(GL_FRAGMENT_SHADER, pixelShaderProgram))
+	if (fromBinary) {
+		if (!linkProgram(true))
 			return;
+	} else {
+		if (vertexShaderProgram)
+			if (!createShader(GL_VERTEX_SHADER, vertexShaderProgram))
+				return;
 
-	for (size_t i = 0; i < EVA_COUNT; ++i)
-		GL.BindAttribLocation(Program, i, sBuiltInVertexAttributeNames[i]);
+		if (pixelShaderProgram)
+			if (!createShader(GL_FRAGMENT_SHADER, pixelShaderProgram))
+				return;
 
-	if (!linkProgram())
-		return;
+		for (size_t i = 0; i < EVA_COUNT; ++i)
+			GL.BindAttribLocation(Program, i, sBuiltInVertexAttributeNames[i]);
+
+		if (binaryCache)
+			prepareProgramBinary(Program);
+		if (!linkProgram())
+			return;
+		if (binaryCache)
+			storeProgramBinary(binaryCache, Program, binaryKey);
+	}
 
 	if (debugName)
 		Driver->irrGlObjectLabel(GL_PROGRAM, Program, debugName);
@@ -218,10 +238,11 @@ bool COpenGL3MaterialRenderer::createShader(GLenum shaderType, const char *shade
 	return true;
 }
 
-bool COpenGL3MaterialRenderer::linkProgram()
+bool COpenGL3MaterialRenderer::linkProgram(bool fromBinary)
 {
 	if (Program) {
-		GL.LinkProgram(Program);
+		if (!fromBinary)
+			GL.LinkProgram(Program);
 
 		GLint status = 0;
 
@@ -72,7 +72,9 @@ class COpenGL3MaterialRenderer : public IMaterialRenderer, public IMaterialRende
 		bool addMaterial = true);
 
 	bool createShader(GLenum shaderType, const char *shader);
-	bool linkProgram();
+	//! Links the program and reads its uniforms. If `fromBinary` is set,
+	//! the program was loaded from a binary and is only checked.
+	bool linkProgram(bool fromBinary = false);
 
 	COpenGL3DriverBase *Driver;
 	IShaderConstantSetCallBack *CallBack;
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 // Copyright (C) 2010-2018 nerzhul, Loic BLOT <loic.blot@unix-experience.fr>
 
+#include <algorithm>
 #include <cmath>
 #include <log.h>
 #include "profiler.h"
@@ -10,6 +11,26 @@
 namespace client
 {
 
+// Distance from the object position to the farthest point of its selection box
+static f32 get_selection_radius(const ClientActiveObject *obj)
+{
+	aabb3f selection_box{{0.0f, 0.0f, 0.0f}};
+	if (!obj->getSelectionBox(&selection_box))
+		return 0.0f;
+	return selection_box.getCenter().getLength() +
+			selection_box.getExtent().getLength() / 2;
+}
+
+// Index queries return objects in tree order, keep the ID order of a scan
+template <typename T, typename F>
+static void sort_by_id(typename std::vector<T>::iterator begin,
+		typename std::vector<T>::iterator end, const F &get_obj)
+{
+	std::sort(begin, end, [&] (const T &a, const T &b) {
+		return get_obj(a)->getId() < get_obj(b)->getId();
+	});
+}
+
 ActiveObjectMgr::~ActiveObjectMgr()
 {
 	if (!m_active_objects.empty()) {
@@ -23,12 +44,23 @@ void ActiveObjectMgr::step(
 		float dtime, const std::function<void(ClientActiveObject *)> &f)
 {
 	size_t count = 0;
+	f32 max_selection_radius = 0.0f;
+	m_registered_selection_radius = 0.0f;
 	for (auto &ao_it : m_active_objects.iter()) {
 		if (!ao_it.second)
 			continue;
 		count++;
 		f(ao_it.second.get());
+
+		// Stepping may have moved the object or removed it
+		ClientActiveObject *obj = ao_it.second.get();
+		if (!obj)
+			continue;
+		updateObjectPos(ao_it.first, obj);
+		max_selection_radius = std::max(max_selection_radius, get_selection_radius(obj));
 	}
+	// Objects registered while stepping were not visited
+	m_max_selection_radius = std::max(max_selection_radius, m_registered_selection_radius);
 	g_profiler->avg("ActiveObjectMgr: CAO count [#]", count);
 }
 
@@ -53,7 +85,16 @@ bool ActiveObjectMgr::registerObject(std::unique_ptr<ClientActiveObject> obj)
 	}
 	infostream << "Client::ActiveObjectMgr::registerObject(): "
 			<< "added (id=" << obj->getId() << ")" << std::endl;
-	m_active_objects.put(obj->getId(), std::move(obj));
+
+	const u16 id = obj->getId();
+	const v3f pos = obj->getPosition();
+	const f32 selection_radius = get_selection_radius(obj.get());
+	m_max_selection_radius = std::max(m_max_selection_radius, selection_radius);
+	m_registered_selection_radius = std::max(m_registered_selection_radius, selection_radius);
+
+	m_active_objects.put(id, std::move(obj));
+	m_spatial_index.insert(pos.toArray(), id);
+	m_indexed_pos[id] = pos;
 	return true;
 }
 
@@ -68,26 +109,58 @@ void ActiveObjectMgr::removeObject(u16 id)
 				<< "id=" << id << " not found" << std::endl;
 		return;
 	}
+	m_spatial_index.remove(id);
+	m_indexed_pos.erase(id);
 
 	obj->removeFromScene(true);
 }
 
+void ActiveObjectMgr::updateObjectPos(u16 id, ClientActiveObject *obj)
+{
+	auto it = m_indexed_pos.find(id);
+	if (it == m_indexed_pos.end())
+		return;
+	const v3f pos = obj->getPosition();
+	if (pos == it->second)
+		return;
+	it->second = pos;
+	m_spatial_index.update(pos.toArray(), id);
+}
+
 void ActiveObjectMgr::getActiveObjects(const v3f &origin, f32 max_d,
 		std::vector<DistanceSortedActiveObject> &dest)
 {
+	const size_t first = dest.size();
 	f32 max_d2 = max_d * max_d;
-	for (auto &ao_it : m_active_objects.iter()) {
-		ClientActiveObject *obj = ao_it.second.get();
+	m_spatial_index.rangeQuery((origin - v3f(max_d)).toArray(),
+			(origin + v3f(max_d)).toArray(), [&] (auto _, u16 id) {
+		ClientActiveObject *obj = m_active_objects.get(id).get();
 		if (!obj)
-			continue;
+			return;
 
 		f32 d2 = (obj->getPosition() - origin).getLengthSQ();
 
 		if (d2 > max_d2)
-			continue;
+			return;
 
 		dest.emplace_back(obj, d2);
-	}
+	});
+	sort_by_id<DistanceSortedActiveObject>(dest.begin() + first, dest.end(),
+			[] (const DistanceSortedActiveObject &it) { return it.obj; });
+}
+
+void ActiveObjectMgr::getActiveObjectsInArea(const aabb3f &box,
+		std::vector<ClientActiveObject *> &dest)
+{
+	const size_t first = dest.size();
+	m_spatial_index.rangeQuery(box.MinEdge.toArray(), box.MaxEdge.toArray(),
+			[&] (auto _, u16 id) {
+		ClientActiveObject *obj = m_active_objects.get(id).get();
+		if (obj && box.isPointInside(obj->getPosition()))
+			dest.push_back(obj);
+	});
+	sort_by_id<ClientActiveObject *>(dest.begin() + first, dest.end(),
+			[] (ClientActiveObject *obj) { return obj; });
 }
 
 void ActiveObjectMgr::getAllActiveObjects(const v3f &origin,
@@ -117,10 +190,22 @@ std::vector<DistanceSortedActiveObject> ActiveObjectMgr::getActiveSelectableObje
 	f32 max_d = shootline.getLength();
 	v3f dir = shootline.getVector().normalize();
 
-	for (auto &ao_it : m_active_objects.iter()) {
-		ClientActiveObject *obj = ao_it.second.get();
-		if (!obj)
-			continue;
+	// Any object whose selection box touches the line is in this box
+	aabb3f search_box(shootline.start);
+	search_box.addInternalPoint(shootline.end);
+	search_box.MinEdge -= v3f(m_max_selection_radius);
+	search_box.MaxEdge += v3f(m_max_selection_radius);
+
+	std::vector<ClientActiveObject *> candidates;
+	m_spatial_index.rangeQuery(search_box.MinEdge.toArray(),
+			search_box.MaxEdge.toArray(), [&] (auto _, u16 id) {
+		if (ClientActiveObject *obj = m_active_objects.get(id).get())
+			candidates.push_back(obj);
+	});
+	sort_by_id<ClientActiveObject *>(candidates.begin(), candidates.end(),
+			[] (ClientActiveObject *obj) { return obj; });
+
+	for (ClientActiveObject *obj : candidates) {
 
 		aabb3f selection_box{{0.0f, 0.0f, 0.0f}};
 		if (!obj->getSelectionBox(&selection_box))
@@ -5,9 +5,11 @@
 #pragma once
 
 #include <functional>
+#include <unordered_map>
 #include <vector>
 #include "../activeobjectmgr.h"
 #include "clientobject.h"
+#include "util/k_d_tree.h"
 
 namespace client
 {
@@ -23,6 +25,8 @@ class ActiveObjectMgr final : public ::ActiveObjectMgr<ClientActiveObject>
 
 	void getActiveObjects(const v3f &origin, f32 max_d,
 			std::vector<DistanceSortedActiveObject> &dest);
+	void getActiveObjectsInArea(const aabb3f &box,
+			std::vector<ClientActiveObject *> &dest);
 	void getAllActiveObjects(const v3f &origin,
 			std::vector<DistanceSortedActiveObject> &dest);
 		void getAllActiveObjectsLegacy(std::unordered_map<u16, ClientActiveObject*> &dest);
@@ -32,5 +36,23 @@ class ActiveObjectMgr final : public ::ActiveObjectMgr<ClientActiveObject>
 	/// @note CAOs without a selection box are not returned.
 	/// @note Distances are along the @p shootline.
 	std::vector<DistanceSortedActiveObject> getActiveSelectableObjects(const core::line3d<f32> &shootline);
+
+private:
+	// Moves the object in the spatial index if its position changed
+	void updateObjectPos(u16 id, ClientActiveObject *obj);
+
+	/*
+		Object positions are indexed when the object is registered and
+		refreshed on every step(). Queries look up candidates in the index
+		and then check them against the current positions.
+	*/
+	k_d_tree::DynamicKdTrees<3, f32, u16> m_spatial_index;
+	// Position each object is indexed at
+	std::unordered_map<u16, v3f> m_indexed_pos;
+	// Upper bound of the distance from an object position to any point of
+	// its selection box, over all objects (grows until the next step)
+	f32 m_max_selection_radius = 0.0f;
+	// Same, for the objects registered since the last step started
+	f32 m_registered_selection_radius = 0.0f;
 };
 } // namespace client
@@ -0,0 +1,140 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "block_decoder.h"
+#include "exceptions.h"
+#include "log.h"
+#include "mapblock.h"
+#include "profiler.h"
+#include "threading/mutex_auto_lock.h"
+#include "util/stream.h"
+
+class BlockDecoder::Worker : public UpdateThread
+{
+public:
+	Worker(BlockDecoder *decoder) : UpdateThread("BlockDecode"), m_decoder(decoder) {}
+
+protected:
+	void doUpdate() override { m_decoder->work(); }
+
+private:
+	BlockDecoder *m_decoder;
+};
+
+BlockDecoder::BlockDecoder(IGameDef *gamedef, unsigned int num_threads) :
+	m_gamedef(gamedef)
+{
+	infostream << "BlockDecoder: using " << num_threads << " threads" << std::endl;
+	for (unsigned int i = 0; i < num_threads; i++)
+		m_workers.push_back(std::make_unique<Worker>(this));
+}
+
+BlockDecoder::~BlockDecoder()
+{
+	{
+		// Don't bother decoding what is left
+		MutexAutoLock lock(m_mutex);
+		m_todo.clear();
+	}
+	for (auto &worker : m_workers)
+		worker->stop();
+	for (auto &worker : m_workers)
+		worker->wait();
+}
+
+void BlockDecoder::start()
+{
+	if (m_started)
+		return;
+	m_started = true;
+	for (auto &worker : m_workers)
+		worker->start();
+}
+
+void BlockDecoder::push(v3s16 pos, std::string &&data, u8 ser_ver)
+{
+	auto job = std::make_unique<Job>();
+	job->pos = pos;
+	job->data = std::move(data);
+	job->ser_ver = ser_ver;
+
+	if (!m_started || m_workers.empty()) {
+		decode(*job);
+		job->done = true;
+		MutexAutoLock lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+		return;
+	}
+
+	{
+		MutexAutoLock lock(m_mutex);
+		m_todo.push_back(job.get());
+		m_jobs.push_back(std::move(job));
+	}
+	for (auto &worker : m_workers)
+		worker->deferUpdate();
+}
+
+bool BlockDecoder::pop(DecodedBlock &result, bool wait)
+{
+	std::unique_lock lock(m_mutex);
+	if (m_jobs.empty())
+		return false;
+
+	if (!m_jobs.front()->done) {
+		if (!wait)
+			return false;
+		m_done_cv.wait(lock, [&] { return m_jobs.front()->done; });
+	}
+
+	result = std::move(m_jobs.front()->result);
+	m_jobs.pop_front();
+	return true;
+}
+
+size_t BlockDecoder::size()
+{
+	MutexAutoLock lock(m_mutex);
+	return m_jobs.size();
+}
+
+void BlockDecoder::decode(Job &job) const
+{
+	ScopeProfiler sp(g_profiler, "Client: Block decoding (sum)");
+
+	job.result.pos = job.pos;
+	auto block = std::make_unique<MapBlock>(job.pos, m_gamedef);
+	try {
+		std::string_view data = job.data;
+		size_t size = block->deSerialize(data, job.ser_ver, false);
+		StringViewStream is(data.substr(size));
+		block->deSerializeNetworkSpecific(is);
+		job.result.block = std::move(block);
+	} catch (BaseException &e) {
+		job.result.error = e.what();
+	}
+	// The payload is not needed anymore
+	job.data = std::string();
+}
+
+void BlockDecoder::work()
+{
+	for (;;) {
+		Job *job;
+		{
+			MutexAutoLock lock(m_mutex);
+			if (m_todo.empty())
+				return;
+			job = m_todo.front();
+			m_todo.pop_front();
+		}
+
+		decode(*job);
+
+		{
+			MutexAutoLock lock(m_mutex);
+			job->done = true;
+		}
+		m_done_cv.notify_all();
+	}
+}
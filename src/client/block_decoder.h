@@ -0,0 +1,90 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "irr_v3d.h"
+#include "util/basic_macros.h"
+#include "util/thread.h"
+
+class IGameDef;
+class MapBlock;
+
+struct DecodedBlock
+{
+	v3s16 pos;
+	// nullptr if the data could not be decoded
+	std::unique_ptr<MapBlock> block;
+	// Reason why decoding failed
+	std::string error;
+};
+
+/*
+	Decodes the payload of TOCLIENT_BLOCKDATA (decompression and parsing of
+	the node data and metadata) on worker threads, into standalone MapBlocks
+	that only need to be put into the map afterwards.
+
+	Results are handed out in the order the blocks were queued, so several
+	updates of the same block are applied in the right order.
+*/
+class BlockDecoder
+{
+public:
+	BlockDecoder(IGameDef *gamedef, unsigned int num_threads);
+	~BlockDecoder();
+
+	DISABLE_CLASS_COPY(BlockDecoder);
+
+	/*
+		Starts the worker threads. Blocks queued before this are decoded
+		right away on the calling thread, since the item definitions that
+		node metadata refers to may not be complete yet.
+	*/
+	void start();
+
+	// `data` is the packet payload after the block position
+	void push(v3s16 pos, std::string &&data, u8 ser_ver);
+
+	/*
+		Takes the oldest queued block if it is decoded. With `wait`, waits
+		for it instead; returns false only if nothing is queued then.
+	*/
+	bool pop(DecodedBlock &result, bool wait);
+
+	// Number of blocks that were queued but not popped yet
+	size_t size();
+
+private:
+	class Worker;
+
+	struct Job
+	{
+		v3s16 pos;
+		std::string data;
+		u8 ser_ver;
+		DecodedBlock result;
+		bool done = false;
+	};
+
+	void decode(Job &job) const;
+	// Decodes queued jobs until there are none left
+	void work();
+
+	IGameDef *m_gamedef;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	bool m_started = false;
+
+	std::mutex m_mutex;
+	// Signalled when a job is done
+	std::condition_variable m_done_cv;
+	// All jobs that were not popped yet, in queue order
+	std::deque<std::unique_ptr<Job>> m_jobs;
+	// Jobs that no worker has picked up yet
+	std::deque<Job *> m_todo;
+};
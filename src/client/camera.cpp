@@ -13,6 +13,7 @@
 #include "client/renderingengine.h"
 #include "client/content_cao.h"
 #include "settings.h"
+#include "client/settings_snapshot.h"
 #include "wieldmesh.h"
 #include "noise.h"         // easeCurve
 #include "mtevent.h"
@@ -323,7 +324,7 @@ void Camera::update(LocalPlayer* player, f32 frametime, f32 tool_reload_ratio)
 	// mods expect the player head to be at the parent's position
 	// plus eye height.
 	if (player->getParent())
-		player_position = player->getParent()->getPosition() + v3f(0,  g_settings->getBool("float_above_parent") ? BS : 0, 0);
+		player_position = player->getParent()->getPosition() + v3f(0,  SettingsSnapshot::get()->float_above_parent ? BS : 0, 0);
 
 	// Smooth the camera movement after the player instantly moves upward due to stepheight.
 	// The smoothing usually continues until the camera position reaches the player position.
@@ -331,7 +332,7 @@ void Camera::update(LocalPlayer* player, f32 frametime, f32 tool_reload_ratio)
 	float upward_movement = player_position.Y - old_player_position.Y;
 	if (upward_movement < 0.01f || upward_movement > player_stepheight) {
 		m_stepheight_smooth_active = false;
-	} else if (player->touching_ground && !g_settings->getBool("freecam")) {
+	} else if (player->touching_ground && !SettingsSnapshot::get()->freecam) {
 		m_stepheight_smooth_active = true;
 	}
 	if (m_stepheight_smooth_active) {
@@ -486,8 +487,9 @@ void Camera::update(LocalPlayer* player, f32 frametime, f32 tool_reload_ratio)
 		// Set to client's selected FOV
 		m_curr_fov_degrees = m_cache_fov;
 	}
-	if (g_settings->getBool("fov_setting")) {
-		m_curr_fov_degrees = rangelim(g_settings->getFloat("fov.step"), 1.0f, 160.0f);
+	const auto settings = SettingsSnapshot::get();
+	if (settings->fov_setting) {
+		m_curr_fov_degrees = rangelim(settings->fov_step, 1.0f, 160.0f);
 	} else {
 		m_curr_fov_degrees = rangelim(m_curr_fov_degrees, 1.0f, 160.0f);
 	}
@@ -544,7 +546,7 @@ void Camera::update(LocalPlayer* player, f32 frametime, f32 tool_reload_ratio)
 		wield_position.Y += std::sin(my_modf(bobfrac*2.0)*M_PI) * 3.0;
 	}
 	// Apply left-hand mirroring using quaternions
-	if (g_settings->getBool("left_hand")) {
+	if (settings->left_hand) {
 		// Mirror position across X-axis
 		wield_position.X = -wield_position.X;
 
@@ -583,9 +585,9 @@ void Camera::update(LocalPlayer* player, f32 frametime, f32 tool_reload_ratio)
 	const bool walking = movement_XZ && player->touching_ground;
 	const bool swimming = (movement_XZ || player->swimming_vertical) && player->in_liquid;
 	const bool climbing = movement_Y && player->is_climbing;
-	const bool flying = g_settings->getBool("free_move")
+	const bool flying = settings->free_move
 		&& m_client->checkLocalPrivilege("fly");
-	if ((walking || swimming || climbing) && !flying && !g_settings->getBool("nobob")) {
+	if ((walking || swimming || climbing) && !flying && !settings->nobob) {
 		// Start animation
 		m_view_bobbing_state = 1;
 		m_view_bobbing_speed = MYMIN(speed.getLength(), 70);
@@ -741,6 +743,7 @@ void Camera::drawHealthESP(float dtime)
 {
     ClientEnvironment &env = m_client->getEnv();
     gui::IGUIFont *font = g_fontengine->getFont();
+    const auto settings = SettingsSnapshot::get();
 
     v3f origin = getPosition();
 
@@ -748,7 +751,6 @@ void Camera::drawHealthESP(float dtime)
     env.getAllActiveObjects(origin, sortedObjects);
 
     f32 fovScale = 72 / m_curr_fov_degrees;
-    warningstream << std::to_string(m_curr_fov_degrees) << ", " << std::to_string(fovScale) << std::endl;
 
     video::IVideoDriver *driver = RenderingEngine::get_video_driver();
     core::matrix4 trans = m_cameranode->getProjectionMatrix() * m_cameranode->getViewMatrix();
@@ -763,7 +765,7 @@ void Camera::drawHealthESP(float dtime)
         if (obj->isLocalPlayer() || !obj->canAttack(1))
             continue;
 		
-        if (!obj->isPlayer() && g_settings->getBool("enable_health_esp.players_only"))
+        if (!obj->isPlayer() && settings->enable_health_esp_players_only)
             continue;
 
         v3f textPos = obj->getSceneNode()->getAbsolutePosition();
@@ -772,7 +774,7 @@ void Camera::drawHealthESP(float dtime)
 
         trans.multiplyWith1x4Matrix(transformed_pos);
         if (transformed_pos[3] > 0) {
-            if (g_settings->exists("enable_health_esp.type") && g_settings->get("enable_health_esp.type") == "Health Bar") {
+            if (settings->health_esp_bar) {
                 double health_percentage = obj->getProperties().hp_max > 0 ? static_cast<double>(getInterpolatedHealth(obj, dtime)) / obj->getProperties().hp_max : 0.0;
                 health_percentage = std::max(0.0, std::min(1.0, health_percentage));
 
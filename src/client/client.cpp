@@ -21,7 +21,12 @@
 #include "client/texturepaths.h"
 #include "client/texturesource.h"
 #include "client/mesh_generator_thread.h"
+#include "client/block_decoder.h"
+#include "client/local_map_save_thread.h"
+#include "client/meshgen/content_filter.h"
+#include "client/meshgen/compact_vertex.h"
 #include "client/particles.h"
+#include "client/settings_snapshot.h"
 #include "client/localplayer.h"
 #include "util/auth.h"
 #include "util/directiontables.h"
@@ -109,6 +114,8 @@ Client::Client(
 	m_rendering_engine(rendering_engine),
 	m_item_visuals_manager(item_visuals_manager),
 	m_mesh_update_manager(std::make_unique<MeshUpdateManager>(this)),
+	m_block_decoder(std::make_unique<BlockDecoder>(this,
+		MYMAX(1U, MYMIN(4U, Thread::getNumberOfProcessors() / 4)))),
 	m_env(
 		make_irr<ClientMap>(this, rendering_engine, control, 666),
 		tsrc, this
@@ -123,6 +130,10 @@ Client::Client(
 	m_state(LC_Created),
 	m_modchannel_mgr(new ModChannelMgr())
 {
+	// Publish the settings snapshot early: it registers settings callbacks,
+	// which must not happen from within another callback (updateAllMapBlocks)
+	SettingsSnapshot::get();
+
 	// Add local player
 	m_env.setLocalPlayer(new LocalPlayer(this, playername));
 
@@ -137,6 +148,9 @@ Client::Client(
 
 	m_cache_save_interval = g_settings->getU16("server_map_save_interval");
 	m_mesh_grid = { g_settings->getU16("client_mesh_chunk") };
+	if (g_settings->getBool("compact_block_meshes") &&
+			CompactVertexFormat::supports(m_mesh_grid))
+		m_compact_vertex_format = std::make_unique<CompactVertexFormat>(m_mesh_grid);
 }
 
 void Client::migrateModStorage()
@@ -319,8 +333,9 @@ void Client::Stop()
 	m_mesh_update_manager->stop();
 	// Save local server map
 	if (m_localdb) {
+		m_localdb->finish();
+		m_localdb.reset();
 		infostream << "Local map saving ended." << std::endl;
-		m_localdb->endSave();
 	}
 
 	if (m_mods_loaded)
@@ -343,13 +358,12 @@ Client::~Client()
 	m_mesh_update_manager->stop();
 	m_mesh_update_manager->wait();
 
+	// The decoder threads use the item definitions
+	m_block_decoder.reset();
+
 	MeshUpdateResult r;
-	while (m_mesh_update_manager->getNextResult(r)) {
-		for (auto block : r.map_blocks)
-			if (block)
-				block->refDrop();
+	while (m_mesh_update_manager->getNextResult(r))
 		delete r.mesh;
-	}
 
 	delete m_inventory_from_server;
 
@@ -585,6 +599,28 @@ void Client::step(float dtime)
 		}
 	}
 
+	/*
+		Let the mesh workers start with the meshes around the camera
+	*/
+	if (m_camera) {
+		m_mesh_update_manager->setCameraBlock(
+				getNodeBlockPos(floatToInt(m_camera->getPosition(), BS)));
+	}
+
+	/*
+		Feed pending mesh updates of a global invalidation to the mesh
+		workers, without flooding their queue
+	*/
+	if (!m_remesh_backlog.empty()) {
+		const u32 queue_limit = 64;
+		u32 queue_size = m_mesh_update_manager->getQueueSize();
+		while (queue_size < queue_limit && !m_remesh_backlog.empty()) {
+			addUpdateMeshTask(m_remesh_backlog.back());
+			m_remesh_backlog.pop_back();
+			queue_size++;
+		}
+	}
+
 	/*
 		Replace updated meshes
 	*/
@@ -618,6 +654,7 @@ void Client::step(float dtime)
 				delete block->mesh;
 				block->mesh = nullptr;
 				block->solid_sides = r.solid_sides;
+				block->mesh_contents = std::move(r.contents);
 
 				if (r.mesh) {
 					minimap_mapblocks = r.mesh->moveMinimapMapblocks();
@@ -655,6 +692,16 @@ void Client::step(float dtime)
 				}
 			}
 
+			// Every block of the mesh cell carries its own opacity mask
+			for (auto &it : r.opacity) {
+				MapBlock *opacity_block = it.first == r.p ? block :
+						map.getBlockNoCreateNoEx(it.first);
+				if (opacity_block)
+					opacity_block->opacity = std::move(it.second);
+			}
+			if (!r.opacity.empty())
+				map.invalidateOcclusionCache();
+
 			for (auto p : r.ack_list) {
 				if (blocks_to_ack.size() == 255) {
 					sendGotBlocks(blocks_to_ack);
@@ -663,10 +710,6 @@ void Client::step(float dtime)
 
 				blocks_to_ack.emplace_back(p);
 			}
-
-			for (auto block : r.map_blocks)
-				if (block)
-					block->refDrop();
 		}
 		if (blocks_to_ack.size() > 0) {
 				// Acknowledge block(s)
@@ -793,13 +836,12 @@ void Client::step(float dtime)
 	// Write server map
 	if (m_localdb && m_localdb_save_interval.step(dtime,
 			m_cache_save_interval)) {
-		m_localdb->endSave();
-		m_localdb->beginSave();
+		m_localdb->flush();
 	}
 }
 
 bool Client::loadMedia(const std::string &data, const std::string &filename,
-	bool from_media_push)
+	bool from_media_push, const std::string &raw_hash)
 {
 	std::string name;
 
@@ -829,7 +871,7 @@ bool Client::loadMedia(const std::string &data, const std::string &filename,
 			return false;
 		}
 
-		m_tsrc->insertSourceImage(filename, img);
+		m_tsrc->insertSourceImage(filename, img, raw_hash);
 		img->drop();
 		rfile->drop();
 		return true;
@@ -958,8 +1000,10 @@ void Client::initLocalMapSaving(const Address &address, const std::string &hostn
 #undef set_world_path
 	fs::CreateAllDirs(world_path);
 
-	m_localdb = new MapDatabaseSQLite3(world_path);
-	m_localdb->beginSave();
+	m_localdb = std::make_unique<LocalMapSaveThread>(
+			new MapDatabaseSQLite3(world_path),
+			rangelim(g_settings->getS16("map_compression_level_disk"), -1, 9));
+	m_localdb->start();
 	actionstream << "Local map saving started, map will be saved at '" << world_path << "'" << std::endl;
 }
 
@@ -990,6 +1034,40 @@ void Client::ReceiveAll()
 					 << e.what() << std::endl;
 		}
 	}
+
+	// Blocks that are still being decoded are picked up next time
+	applyDecodedBlocks(false);
+}
+
+void Client::applyDecodedBlocks(bool wait)
+{
+	DecodedBlock decoded;
+	while (m_block_decoder->pop(decoded, wait)) {
+		if (!decoded.block) {
+			std::ostringstream os;
+			os << "Invalid block data at " << decoded.pos << ": " << decoded.error;
+			throw SerializationError(os.str());
+		}
+
+		const v3s16 p = decoded.pos;
+		MapSector *sector = m_env.getMap().emergeSector(v2s16(p.X, p.Z));
+		MapBlock *block = sector->getBlockNoCreateNoEx(p.Y);
+		if (block) {
+			// Update an existing block
+			block->takeDeserializedData(*decoded.block);
+		} else {
+			block = decoded.block.get();
+			sector->insertBlock(std::move(decoded.block));
+		}
+
+		if (m_localdb)
+			m_localdb->saveBlock(block);
+
+		/*
+			Add it to mesh update queue and set it to be acknowledged after update.
+		*/
+		addUpdateMeshTaskWithEdge(p, true);
+	}
 }
 
 inline void Client::handleCommand(NetworkPacket* pkt)
@@ -1043,6 +1121,12 @@ void Client::ProcessData(NetworkPacket *pkt)
 		return;
 	}
 
+	// Node changes must not be overwritten by an older version of the
+	// block that is still being decoded
+	if (command == TOCLIENT_ADDNODE || command == TOCLIENT_REMOVENODE ||
+			command == TOCLIENT_NODEMETA_CHANGED)
+		applyDecodedBlocks(true);
+
 	handleCommand(pkt);
 }
 
@@ -1569,73 +1653,80 @@ void Client::addNode(v3s16 p, MapNode n, bool remove_metadata)
 		addUpdateMeshTaskWithEdge(modified_block.first, false, true);
 	}
 }
-std::vector<std::pair<v3s16, MapNode>> Client::getNodesAtBlockPos(v3s16 blockPos)
+void Client::updateAllMapBlocks()
 {
-	Map &map = m_env.getMap();
-	std::vector<std::pair<v3s16, MapNode>> nodes;
-	MapBlock *block = map.getBlockNoCreate(blockPos);
-	if (!block)
-		return nodes;
-
-	v3s16 relNodePos;
-	for (relNodePos.Z = 0; relNodePos.Z < MAP_BLOCKSIZE; ++relNodePos.Z)
-	for (relNodePos.Y = 0; relNodePos.Y < MAP_BLOCKSIZE; ++relNodePos.Y)
-	for (relNodePos.X = 0; relNodePos.X < MAP_BLOCKSIZE; ++relNodePos.X) {
-		v3s16 absoluteNodePos = blockPos * MAP_BLOCKSIZE + relNodePos;
-		bool is_valid_position;
-		MapNode node = CSMGetNode(absoluteNodePos, &is_valid_position);
-		
-		if (is_valid_position)
-			nodes.push_back(std::make_pair(absoluteNodePos, node));
-	}
-
-	return nodes;
+	// Invoked from a settings callback, make sure the mesh workers see
+	// the new values regardless of the callback order
+	SettingsSnapshot::refresh();
+	m_mesh_update_manager->updateFilter();
+	queueRemesh(nullptr);
 }
 
-std::vector<std::pair<v3s16, MapNode>> Client::getAllLoadedNodes()
+void Client::updateMeshFilter()
 {
-	Map &map = m_env.getMap();
-	std::vector<v3s16> blockPositions;
-	map.listAllLoadedBlocks(blockPositions);
-
-	std::vector<std::pair<v3s16, MapNode>> nodes;
-	for (const v3s16 &blockPos : blockPositions) {
-		MapBlock *block = map.getBlockNoCreate(blockPos);
-		if (!block)
-			continue;
-
-		v3s16 relNodePos;
-		for (relNodePos.Z = 0; relNodePos.Z < MAP_BLOCKSIZE; ++relNodePos.Z)
-		for (relNodePos.Y = 0; relNodePos.Y < MAP_BLOCKSIZE; ++relNodePos.Y)
-		for (relNodePos.X = 0; relNodePos.X < MAP_BLOCKSIZE; ++relNodePos.X) {
-			v3s16 absoluteNodePos = blockPos * MAP_BLOCKSIZE + relNodePos;
-			bool is_valid_position;
-			MapNode node = CSMGetNode(absoluteNodePos, &is_valid_position);
-			
-			if (is_valid_position)
-				nodes.push_back(std::make_pair(absoluteNodePos, node));
-		}
+	std::optional<ContentFilter> changed = m_mesh_update_manager->updateFilter();
+	if (!changed) {
+		// No meshes were built with a filter yet
+		queueRemesh(nullptr);
+	} else if (!changed->empty()) {
+		queueRemesh(&*changed);
 	}
-
-	return nodes;
 }
 
-void Client::updateAllMapBlocks()
+void Client::queueRemesh(const ContentFilter *changed)
 {
-	v3s16 currentBlock = getNodeBlockPos(floatToInt(m_env.getLocalPlayer()->getPosition(), BS));
-
-	for (s16 X = currentBlock.X - 2; X <= currentBlock.X + 2; X++)
-	for (s16 Y = currentBlock.Y - 2; Y <= currentBlock.Y + 2; Y++)
-	for (s16 Z = currentBlock.Z - 2; Z <= currentBlock.Z + 2; Z++)
-		addUpdateMeshTask(v3s16(X, Y, Z), false, true);
-
-	Map &map = m_env.getMap();
+	ClientMap &map = m_env.getClientMap();
+	const MeshGrid mesh_grid = getMeshGrid();
+	const v3s16 camera_block = getNodeBlockPos(
+			floatToInt(m_env.getLocalPlayer()->getPosition(), BS));
 
 	std::vector<v3s16> positions;
 	map.listAllLoadedBlocks(positions);
+	// Blocks still pending from a previous invalidation
+	positions.insert(positions.end(), m_remesh_backlog.begin(), m_remesh_backlog.end());
 
+	struct Candidate {
+		v3s16 p;
+		bool visible;
+		u32 distance_sq;
+	};
+	std::vector<Candidate> candidates;
+	std::unordered_set<v3s16> seen;
 	for (v3s16 p : positions) {
-		addUpdateMeshTask(p, false, false);
+		const v3s16 mesh_pos = mesh_grid.getMeshPos(p);
+		if (!seen.insert(mesh_pos).second)
+			continue;
+
+		// Skip meshes that are known not to contain any affected content
+		MapBlock *mesh_block = map.getBlockNoCreateNoEx(mesh_pos);
+		if (changed && mesh_block && !mesh_block->mesh_contents.empty() &&
+				std::none_of(mesh_block->mesh_contents.begin(),
+					mesh_block->mesh_contents.end(),
+					[&] (content_t c) { return changed->contains(c); }))
+			continue;
+
+		const v3s32 d = v3s32(mesh_pos.X, mesh_pos.Y, mesh_pos.Z) -
+				v3s32(camera_block.X, camera_block.Y, camera_block.Z);
+		candidates.push_back({p, map.isBlockInDrawList(mesh_pos),
+				(u32)d.getLengthSQ()});
+	}
+
+	// Least important first, so that the backlog can be consumed from the back
+	std::sort(candidates.begin(), candidates.end(),
+		[] (const Candidate &a, const Candidate &b) {
+			if (a.visible != b.visible)
+				return !a.visible;
+			return a.distance_sq > b.distance_sq;
+		});
+
+	m_remesh_backlog.clear();
+	m_remesh_backlog.reserve(candidates.size());
+	for (const Candidate &c : candidates) {
+		// Immediately update the blocks right around the player
+		if (c.distance_sq <= 3 * 2 * 2)
+			addUpdateMeshTask(c.p, false, true);
+		else
+			m_remesh_backlog.push_back(c.p);
 	}
 }
 
@@ -1970,6 +2061,7 @@ void Client::afterContentReceived()
 	// Start mesh update thread after setting up content definitions
 	infostream<<"- Starting mesh update thread"<<std::endl;
 	m_mesh_update_manager->start();
+	m_block_decoder->start();
 
 	m_state = LC_Ready;
 	sendReady();
@@ -39,7 +39,11 @@ class IWritableTextureSource;
 class MapBlockMesh;
 class MapDatabase;
 class MeshUpdateManager;
+class BlockDecoder;
+class LocalMapSaveThread;
+class ContentFilter;
 class Minimap;
+class CompactVertexFormat;
 class ModChannelMgr;
 class MtEventManager;
 class NetworkPacket;
@@ -265,10 +269,10 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 
 	void addNode(v3s16 p, MapNode n, bool remove_metadata = true);
 
-	std::vector<std::pair<v3s16, MapNode>> getAllLoadedNodes();
-	std::vector<std::pair<v3s16, MapNode>> getNodesAtBlockPos(v3s16 blockPos);
-
+	// Rebuilds the meshes of all loaded blocks, nearest and visible ones first
 	void updateAllMapBlocks();
+	// Rebuilds the meshes affected by a change of the X-Ray or node ESP filters
+	void updateMeshFilter();
 
 	void setPlayerControl(PlayerControl &control);
 
@@ -404,8 +408,9 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 
 	// The following set of functions is used by ClientMediaDownloader
 	// Insert a media file appropriately into the appropriate manager
+	// raw_hash is the SHA1 of data, if known
 	bool loadMedia(const std::string &data, const std::string &filename,
-		bool from_media_push = false);
+		bool from_media_push = false, const std::string &raw_hash = "");
 
 	// Send a request for conventional media transfer
 	void request_media(const std::vector<std::string> &file_requests);
@@ -460,6 +465,12 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 		return m_mesh_grid;
 	}
 
+	// nullptr if map block meshes use the regular vertex format
+	const CompactVertexFormat *getCompactVertexFormat() const
+	{
+		return m_compact_vertex_format.get();
+	}
+
 	bool inhibit_inventory_revert = false;
 	bool stop_running_menu = false;
 
@@ -473,6 +484,9 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 	void initLocalMapSaving(const Address &address, const std::string &hostname);
 
 	void ReceiveAll();
+	// Puts blocks from m_block_decoder into the map. With `wait`, this
+	// includes the blocks that are still being decoded.
+	void applyDecodedBlocks(bool wait);
 
 	void deleteAuthData();
 	// helper method shared with clientpackethandler
@@ -503,6 +517,7 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 
 
 	std::unique_ptr<MeshUpdateManager> m_mesh_update_manager;
+	std::unique_ptr<BlockDecoder> m_block_decoder;
 	ClientEnvironment m_env;
 	std::unique_ptr<ParticleManager> m_particle_manager;
 	std::unique_ptr<con::IConnection> m_con;
@@ -588,8 +603,16 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 	// own state
 	LocalClientState m_state;
 
+	// Queues mesh updates for all loaded blocks, or only for those containing
+	// content from `changed` if given
+	void queueRemesh(const ContentFilter *changed);
+
+	// Blocks waiting for a mesh update after a global invalidation,
+	// the most important one at the back
+	std::vector<v3s16> m_remesh_backlog;
+
 	// Used for saving server map to disk client-side
-	MapDatabase *m_localdb = nullptr;
+	std::unique_ptr<LocalMapSaveThread> m_localdb;
 	IntervalLimiter m_localdb_save_interval;
 	u16 m_cache_save_interval;
 
@@ -610,4 +633,5 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 
 	// The number of blocks the client will combine for mesh generation.
 	MeshGrid m_mesh_grid;
+	std::unique_ptr<CompactVertexFormat> m_compact_vertex_format;
 };
@@ -23,6 +23,7 @@
 #include "porting.h"
 #include <algorithm>
 #include "client/renderingengine.h"
+#include "client/settings_snapshot.h"
 
 /*
 	ClientEnvironment
@@ -248,7 +249,8 @@ void ClientEnvironment::step(float dtime)
 		v3s16 p = lplayer->getLightPosition();
 		node_at_lplayer = m_map->getNode(p);
 
-		u16 light = getInteriorLight(node_at_lplayer, 0, m_client->ndef());
+		u16 light = getInteriorLight(node_at_lplayer, 0, m_client->ndef(),
+				SettingsSnapshot::get()->fullbright);
 		lplayer->light_color = encode_light(light, 0); // this transfers light.alpha
 		final_color_blend(&lplayer->light_color, light, day_night_ratio);
 	}
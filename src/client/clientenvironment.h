@@ -115,6 +115,13 @@ class ClientEnvironment : public Environment
 		return m_ao_manager.getActiveObjects(origin, max_d, dest);
 	}
 
+	// Get all objects positioned inside the box
+	void getActiveObjectsInArea(const aabb3f &box,
+		std::vector<ClientActiveObject *> &dest)
+	{
+		return m_ao_manager.getActiveObjectsInArea(box, dest);
+	}
+
 	void getAllActiveObjects(const v3f &origin,
 		std::vector<DistanceSortedActiveObject> &dest)
 	{
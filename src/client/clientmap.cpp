@@ -18,10 +18,42 @@
 #include "util/basic_macros.h"
 #include "util/tracy_wrapper.h"
 #include "client/renderingengine.h"
+#include "client/meshgen/compact_vertex.h"
+#include "threading/thread.h"
+#include "threading/thread_pool.h"
 
 #include <queue>
 
 namespace {
+	// Output of one slice of sectors in the parallel parts of
+	// updateDrawList() and updateDrawListShadow()
+	struct DrawListSlice
+	{
+		std::vector<std::pair<v3s16, MapBlock *>> drawlist;
+		std::vector<MapBlock *> keeplist;
+		std::vector<v3s16> shortlist;
+		// New results for ClientMap::m_occlusion_cache
+		std::vector<std::pair<v3s16, bool>> occlusion_results;
+		u32 blocks_in_range_with_mesh = 0;
+		u32 blocks_frustum_culled = 0;
+		u32 blocks_occlusion_culled = 0;
+	};
+
+	// Splits `count` items into slices for the draw list pool
+	size_t get_slice_count(size_t count, size_t concurrency)
+	{
+		// A few slices per thread even out the uneven sector sizes
+		return std::min(count, concurrency * 4);
+	}
+
+	template <typename T>
+	std::pair<size_t, size_t> get_slice(const std::vector<T> &items,
+			size_t slice, size_t slice_count)
+	{
+		return {items.size() * slice / slice_count,
+				items.size() * (slice + 1) / slice_count};
+	}
+
 	// data structure that groups block meshes by material
 	struct MeshBufListMaps
 	{
@@ -93,18 +125,20 @@ namespace {
 
 	/// @brief Append vertices to a mesh buffer
 	/// @note does not update bounding box!
-	void appendToMeshBuffer(scene::SMeshBuffer *dst, const scene::IMeshBuffer *src, v3f translate)
+	/// @param translate called on each appended vertex to move it into place
+	template <typename T, typename F>
+	void appendToMeshBuffer(scene::CMeshBuffer<T> *dst, const scene::IMeshBuffer *src, F translate)
 	{
 		const size_t vcount = dst->Vertices->Data.size();
 		const size_t icount = dst->Indices->Data.size();
 
-		assert(src->getVertexType() == video::EVT_STANDARD);
-		const auto vptr = static_cast<const video::S3DVertex*>(src->getVertices());
+		assert(src->getVertexType() == T::getType());
+		const auto vptr = static_cast<const T*>(src->getVertices());
 		dst->Vertices->Data.insert(dst->Vertices->Data.end(),
 			vptr, vptr + src->getVertexCount());
 		// apply translation
 		for (size_t j = vcount; j < dst->Vertices->Data.size(); j++)
-			dst->Vertices->Data[j].Pos += translate;
+			translate(dst->Vertices->Data[j]);
 
 		const auto iptr = src->getIndices();
 		dst->Indices->Data.insert(dst->Indices->Data.end(),
@@ -132,6 +166,7 @@ void CachedMeshBuffer::drop()
 	for (auto *it : buf)
 		it->drop();
 	buf.clear();
+	pos.clear();
 }
 
 /*
@@ -164,9 +199,12 @@ ClientMap::ClientMap(
 		rendering_engine->get_scene_manager(), id),
 	m_client(client),
 	m_rendering_engine(rendering_engine),
-	m_control(control),
-	m_drawlist(MapBlockComparer(v3s16(0,0,0)))
+	m_control(control)
 {
+	// The calling thread does its share of the work
+	unsigned int drawlist_workers = MYMIN(8, Thread::getNumberOfProcessors() / 2);
+	m_drawlist_pool = std::make_unique<ThreadPool>(
+			drawlist_workers > 0 ? drawlist_workers - 1 : 0, "DrawList");
 
 	/*
 	 * @Liso: Sadly C++ doesn't have introspection, so the only way we have to know
@@ -211,6 +249,7 @@ ClientMap::~ClientMap()
 void ClientMap::updateCamera(v3f pos, v3f dir, f32 fov, v3s16 offset, video::SColor light_color)
 {
 	v3s16 previous_camera_offset = m_camera_offset;
+	v3f previous_position = m_camera_position;
 	v3s16 previous_node = floatToInt(m_camera_position, BS) + m_camera_offset;
 	v3s16 previous_block = getContainerPos(previous_node, MAP_BLOCKSIZE);
 
@@ -227,8 +266,10 @@ void ClientMap::updateCamera(v3f pos, v3f dir, f32 fov, v3s16 offset, video::SCo
 	if (previous_block != current_block)
 		m_needs_update_drawlist = true;
 
-	// reorder transparent meshes when camera crosses node boundary
-	if (previous_node != current_node)
+	// check the order of transparent meshes when the camera moves, the
+	// meshes only sort again if that changed their order
+	if (previous_position != m_camera_position ||
+			previous_camera_offset != m_camera_offset)
 		m_needs_update_transparent_meshes = true;
 
 	// drop merged mesh cache when camera offset changes
@@ -392,7 +433,7 @@ void ClientMap::updateDrawList()
 	}
 
 	const v3s16 camera_block = getContainerPos(cam_pos_nodes, MAP_BLOCKSIZE);
-	m_drawlist = decltype(m_drawlist)(MapBlockComparer(camera_block));
+	m_drawlist_order = MapBlockComparer(camera_block);
 
 	auto is_frustum_culled = m_client->getCamera()->getFrustumCuller();
 
@@ -414,8 +455,8 @@ void ClientMap::updateDrawList()
 		// Number of blocks with mesh in rendering range
 		u32 blocks_in_range_with_mesh = 0;
 
-		MapBlockVect sectorblocks;
-
+		std::vector<const MapSector *> sectors;
+		sectors.reserve(m_sectors.size());
 		for (auto &sector_it : m_sectors) {
 			const MapSector *sector = sector_it.second;
 			v2s16 sp = sector->getPos();
@@ -426,9 +467,27 @@ void ClientMap::updateDrawList()
 						sp.Y < p_blocks_min.Z || sp.Y > p_blocks_max.Z)
 					continue;
 			}
+			sectors.push_back(sector);
+		}
+
+		const bool test_occlusion = !m_control.range_all &&
+				occlusion_culling_enabled && m_enable_raytraced_culling;
+		if (test_occlusion)
+			prepareOcclusionCache(cam_pos_nodes);
 
+		// Sectors are independent, so slices of them are processed in parallel.
+		// Only the blocks of its own sectors may be modified by a slice.
+		const size_t slice_count = get_slice_count(sectors.size(),
+				m_drawlist_pool->getConcurrency());
+		std::vector<DrawListSlice> slices(slice_count);
+
+		m_drawlist_pool->run(slice_count, [&] (size_t slice_index) {
+			DrawListSlice &out = slices[slice_index];
+			auto [begin, end] = get_slice(sectors, slice_index, slice_count);
+
+			for (size_t i = begin; i < end; i++)
 			// Loop through blocks in sector
-			for (const auto &entry : sector->getBlocks()) {
+			for (const auto &entry : sectors[i]->getBlocks()) {
 				MapBlock *block = entry.second.get();
 				MapBlockMesh *mesh = block->mesh;
 
@@ -456,7 +515,7 @@ void ClientMap::updateDrawList()
 
 				// Keep the block alive as long as it is in range.
 				block->resetUsageTimer();
-				blocks_in_range_with_mesh++;
+				out.blocks_in_range_with_mesh++;
 
 				// Frustum culling
 				// Only do coarse culling here, to account for fast camera movement.
@@ -464,32 +523,53 @@ void ClientMap::updateDrawList()
 				float frustum_cull_extra_radius = 300.0f;
 				if (is_frustum_culled(mesh_sphere_center,
 						mesh_sphere_radius + frustum_cull_extra_radius)) {
-					blocks_frustum_culled++;
+					out.blocks_frustum_culled++;
 					continue;
 				}
 
 				// Raytraced occlusion culling - send rays from the camera to the block's corners
-				if (!m_control.range_all && occlusion_culling_enabled && m_enable_raytraced_culling &&
-						mesh &&
-						isMeshOccluded(block, mesh_grid.cell_size, cam_pos_nodes)) {
-					blocks_occlusion_culled++;
-					continue;
+				if (test_occlusion && mesh) {
+					// The cache is only read here and updated after all slices are done
+					bool occluded;
+					auto cached = m_occlusion_cache.find(block->getPos());
+					if (cached != m_occlusion_cache.end()) {
+						occluded = cached->second;
+					} else {
+						occluded = isMeshOccludedUncached(block, mesh_grid.cell_size, cam_pos_nodes);
+						out.occlusion_results.emplace_back(block->getPos(), occluded);
+					}
+					if (occluded) {
+						out.blocks_occlusion_culled++;
+						continue;
+					}
 				}
 
 				if (mesh_grid.cell_size > 1) {
 					// Block meshes are stored in the corner block of a chunk
 					// (where all coordinate are divisible by the chunk size)
 					// Add them to the de-dup set.
-					shortlist.emplace(mesh_grid.getMeshPos(block->getPos()));
+					out.shortlist.push_back(mesh_grid.getMeshPos(block->getPos()));
 					// All other blocks we can grab and add to the keeplist right away.
-					m_keeplist.push_back(block);
-					block->refGrab();
+					out.keeplist.push_back(block);
 				} else if (mesh) {
 					// without mesh chunking we can add the block to the drawlist
-					block->refGrab();
-					m_drawlist.emplace(block->getPos(), block);
+					out.drawlist.emplace_back(block->getPos(), block);
 				}
 			}
+		});
+
+		for (auto &slice : slices) {
+			blocks_in_range_with_mesh += slice.blocks_in_range_with_mesh;
+			blocks_frustum_culled += slice.blocks_frustum_culled;
+			blocks_occlusion_culled += slice.blocks_occlusion_culled;
+			m_drawlist.insert(m_drawlist.end(), slice.drawlist.begin(), slice.drawlist.end());
+			for (MapBlock *block : slice.keeplist) {
+				block->refGrab();
+				m_keeplist.push_back(block);
+			}
+			shortlist.insert(slice.shortlist.begin(), slice.shortlist.end());
+			m_occlusion_cache.insert(slice.occlusion_results.begin(),
+					slice.occlusion_results.end());
 		}
 
 		g_profiler->avg("MapBlock meshes in range [#]", blocks_in_range_with_mesh);
@@ -594,8 +674,7 @@ void ClientMap::updateDrawList()
 				}
 			} else if (mesh) {
 				// without mesh chunking we can add the block to the drawlist
-				block->refGrab();
-				m_drawlist.emplace(block_coord, block);
+				m_drawlist.emplace_back(block_coord, block);
 			}
 
 			// Decide which sides to traverse next or to block away
@@ -705,12 +784,18 @@ void ClientMap::updateDrawList()
 	assert(m_drawlist.empty() || shortlist.empty());
 	for (auto pos : shortlist) {
 		MapBlock *block = getBlockNoCreateNoEx(pos);
-		if (block) {
-			block->refGrab();
-			m_drawlist.emplace(pos, block);
-		}
+		if (block)
+			m_drawlist.emplace_back(pos, block);
 	}
 
+	// Sorted once instead of keeping an ordered container while collecting
+	std::sort(m_drawlist.begin(), m_drawlist.end(),
+			[this] (const auto &a, const auto &b) {
+				return m_drawlist_order(a.first, b.first);
+			});
+	for (auto &i : m_drawlist)
+		i.second->refGrab();
+
 	g_profiler->avg("MapBlocks occlusion culled [#]", blocks_occlusion_culled);
 	g_profiler->avg("MapBlocks frustum culled [#]", blocks_frustum_culled);
 	g_profiler->avg("MapBlocks drawn [#]", m_drawlist.size());
@@ -833,12 +918,14 @@ namespace {
  * @param dst draw order
  * @param get_world_pos returns translation for a buffer
  * @param dynamic_buffers cache structure for merged buffers
+ * @param compact_format format of buffers with compact vertices, if any
  * @return number of buffers that were merged
  */
 template <typename F>
 static u32 transformBuffersToDrawOrder(
 	const MeshBufListMaps::MeshBufList &src, DrawDescriptorList &draw_order,
-		F get_world_pos, CachedMeshBuffers &dynamic_buffers)
+		F get_world_pos, CachedMeshBuffers &dynamic_buffers,
+		const CompactVertexFormat *compact_format)
 {
 	/**
 	 * This is a tradeoff between time spent merging buffers and time spent
@@ -903,20 +990,27 @@ static u32 transformBuffersToDrawOrder(
 		buffer_transform_stats.increment(true);
 		const auto &use_mat = to_merge.front().second->getMaterial();
 		assert(!it2->second.buf.empty());
-		for (auto *buf : it2->second.buf) {
+		for (size_t i = 0; i < it2->second.buf.size(); i++) {
+			auto *buf = it2->second.buf[i];
 			// material is not part of the cache key, so make sure it still matches
 			buf->getMaterial() = use_mat;
-			draw_order.emplace_back(v3f(0), buf);
+			draw_order.emplace_back(it2->second.pos[i], buf);
 		}
 		it2->second.age = 0;
 	} else if (!key.empty()) {
 		buffer_transform_stats.increment(false);
 		// merge and save to cache
 		auto &put_buffers = dynamic_buffers[key];
-		scene::SMeshBuffer *tmp = nullptr;
+		scene::IMeshBuffer *tmp = nullptr;
+		/*
+		 * Regular vertices are translated to world space, so the merged buffer
+		 * is drawn at the origin. Compact vertices can't hold world positions,
+		 * so they are moved relative to the first buffer that was merged.
+		 */
+		v3f tmp_pos;
 		const auto &finish_buf = [&] () {
 			if (tmp) {
-				draw_order.emplace_back(v3f(0), tmp);
+				draw_order.emplace_back(tmp_pos, tmp);
 				total_vtx = subtract_or_zero(total_vtx, tmp->getVertexCount());
 				total_idx = subtract_or_zero(total_idx, tmp->getIndexCount());
 
@@ -932,23 +1026,50 @@ static u32 transformBuffersToDrawOrder(
 		for (auto &it : to_merge) {
 			v3f translate = it.first;
 			auto *buf = it.second;
+			const bool compact = buf->getVertexType() == video::EVT_COMPACT;
+			v3s32 steps;
 
 			bool new_buffer = false;
 			if (!tmp)
 				new_buffer = true;
+			else if (tmp->getVertexType() != buf->getVertexType())
+				new_buffer = true;
 			else if (tmp->getVertexCount() + buf->getVertexCount() > U16_MAX)
 				new_buffer = true;
+			else if (compact && !compact_format->getTranslationSteps(translate - tmp_pos, steps))
+				new_buffer = true;
 			if (new_buffer) {
 				finish_buf();
-				tmp = new scene::SMeshBuffer();
+				// preallocate approximately
+				const auto &preallocate = [&] (auto *dst) {
+					dst->Vertices->Data.reserve(MYMIN(U16_MAX, total_vtx));
+					dst->Indices->Data.reserve(total_idx);
+					return dst;
+				};
+				if (compact) {
+					assert(compact_format);
+					tmp = preallocate(new scene::SMeshBufferCompact());
+					tmp_pos = translate;
+					steps = v3s32(0);
+				} else {
+					tmp = preallocate(new scene::SMeshBuffer());
+					tmp_pos = v3f(0);
+				}
 				put_buffers.buf.push_back(tmp);
+				put_buffers.pos.push_back(tmp_pos);
 				assert(tmp->getPrimitiveType() == buf->getPrimitiveType());
-				tmp->Material = buf->getMaterial();
-				// preallocate approximately
-				tmp->Vertices->Data.reserve(MYMIN(U16_MAX, total_vtx));
-				tmp->Indices->Data.reserve(total_idx);
+				tmp->getMaterial() = buf->getMaterial();
+			}
+			if (compact) {
+				appendToMeshBuffer(static_cast<scene::SMeshBufferCompact*>(tmp), buf,
+					[&] (video::S3DVertexCompact &v) {
+						for (int i = 0; i < 3; i++)
+							v.Pos[i] += steps[i];
+					});
+			} else {
+				appendToMeshBuffer(static_cast<scene::SMeshBuffer*>(tmp), buf,
+					[&] (video::S3DVertex &v) { v.Pos += translate; });
 			}
-			appendToMeshBuffer(tmp, buf, translate);
 		}
 		finish_buf();
 		assert(!put_buffers.buf.empty());
@@ -1064,7 +1185,8 @@ void ClientMap::renderMap(video::IVideoDriver* driver, s32 pass)
 	for (auto &map : grouped_buffers.maps) {
 		for (auto &list : map) {
 			merged_count += transformBuffersToDrawOrder(
-				list.second, draw_order, get_block_wpos, m_dynamic_buffers);
+				list.second, draw_order, get_block_wpos, m_dynamic_buffers,
+				m_client->getCompactVertexFormat());
 		}
 	}
 
@@ -1452,7 +1574,8 @@ void ClientMap::renderMapShadows(video::IVideoDriver *driver,
 	for (auto &map : grouped_buffers.maps) {
 		for (auto &list : map) {
 			transformBuffersToDrawOrder(
-				list.second, draw_order, get_block_wpos, m_dynamic_buffers);
+				list.second, draw_order, get_block_wpos, m_dynamic_buffers,
+				m_client->getCompactVertexFormat());
 		}
 	}
 
@@ -1537,16 +1660,30 @@ void ClientMap::updateDrawListShadow(v3f shadow_light_pos, v3f shadow_light_dir,
 	// Number of blocks with mesh in rendering range
 	u32 blocks_in_range_with_mesh = 0;
 
+	std::vector<const MapSector *> sectors;
+	sectors.reserve(m_sectors.size());
 	for (auto &sector_it : m_sectors) {
 		const MapSector *sector = sector_it.second;
 		if (!sector)
 			continue;
 		blocks_loaded += sector->size();
+		sectors.push_back(sector);
+	}
+
+	// See updateDrawList()
+	const size_t slice_count = get_slice_count(sectors.size(),
+			m_drawlist_pool->getConcurrency());
+	std::vector<DrawListSlice> slices(slice_count);
+
+	m_drawlist_pool->run(slice_count, [&] (size_t slice_index) {
+		DrawListSlice &out = slices[slice_index];
+		auto [begin, end] = get_slice(sectors, slice_index, slice_count);
 
+		for (size_t i = begin; i < end; i++)
 		/*
 			Loop through blocks in sector
 		*/
-		for (const auto &entry : sector->getBlocks()) {
+		for (const auto &entry : sectors[i]->getBlocks()) {
 			MapBlock *block = entry.second.get();
 			MapBlockMesh *mesh = block->mesh;
 			if (!mesh) {
@@ -1559,18 +1696,27 @@ void ClientMap::updateDrawListShadow(v3f shadow_light_pos, v3f shadow_light_dir,
 			if (projection.getDistanceFrom(block_pos) > (radius + mesh->getBoundingRadius()))
 				continue;
 
-			blocks_in_range_with_mesh++;
+			out.blocks_in_range_with_mesh++;
 
 			// This block is in range. Reset usage timer.
 			block->resetUsageTimer();
 
-			// Add to set
-			if (m_drawlist_shadow.emplace(block->getPos(), block).second) {
-				block->refGrab();
-			}
+			out.drawlist.emplace_back(block->getPos(), block);
 		}
+	});
+
+	for (auto &slice : slices) {
+		blocks_in_range_with_mesh += slice.blocks_in_range_with_mesh;
+		m_drawlist_shadow.insert(m_drawlist_shadow.end(),
+				slice.drawlist.begin(), slice.drawlist.end());
 	}
 
+	// Keep the order stable between updates, the list is drawn in parts
+	std::sort(m_drawlist_shadow.begin(), m_drawlist_shadow.end(),
+			[] (const auto &a, const auto &b) { return a.first < b.first; });
+	for (auto &i : m_drawlist_shadow)
+		i.second->refGrab();
+
 	g_profiler->avg("SHADOW MapBlock meshes in range [#]", blocks_in_range_with_mesh);
 	g_profiler->avg("SHADOW MapBlocks drawn [#]", m_drawlist_shadow.size());
 	g_profiler->avg("SHADOW MapBlocks loaded [#]", blocks_loaded);
@@ -1585,10 +1731,14 @@ void ClientMap::updateTransparentMeshBuffers()
 {
 	ScopeProfiler sp(g_profiler, "CM::updateTransparentMeshBuffers", SPT_AVG);
 	u32 sorted_blocks = 0;
+	u32 reused_blocks = 0;
 	u32 unsorted_blocks = 0;
 	bool transparency_sorting_enabled = m_cache_transparency_sorting_distance > 0;
 	f32 sorting_distance = m_cache_transparency_sorting_distance * BS;
 
+	// Meshes to sort, along with their block position
+	std::vector<std::pair<MapBlockMesh *, v3s16>> to_sort;
+
 	// Update the order of transparent mesh buffers in each mesh
 	for (auto it = m_drawlist.begin(); it != m_drawlist.end(); it++) {
 		MapBlock *block = it->second;
@@ -1611,9 +1761,7 @@ void ClientMap::updateTransparentMeshBuffers()
 			}
 
 			if (do_sort_block) {
-				blockmesh->updateTransparentBuffers(m_camera_position, block->getPos(),
-						m_cache_transparency_sorting_group_by_buffers);
-				++sorted_blocks;
+				to_sort.emplace_back(blockmesh, block->getPos());
 			} else {
 				blockmesh->consolidateTransparentBuffers();
 				++unsorted_blocks;
@@ -1621,7 +1769,32 @@ void ClientMap::updateTransparentMeshBuffers()
 		}
 	}
 
+	// Sorting only touches the mesh itself, so meshes are sorted in parallel.
+	// Most of them keep their order, since the camera rarely crosses one of
+	// the planes of their BSP tree.
+	std::vector<u8> changed(to_sort.size(), 0);
+	const size_t slice_count = get_slice_count(to_sort.size(),
+			m_drawlist_pool->getConcurrency());
+	m_drawlist_pool->run(slice_count, [&] (size_t slice_index) {
+		auto [begin, end] = get_slice(to_sort, slice_index, slice_count);
+		for (size_t i = begin; i < end; i++) {
+			changed[i] = to_sort[i].first->sortTransparentTriangles(m_camera_position,
+					to_sort[i].second, m_cache_transparency_sorting_group_by_buffers);
+		}
+	});
+
+	// Index buffers are Irrlicht objects, so they are replaced here
+	for (size_t i = 0; i < to_sort.size(); i++) {
+		if (changed[i]) {
+			to_sort[i].first->applyTransparentOrder();
+			++sorted_blocks;
+		} else {
+			++reused_blocks;
+		}
+	}
+
 	g_profiler->avg("CM::Transparent Buffers - Sorted", sorted_blocks);
+	g_profiler->avg("CM::Transparent Buffers - Reused", reused_blocks);
 	g_profiler->avg("CM::Transparent Buffers - Unsorted", unsorted_blocks);
 	m_needs_update_transparent_meshes = false;
 }
@@ -1642,7 +1815,88 @@ u32 DrawDescriptor::draw(video::IVideoDriver* driver)
 	}
 }
 
+bool ClientMap::isOccluded(const v3s16 pos_camera, const v3s16 pos_target,
+	float step, float stepfac, float offset, float end_offset, u32 needed_count)
+{
+	v3f direction = intToFloat(pos_target - pos_camera, BS);
+	float distance = direction.getLength();
+
+	// Normalize direction vector
+	if (distance > 0.0f)
+		direction /= distance;
+
+	v3f pos_origin_f = intToFloat(pos_camera, BS);
+	u32 count = 0;
+
+	// Consecutive samples mostly fall into the same block
+	v3s16 last_blockpos(S16_MAX, S16_MAX, S16_MAX);
+	MapBlock *last_block = nullptr;
+
+	for (; offset < distance + end_offset; offset += step) {
+		v3f pos_node_f = pos_origin_f + direction * offset;
+		v3s16 pos_node = floatToInt(pos_node_f, BS);
+		step *= stepfac;
+
+		v3s16 blockpos = getNodeBlockPos(pos_node);
+		if (blockpos != last_blockpos) {
+			last_blockpos = blockpos;
+			last_block = findBlock(blockpos);
+		}
+		if (!last_block)
+			continue;
+
+		v3s16 rel = pos_node - last_block->getPosRelative();
+		bool opaque;
+		if (last_block->opacity) {
+			opaque = last_block->opacity->isOpaque(rel);
+		} else {
+			// Not meshed yet
+			MapNode node = last_block->getNodeNoCheck(rel);
+			opaque = !m_nodedef->getLightingFlags(node).light_propagates;
+		}
+
+		if (opaque) {
+			// Cannot see through light-blocking nodes --> occluded
+			count++;
+			if (count >= needed_count)
+				return true;
+		}
+	}
+	return false;
+}
+
+MapBlock *ClientMap::findBlock(v3s16 p) const
+{
+	auto sector_it = m_sectors.find(v2s16(p.X, p.Z));
+	if (sector_it == m_sectors.end())
+		return nullptr;
+	const MapSector *sector = sector_it->second;
+	auto it = sector->getBlocks().find(p.Y);
+	return it != sector->getBlocks().end() ? it->second.get() : nullptr;
+}
+
+void ClientMap::prepareOcclusionCache(v3s16 cam_pos_nodes)
+{
+	if (cam_pos_nodes != m_occlusion_cache_camera) {
+		m_occlusion_cache.clear();
+		m_occlusion_cache_camera = cam_pos_nodes;
+	}
+}
+
 bool ClientMap::isMeshOccluded(MapBlock *mesh_block, u16 mesh_size, v3s16 cam_pos_nodes)
+{
+	prepareOcclusionCache(cam_pos_nodes);
+
+	auto it = m_occlusion_cache.find(mesh_block->getPos());
+	if (it != m_occlusion_cache.end())
+		return it->second;
+
+	bool occluded = isMeshOccludedUncached(mesh_block, mesh_size, cam_pos_nodes);
+	m_occlusion_cache.emplace(mesh_block->getPos(), occluded);
+	return occluded;
+}
+
+bool ClientMap::isMeshOccludedUncached(MapBlock *mesh_block, u16 mesh_size, v3s16 cam_pos_nodes)
 {
 	if (mesh_size == 1)
 		return isBlockOccluded(mesh_block, cam_pos_nodes);
@@ -1682,7 +1936,7 @@ bool ClientMap::isMeshOccluded(MapBlock *mesh_block, u16 mesh_size, v3s16 cam_po
 				if (mesh_block->getPos() == block_pos)
 					block = mesh_block;
 				else
-					block = getBlockNoCreateNoEx(block_pos);
+					block = findBlock(block_pos);
 
 				if (block && !isBlockOccluded(block, cam_pos_nodes))
 					return false;
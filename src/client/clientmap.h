@@ -7,8 +7,11 @@
 #include "irrlichttypes_bloated.h"
 #include "map.h"
 #include "camera.h"
+#include <algorithm>
+#include <memory>
 #include <set>
 #include <map>
+#include <unordered_map>
 
 struct MapDrawControl
 {
@@ -25,6 +28,7 @@ struct MapDrawControl
 class Client;
 class ITextureSource;
 class PartialMeshBuffer;
+class ThreadPool;
 
 namespace irr::scene
 {
@@ -38,6 +42,8 @@ namespace irr::video
 
 struct CachedMeshBuffer {
 	std::vector<scene::IMeshBuffer*> buf;
+	// World translation to draw each buffer with, same order as buf
+	std::vector<v3f> pos;
 	u8 age = 0;
 
 	void drop();
@@ -93,6 +99,15 @@ class ClientMap : public Map, public scene::ISceneNode
 	// @brief Calculate statistics about the map and keep the blocks alive
 	void touchMapBlocks();
 	void updateDrawListShadow(v3f shadow_light_pos, v3f shadow_light_dir, float radius, float length);
+	// Returns true if the mesh at the given mesh position is currently drawn
+	bool isBlockInDrawList(v3s16 mesh_pos) const
+	{
+		auto it = std::lower_bound(m_drawlist.begin(), m_drawlist.end(), mesh_pos,
+				[this] (const auto &entry, v3s16 pos) {
+					return m_drawlist_order(entry.first, pos);
+				});
+		return it != m_drawlist.end() && it->first == mesh_pos;
+	}
 	// Returns true if draw list needs updating before drawing the next frame.
 	bool needsUpdateDrawList() { return m_needs_update_drawlist; }
 	void renderMap(video::IVideoDriver* driver, s32 pass);
@@ -107,6 +122,10 @@ class ClientMap : public Map, public scene::ISceneNode
 
 	void invalidateMapBlockMesh(MapBlockMesh *mesh);
 
+	// Drops the cached occlusion test results, e.g. after the opacity of
+	// blocks changed
+	void invalidateOcclusionCache() { m_occlusion_cache.clear(); }
+
 	// For debug printing
 	void PrintInfo(std::ostream &out) override;
 
@@ -121,8 +140,25 @@ class ClientMap : public Map, public scene::ISceneNode
 	virtual ~ClientMap();
 
 	void reportMetrics(u64 save_time_us, u32 saved_blocks, u32 all_blocks) override;
+
+	// Walks the ray like Map::isOccluded, but reads the opacity masks that
+	// the mesh workers computed instead of nodes and definitions.
+	// Safe to call from several threads as long as the map is not modified.
+	bool isOccluded(v3s16 pos_camera, v3s16 pos_target,
+		float step, float stepfac, float start_offset, float end_offset,
+		u32 needed_count) override;
 private:
+	// Results are cached until the camera moves to another node or
+	// invalidateOcclusionCache() is called
 	bool isMeshOccluded(MapBlock *mesh_block, u16 mesh_size, v3s16 cam_pos_nodes);
+	// Thread-safe like isOccluded()
+	bool isMeshOccludedUncached(MapBlock *mesh_block, u16 mesh_size, v3s16 cam_pos_nodes);
+	// Drops the cached occlusion results if the camera moved
+	void prepareOcclusionCache(v3s16 cam_pos_nodes);
+
+	// Like getBlockNoCreateNoEx, but without touching the lookup caches of
+	// the map and sectors, so it is safe to call from several threads
+	MapBlock *findBlock(v3s16 p) const;
 
 	// update the vertex order in transparent mesh buffers
 	void updateTransparentMeshBuffers();
@@ -159,9 +195,14 @@ class ClientMap : public Map, public scene::ISceneNode
 	video::SColor m_camera_light_color = video::SColor(0xFFFFFFFF);
 	bool m_needs_update_transparent_meshes = true;
 
-	std::map<v3s16, MapBlock*, MapBlockComparer> m_drawlist;
+	// Sorted with m_drawlist_order, i.e. from far to near
+	std::vector<std::pair<v3s16, MapBlock*>> m_drawlist;
+	MapBlockComparer m_drawlist_order {v3s16(0, 0, 0)};
 	std::vector<MapBlock*> m_keeplist;
-	std::map<v3s16, MapBlock*> m_drawlist_shadow;
+	// Sorted by position
+	std::vector<std::pair<v3s16, MapBlock*>> m_drawlist_shadow;
+	// Builds the draw lists in parallel
+	std::unique_ptr<ThreadPool> m_drawlist_pool;
 	bool m_needs_update_drawlist;
 	CachedMeshBuffers m_dynamic_buffers;
 
@@ -173,4 +214,8 @@ class ClientMap : public Map, public scene::ISceneNode
 
 	bool m_loops_occlusion_culler;
 	bool m_enable_raytraced_culling;
+
+	// Occlusion results by mesh position, for m_occlusion_cache_camera
+	std::unordered_map<v3s16, bool> m_occlusion_cache;
+	v3s16 m_occlusion_cache_camera;
 };
@@ -11,10 +11,13 @@
 #include "log.h"
 #include "porting.h"
 #include "settings.h"
+#include "threading/thread.h"
+#include "threading/thread_pool.h"
 #include "util/hex.h"
 #include "util/serialize.h"
 #include "util/hashing.h"
 #include "util/string.h"
+#include <cstring>
 #include <sstream>
 
 static std::string getMediaCacheDir()
@@ -62,9 +65,9 @@ ClientMediaDownloader::~ClientMediaDownloader()
 }
 
 bool ClientMediaDownloader::loadMedia(Client *client, const std::string &data,
-		const std::string &name)
+		const std::string &name, const std::string &sha1)
 {
-	return client->loadMedia(data, name);
+	return client->loadMedia(data, name, false, sha1);
 }
 
 void ClientMediaDownloader::addFile(const std::string &name, const std::string &sha1)
@@ -179,30 +182,9 @@ std::string ClientMediaDownloader::makeReferer(Client *client)
 
 void ClientMediaDownloader::initialStep(Client *client)
 {
-	std::wstring loading_text = wstrgettext("Media...");
-	// Tradeoff between responsiveness during media loading and media loading speed
-	const u64 chunk_time_ms = 33;
-	u64 last_time = porting::getTimeMs();
-
 	// Check media cache
 	m_uncached_count = m_files.size();
-	for (auto &file_it : m_files) {
-		const std::string &name = file_it.first;
-		FileStatus *filestatus = file_it.second;
-		const std::string &sha1 = filestatus->sha1;
-
-		if (tryLoadFromCache(name, sha1, client)) {
-			filestatus->received = true;
-			m_uncached_count--;
-		}
-
-		u64 cur_time = porting::getTimeMs();
-		u64 dtime = porting::getDeltaMs(last_time, cur_time);
-		if (dtime >= chunk_time_ms) {
-			client->drawLoadScreen(loading_text, dtime / 1000.0f, 30);
-			last_time = cur_time;
-		}
-	}
+	loadFromCache(client);
 
 	assert(m_uncached_received_count == 0);
 
@@ -277,6 +259,87 @@ void ClientMediaDownloader::initialStep(Client *client)
 	}
 }
 
+void ClientMediaDownloader::loadFromCache(Client *client)
+{
+	std::wstring loading_text = wstrgettext("Media...");
+	// Tradeoff between responsiveness during media loading and media loading speed
+	const u64 chunk_time_ms = 33;
+	u64 last_time = porting::getTimeMs();
+
+	const bool use_index = g_settings->getBool("trust_media_cache_index");
+	MediaCacheIndex index(m_media_cache.getPath(MTCACHEINDEX_FILE_NAME));
+	if (use_index)
+		index.load();
+
+	struct CachedFile {
+		const std::string *name;
+		FileStatus *filestatus;
+		bool found;
+		u64 size, mtime;
+		std::string data;
+		std::string data_sha1;
+	};
+
+	// Reading and hashing the files is spread over several threads, only
+	// loading them into the client happens here. Files are handled in
+	// batches to keep the loading screen going and to not hold all media
+	// in memory at once.
+	ThreadPool pool(MYMIN(7U, MYMAX(1U, Thread::getNumberOfProcessors()) - 1),
+			"MediaCache");
+	const size_t batch_size = 256;
+	std::vector<CachedFile> batch;
+	batch.reserve(batch_size);
+
+	auto file_it = m_files.begin();
+	while (file_it != m_files.end()) {
+		batch.clear();
+		for (; file_it != m_files.end() && batch.size() < batch_size; ++file_it) {
+			CachedFile &file = batch.emplace_back();
+			file.name = &file_it->first;
+			file.filestatus = file_it->second;
+		}
+
+		pool.run(batch.size(), [&] (size_t i) {
+			CachedFile &file = batch[i];
+			const std::string &sha1 = file.filestatus->sha1;
+			std::string path = m_media_cache.getPath(hex_encode(sha1));
+			file.found = fs::GetFileInfo(path, file.size, file.mtime) &&
+					fs::ReadFile(path, file.data);
+			if (!file.found)
+				return;
+			if (use_index && index.isVerified(sha1, file.size, file.mtime))
+				file.data_sha1 = sha1;
+			else
+				file.data_sha1 = hashing::sha1(file.data);
+		});
+
+		for (CachedFile &file : batch) {
+			FileStatus *filestatus = file.filestatus;
+			if (file.found && checkAndLoad(*file.name, filestatus->sha1,
+					file.data, true, client, &file.data_sha1)) {
+				filestatus->received = true;
+				m_uncached_count--;
+				if (use_index)
+					index.setVerified(filestatus->sha1, file.size, file.mtime);
+			} else if (use_index) {
+				index.forget(filestatus->sha1);
+			}
+			// Not needed anymore
+			file.data = std::string();
+
+			u64 cur_time = porting::getTimeMs();
+			u64 dtime = porting::getDeltaMs(last_time, cur_time);
+			if (dtime >= chunk_time_ms) {
+				client->drawLoadScreen(loading_text, dtime / 1000.0f, 30);
+				last_time = cur_time;
+			}
+		}
+	}
+
+	if (use_index)
+		index.save();
+}
+
 void ClientMediaDownloader::remoteHashSetReceived(
 		const HTTPFetchResult &fetch_result)
 {
@@ -533,14 +596,15 @@ bool IClientMediaDownloader::tryLoadFromCache(const std::string &name,
 
 bool IClientMediaDownloader::checkAndLoad(
 		const std::string &name, const std::string &sha1,
-		const std::string &data, bool is_from_cache, Client *client)
+		const std::string &data, bool is_from_cache, Client *client,
+		const std::string *known_sha1)
 {
 	const char *cached_or_received = is_from_cache ? "cached" : "received";
 	const char *cached_or_received_uc = is_from_cache ? "Cached" : "Received";
 	std::string sha1_hex = hex_encode(sha1);
 
 	// Compute actual checksum of data
-	std::string data_sha1 = hashing::sha1(data);
+	std::string data_sha1 = known_sha1 ? *known_sha1 : hashing::sha1(data);
 
 	// Check that received file matches announced checksum
 	if (data_sha1 != sha1) {
@@ -554,7 +618,7 @@ bool IClientMediaDownloader::checkAndLoad(
 	}
 
 	// Checksum is ok, try loading the file
-	bool success = loadMedia(client, data, name);
+	bool success = loadMedia(client, data, name, sha1);
 	if (!success) {
 		infostream << "Client: "
 			<< "Failed to load " << cached_or_received << " media: "
@@ -618,6 +682,95 @@ void ClientMediaDownloader::deSerializeHashSet(const std::string &data,
 	}
 }
 
+/*
+	Media Cache Index File Format
+
+	All values are stored in big-endian byte order.
+	[u32] signature: 'MTCI'
+	[u16] version: 2
+	For each verified file:
+		[u8*20] SHA1 hash
+		[u64] file size
+		[u64] modification time, as returned by fs::GetFileInfo
+
+	Version changes:
+	1 - Initial version
+	2 - Modification times in nanoseconds on POSIX systems
+*/
+
+static constexpr u16 MTCACHEINDEX_FILE_VERSION = 2;
+
+bool MediaCacheIndex::load()
+{
+	m_entries.clear();
+	m_changed = false;
+
+	std::string data;
+	if (!fs::ReadFile(m_path, data))
+		return false;
+
+	const size_t entry_size = 20 + 8 + 8;
+	if (data.size() < 6 || (data.size() - 6) % entry_size != 0 ||
+			readU32((const u8 *)&data[0]) != MTCACHEINDEX_FILE_SIGNATURE ||
+			readU16((const u8 *)&data[4]) != MTCACHEINDEX_FILE_VERSION) {
+		infostream << "Client: Ignoring invalid media cache index" << std::endl;
+		return false;
+	}
+
+	m_entries.reserve((data.size() - 6) / entry_size);
+	for (size_t pos = 6; pos < data.size(); pos += entry_size) {
+		const u8 *entry = (const u8 *)&data[pos];
+		m_entries[data.substr(pos, 20)] = { readU64(entry + 20), readU64(entry + 28) };
+	}
+	return true;
+}
+
+bool MediaCacheIndex::save()
+{
+	if (!m_changed)
+		return true;
+
+	std::string data(6 + m_entries.size() * (20 + 8 + 8), '\0');
+	u8 *ptr = (u8 *)&data[0];
+	writeU32(ptr, MTCACHEINDEX_FILE_SIGNATURE);
+	writeU16(ptr + 4, MTCACHEINDEX_FILE_VERSION);
+	ptr += 6;
+	for (const auto &it : m_entries) {
+		memcpy(ptr, it.first.data(), 20);
+		writeU64(ptr + 20, it.second.size);
+		writeU64(ptr + 28, it.second.mtime);
+		ptr += 20 + 8 + 8;
+	}
+
+	if (!fs::safeWriteToFile(m_path, data))
+		return false;
+	m_changed = false;
+	return true;
+}
+
+bool MediaCacheIndex::isVerified(const std::string &sha1, u64 size, u64 mtime) const
+{
+	auto it = m_entries.find(sha1);
+	return it != m_entries.end() &&
+			it->second.size == size && it->second.mtime == mtime;
+}
+
+void MediaCacheIndex::setVerified(const std::string &sha1, u64 size, u64 mtime)
+{
+	assert(sha1.size() == 20);
+	auto [it, inserted] = m_entries.try_emplace(sha1, Entry{ size, mtime });
+	if (inserted || it->second.size != size || it->second.mtime != mtime) {
+		it->second = { size, mtime };
+		m_changed = true;
+	}
+}
+
+void MediaCacheIndex::forget(const std::string &sha1)
+{
+	if (m_entries.erase(sha1) > 0)
+		m_changed = true;
+}
+
 /*
 	SingleMediaDownloader
 */
@@ -635,9 +788,9 @@ SingleMediaDownloader::~SingleMediaDownloader()
 }
 
 bool SingleMediaDownloader::loadMedia(Client *client, const std::string &data,
-		const std::string &name)
+		const std::string &name, const std::string &sha1)
 {
-	return client->loadMedia(data, name, true);
+	return client->loadMedia(data, name, true, sha1);
 }
 
 void SingleMediaDownloader::addFile(const std::string &name, const std::string &sha1)
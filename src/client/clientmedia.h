@@ -18,6 +18,9 @@ struct HTTPFetchResult;
 #define MTHASHSET_FILE_SIGNATURE 0x4d544853 // 'MTHS'
 #define MTHASHSET_FILE_NAME "index.mth"
 
+#define MTCACHEINDEX_FILE_SIGNATURE 0x4d544349 // 'MTCI'
+#define MTCACHEINDEX_FILE_NAME "index.mtci"
+
 // Store file into media cache (unless it exists already)
 // Caller should check the hash.
 // return true if something was updated
@@ -28,6 +31,39 @@ bool clientMediaUpdateCache(const std::string &raw_hash,
 bool clientMediaUpdateCacheCopy(const std::string &raw_hash,
 	const std::string &path);
 
+/*
+	Remembers the size and modification time of media cache files whose
+	checksum was verified, so they don't need to be hashed again as long as
+	both stay the same.
+*/
+class MediaCacheIndex
+{
+public:
+	MediaCacheIndex(const std::string &path) : m_path(path) {}
+
+	// Returns false if the index file is missing or broken
+	bool load();
+	bool save();
+
+	// Whether the cache file of the raw hash `sha1` was verified before
+	// and still has the given size and modification time.
+	// Safe to call from several threads at once.
+	bool isVerified(const std::string &sha1, u64 size, u64 mtime) const;
+	void setVerified(const std::string &sha1, u64 size, u64 mtime);
+	// Drops the entry of a file that is gone or turned out to be broken
+	void forget(const std::string &sha1);
+
+private:
+	struct Entry {
+		u64 size;
+		u64 mtime;
+	};
+
+	std::string m_path;
+	std::unordered_map<std::string, Entry> m_entries;
+	bool m_changed = false;
+};
+
 // more of a base class than an interface but this name was most convenient...
 class IClientMediaDownloader
 {
@@ -68,13 +104,15 @@ class IClientMediaDownloader
 
 	// Forwards the call to the appropriate Client method
 	virtual bool loadMedia(Client *client, const std::string &data,
-		const std::string &name) = 0;
+		const std::string &name, const std::string &sha1) = 0;
 
 	bool tryLoadFromCache(const std::string &name, const std::string &sha1,
 			Client *client);
 
+	// `known_sha1` can point to the checksum of `data` if it is known already
 	bool checkAndLoad(const std::string &name, const std::string &sha1,
-			const std::string &data, bool is_from_cache, Client *client);
+			const std::string &data, bool is_from_cache, Client *client,
+			const std::string *known_sha1 = nullptr);
 
 	// Filesystem-based media cache
 	FileCache m_media_cache;
@@ -117,7 +155,7 @@ class ClientMediaDownloader : public IClientMediaDownloader
 
 protected:
 	bool loadMedia(Client *client, const std::string &data,
-			const std::string &name) override;
+			const std::string &name, const std::string &sha1) override;
 
 	static std::string makeReferer(Client *client);
 
@@ -135,6 +173,8 @@ class ClientMediaDownloader : public IClientMediaDownloader
 	};
 
 	void initialStep(Client *client);
+	// Loads the announced files that are in the media cache
+	void loadFromCache(Client *client);
 	void remoteHashSetReceived(const HTTPFetchResult &fetch_result);
 	void remoteMediaReceived(const HTTPFetchResult &fetch_result,
 			Client *client);
@@ -207,7 +247,7 @@ class SingleMediaDownloader : public IClientMediaDownloader
 
 protected:
 	bool loadMedia(Client *client, const std::string &data,
-			const std::string &name) override;
+			const std::string &name, const std::string &sha1) override;
 
 private:
 	void initialStep(Client *client);
@@ -34,6 +34,7 @@
 #include <cmath>
 #include "client/shader.h"
 #include "client/minimap.h"
+#include "client/settings_snapshot.h"
 #include <quaternion.h>
 #include <SMesh.h>
 #include <IMeshBuffer.h>
@@ -835,6 +836,7 @@ void GenericCAO::updateLight(u32 day_night_ratio)
 	u16 light_at_pos = 0;
 	u8 light_at_pos_intensity = 0;
 	bool pos_ok = false;
+	const bool fullbright = SettingsSnapshot::get()->fullbright;
 
 	v3s16 pos[3];
 	u16 npos = getLightPosition(pos);
@@ -843,7 +845,7 @@ void GenericCAO::updateLight(u32 day_night_ratio)
 		MapNode n = m_env->getMap().getNode(pos[i], &this_ok);
 		if (this_ok) {
 			// Get light level at the position plus the entity glow
-			u16 this_light = getInteriorLight(n, m_prop.glow, m_client->ndef());
+			u16 this_light = getInteriorLight(n, m_prop.glow, m_client->ndef(), fullbright);
 			u8 this_light_intensity = MYMAX(this_light & 0xFF, this_light >> 8);
 			if (this_light_intensity > light_at_pos_intensity) {
 				light_at_pos = this_light;
@@ -860,9 +862,9 @@ void GenericCAO::updateLight(u32 day_night_ratio)
 	// Encode light into color, adding a small boost
 	// based on the entity glow.
 	light = encode_light(light_at_pos, m_prop.glow);
-	
-	if (g_settings->getBool("fullbright"))
-	light = video::SColor(0xFFFFFFFF);
+
+	if (fullbright)
+		light = video::SColor(0xFFFFFFFF);
 
 	if (light != m_last_light) {
 		m_last_light = light;
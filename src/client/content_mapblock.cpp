@@ -218,9 +218,13 @@ enum class QuadDiagonal {
 //  face_lighter(int face, video::S3DVertex vertices[4]) -> QuadDiagonal -
 //              a callback that will be called for each face drawn to setup vertex colors,
 //              and to choose diagonal to split the quad at.
+//  merge_faces - faces that can be merged with their neighbors are passed to
+//              addGreedyFace instead of being drawn right away. Only valid for
+//              full node cuboids.
 template <typename Fn>
 void MapblockMeshGenerator::drawCuboid(const aabb3f &box,
-		const TileSpec *tiles, int tilecount, const f32 *txc, u8 mask, Fn &&face_lighter)
+		const TileSpec *tiles, int tilecount, const f32 *txc, u8 mask, Fn &&face_lighter,
+		bool merge_faces)
 {
 	assert(tilecount >= 1 && tilecount <= 6); // pre-condition
 
@@ -232,6 +236,8 @@ void MapblockMeshGenerator::drawCuboid(const aabb3f &box,
 		QuadDiagonal diagonal = face_lighter(k, &vertices[4 * k]);
 		const u16 *indices = diagonal == QuadDiagonal::Diag13 ? quad_indices_13 : quad_indices_02;
 		int tileindex = MYMIN(k, tilecount - 1);
+		if (merge_faces && addGreedyFace(k, tiles[tileindex], &vertices[4 * k]))
+			continue;
 		collector->append(tiles[tileindex], &vertices[4 * k], 4, indices, 6);
 	}
 }
@@ -392,7 +398,7 @@ void MapblockMeshGenerator::drawAutoLightedCuboid(aabb3f box,
 	}
 }
 
-void MapblockMeshGenerator::drawSolidNode(std::set<content_t> xraySet)
+void MapblockMeshGenerator::drawSolidNode(const ContentFilter &xray)
 {
 	u8 faces = 0; // k-th bit will be set if k-th face is to be drawn.
 	static const v3s16 tile_dirs[6] = {
@@ -410,7 +416,7 @@ void MapblockMeshGenerator::drawSolidNode(std::set<content_t> xraySet)
 		v3s16 p2 = blockpos_nodes + cur_node.p + tile_dirs[face];
 		MapNode neighbor = data->m_vmanip.getNodeNoEx(p2);
 		content_t n2 = neighbor.getContent();
-		if (xraySet.find(n2) != xraySet.end())
+		if (xray.contains(n2))
 			n2 = CONTENT_AIR;
 		bool backface_culling = cur_node.f->drawtype == NDT_NORMAL;
 		if (n2 == n1)
@@ -436,7 +442,7 @@ void MapblockMeshGenerator::drawSolidNode(std::set<content_t> xraySet)
 			layer.material_flags |= MATERIAL_FLAG_TILEABLE_VERTICAL;
 		}
 		if (!data->m_smooth_lighting) {
-			lights[face] = getFaceLight(cur_node.n, neighbor, nodedef);
+			lights[face] = getFaceLight(cur_node.n, neighbor, nodedef, data->m_fullbright);
 		}
 	}
 	if (!faces)
@@ -471,7 +477,7 @@ void MapblockMeshGenerator::drawSolidNode(std::set<content_t> xraySet)
 			if (lightDiff(final_lights[1], final_lights[3]) < lightDiff(final_lights[0], final_lights[2]))
 				return QuadDiagonal::Diag13;
 			return QuadDiagonal::Diag02;
-		});
+		}, data->m_greedy_meshing);
 	} else {
 		drawCuboid(box, tiles, 6, texture_coord_buf, mask, [&] (int face, video::S3DVertex vertices[4]) {
 			video::SColor color = encode_light(lights[face], cur_node.f->light_source);
@@ -482,8 +488,139 @@ void MapblockMeshGenerator::drawSolidNode(std::set<content_t> xraySet)
 				vertex.Color = color;
 			}
 			return QuadDiagonal::Diag02;
-		});
+		}, data->m_greedy_meshing);
+	}
+}
+
+static bool is_same_face(const TileSpec &a, const TileSpec &b)
+{
+	if (a.world_aligned != b.world_aligned || a.rotation != b.rotation ||
+			a.emissive_light != b.emissive_light)
+		return false;
+	for (int layernum = 0; layernum < MAX_TILE_LAYERS; layernum++) {
+		if (a.layers[layernum] != b.layers[layernum])
+			return false;
+	}
+	return true;
+}
+
+bool MapblockMeshGenerator::addGreedyFace(int face, const TileSpec &tile,
+		const video::S3DVertex *vertices)
+{
+	// With smooth lighting, only faces lit evenly can be merged without
+	// changing how they look
+	for (int j = 1; j < 4; j++) {
+		if (vertices[j].Color != vertices[0].Color)
+			return false;
+	}
+	for (const auto &layer : tile.layers) {
+		if (layer.empty())
+			continue;
+		// The texture has to repeat across the merged quad, and waving
+		// shaders displace vertices, so large quads would not wave alike
+		const u8 tileable = MATERIAL_FLAG_TILEABLE_HORIZONTAL | MATERIAL_FLAG_TILEABLE_VERTICAL;
+		if ((layer.material_flags & tileable) != tileable ||
+				(layer.material_flags & MATERIAL_FLAG_CRACK))
+			return false;
+		switch (layer.material_type) {
+		case TILE_MATERIAL_WAVING_LEAVES:
+		case TILE_MATERIAL_WAVING_PLANTS:
+		case TILE_MATERIAL_WAVING_LIQUID_BASIC:
+		case TILE_MATERIAL_WAVING_LIQUID_TRANSPARENT:
+		case TILE_MATERIAL_WAVING_LIQUID_OPAQUE:
+			return false;
+		default:
+			break;
+		}
+	}
+	greedy_faces.push_back({cur_node.p, (u8)face, vertices[0].Color, tile});
+	return true;
+}
+
+// Axis along the normal of each cuboid face, and the two axes spanning it
+static const u8 greedy_axes[6][3] = {
+	{1, 0, 2},
+	{1, 0, 2},
+	{0, 2, 1},
+	{0, 2, 1},
+	{2, 0, 1},
+	{2, 0, 1},
+};
+
+static s16 &axis_ref(v3s16 &p, u8 axis)
+{
+	return axis == 0 ? p.X : axis == 1 ? p.Y : p.Z;
+}
+
+void MapblockMeshGenerator::drawGreedyFaces()
+{
+	if (greedy_faces.empty())
+		return;
+
+	const s32 side = data->m_side_length;
+
+	// Sort the faces into layers by side and position along the normal
+	std::vector<std::vector<u32>> layers(6 * side);
+	for (u32 i = 0; i < greedy_faces.size(); i++) {
+		GreedyFace &f = greedy_faces[i];
+		layers[f.face * side + axis_ref(f.p, greedy_axes[f.face][0])].push_back(i);
+	}
+
+	std::vector<s32> grid(side * side, -1);
+	for (size_t layer = 0; layer < layers.size(); layer++) {
+		if (layers[layer].empty())
+			continue;
+		const u8 face = layer / side;
+		const u8 u_axis = greedy_axes[face][1];
+		const u8 v_axis = greedy_axes[face][2];
+		for (u32 i : layers[layer]) {
+			GreedyFace &f = greedy_faces[i];
+			grid[axis_ref(f.p, v_axis) * side + axis_ref(f.p, u_axis)] = i;
+		}
+
+		for (s32 v = 0; v < side; v++)
+		for (s32 u = 0; u < side; u++) {
+			const s32 first = grid[v * side + u];
+			if (first < 0)
+				continue;
+			const GreedyFace &base = greedy_faces[first];
+			auto mergeable = [&] (s32 index) {
+				if (index < 0)
+					return false;
+				const GreedyFace &f = greedy_faces[index];
+				return f.color == base.color && is_same_face(f.tile, base.tile);
+			};
+
+			// Grow the quad along u first, then along v while whole rows match
+			s32 w = 1;
+			while (u + w < side && mergeable(grid[v * side + u + w]))
+				w++;
+			s32 h = 1;
+			for (; v + h < side; h++) {
+				bool row_matches = true;
+				for (s32 k = 0; k < w && row_matches; k++)
+					row_matches = mergeable(grid[(v + h) * side + u + k]);
+				if (!row_matches)
+					break;
+			}
+			for (s32 j = 0; j < h; j++)
+			for (s32 k = 0; k < w; k++)
+				grid[(v + j) * side + u + k] = -1;
+
+			v3s16 p_max = base.p;
+			axis_ref(p_max, u_axis) += w - 1;
+			axis_ref(p_max, v_axis) += h - 1;
+			aabb3f box(intToFloat(base.p, BS) - v3f(0.5 * BS),
+					intToFloat(p_max, BS) + v3f(0.5 * BS));
+			f32 texture_coord_buf[24];
+			generateCuboidTextureCoords(box, texture_coord_buf);
+			auto vertices = setupCuboidVertices(box, texture_coord_buf, &base.tile, 1);
+			for (int j = 0; j < 4; j++)
+				vertices[4 * face + j].Color = base.color;
+			collector->append(base.tile, &vertices[4 * face], 4, quad_indices, 6);
+		}
 	}
+	greedy_faces.clear();
 }
 
 u8 MapblockMeshGenerator::getNodeBoxMask(aabb3f box, u8 solid_neighbors, u8 sametype_neighbors) const
@@ -545,16 +682,16 @@ void MapblockMeshGenerator::prepareLiquidNodeDrawing()
 	if (data->m_smooth_lighting)
 		return; // don't need to pre-compute anything in this case
 
-	auto light = LightPair(getInteriorLight(cur_node.n, 0, nodedef));
+	auto light = LightPair(getInteriorLight(cur_node.n, 0, nodedef, data->m_fullbright));
 	if (cur_node.f->light_source != 0) {
 		// If this liquid emits light and doesn't contain light, draw
 		// it at what it emits, for an increased effect
-		u8 e = decode_light(cur_node.f->light_source);
+		u8 e = decode_light(cur_node.f->light_source, data->m_fullbright);
 		light = LightPair(std::max(e, light.lightDay),
 				std::max(e, light.lightNight));
 	} else if (nodedef->getLightingFlags(ntop).has_light) {
 		// Otherwise, use the light of the node on top if possible
-		light = LightPair(getInteriorLight(ntop, 0, nodedef));
+		light = LightPair(getInteriorLight(ntop, 0, nodedef, data->m_fullbright));
 	}
 
 	cur_liquid.color_top = encode_light(light, cur_node.f->light_source);
@@ -1262,8 +1399,7 @@ void MapblockMeshGenerator::drawPlantlikeNode()
 
 void MapblockMeshGenerator::drawPlantlikeRootedNode()
 {
-	std::set<content_t> emptyXraySet;
-		drawSolidNode(emptyXraySet);
+	drawSolidNode(ContentFilter());
 	TileSpec tile;
 	useTile(&tile, 0, MATERIAL_FLAG_CRACK_OVERLAY, 0, true);
 	cur_node.origin += v3f(0.0, BS, 0.0);
@@ -1272,7 +1408,7 @@ void MapblockMeshGenerator::drawPlantlikeRootedNode()
 		getSmoothLightFrame();
 	} else {
 		MapNode ntop = data->m_vmanip.getNodeNoEx(blockpos_nodes + cur_node.p);
-		auto light = LightPair(getInteriorLight(ntop, 0, nodedef));
+		auto light = LightPair(getInteriorLight(ntop, 0, nodedef, data->m_fullbright));
 		cur_node.lcolor = encode_light(light, cur_node.f->light_source);
 	}
 	drawPlantlike(tile, true);
@@ -1739,18 +1875,17 @@ void MapblockMeshGenerator::errorUnknownDrawtype()
 
 void MapblockMeshGenerator::drawNode()
 {
-	std::set<content_t> emptyXraySet;
-	drawNode(emptyXraySet);
+	drawNode(ContentFilter());
 }
 
-void MapblockMeshGenerator::drawNode(std::set<content_t> xraySet)
+void MapblockMeshGenerator::drawNode(const ContentFilter &xray)
 {
 	switch (cur_node.f->drawtype) {
 		case NDT_AIRLIKE:  // Not drawn at all
 			return;
 		case NDT_LIQUID:
 		case NDT_NORMAL: // solid nodes don’t need the usual setup
-			drawSolidNode(xraySet);
+			drawSolidNode(xray);
 			return;
 		default:
 			break;
@@ -1759,7 +1894,7 @@ void MapblockMeshGenerator::drawNode(std::set<content_t> xraySet)
 	if (data->m_smooth_lighting) {
 		getSmoothLightFrame();
 	} else {
-		auto light = LightPair(getInteriorLight(cur_node.n, 0, nodedef));
+		auto light = LightPair(getInteriorLight(cur_node.n, 0, nodedef, data->m_fullbright));
 		cur_node.lcolor = encode_light(light, cur_node.f->light_source);
 	}
 	switch (cur_node.f->drawtype) {
@@ -1780,7 +1915,7 @@ void MapblockMeshGenerator::drawNode(std::set<content_t> xraySet)
 	}
 }
 
-void MapblockMeshGenerator::generate(std::set<content_t> xraySet)
+void MapblockMeshGenerator::generate(const ContentFilter &xray)
 {
 	ZoneScoped;
 
@@ -1789,10 +1924,10 @@ void MapblockMeshGenerator::generate(std::set<content_t> xraySet)
 	for (cur_node.p.X = 0; cur_node.p.X < data->m_side_length; cur_node.p.X++) {
 		cur_node.n = data->m_vmanip.getNodeNoEx(blockpos_nodes + cur_node.p);
 		cur_node.f = &nodedef->get(cur_node.n);
-		content_t node_content = cur_node.n.getContent();
-		if (xraySet.empty() || xraySet.find(node_content) == xraySet.end())
-			drawNode(xraySet);
+		if (!xray.contains(cur_node.n.getContent()))
+			drawNode(xray);
 	}
+	drawGreedyFaces();
 }
 
 void MapblockMeshGenerator::generate()
@@ -1806,4 +1941,5 @@ void MapblockMeshGenerator::generate()
 		cur_node.f = &nodedef->get(cur_node.n);
 		drawNode();
 	}
+	drawGreedyFaces();
 }
\ No newline at end of file
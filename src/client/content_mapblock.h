@@ -5,6 +5,7 @@
 #pragma once
 
 #include "nodedef.h"
+#include "client/meshgen/content_filter.h"
 
 struct MeshMakeData;
 struct MeshCollector;
@@ -47,7 +48,8 @@ class MapblockMeshGenerator
 public:
 	MapblockMeshGenerator(MeshMakeData *input, MeshCollector *output);
 	void generate();
-	void generate(std::set<content_t>);
+	// Nodes contained in `xray` are skipped and treated as air by their neighbors
+	void generate(const ContentFilter &xray);
 
 private:
 	MeshMakeData *const data;
@@ -86,12 +88,28 @@ class MapblockMeshGenerator
 // cuboid drawing!
 	template <typename Fn>
 	void drawCuboid(const aabb3f &box, const TileSpec *tiles, int tilecount,
-			const f32 *txc, u8 mask, Fn &&face_lighter);
+			const f32 *txc, u8 mask, Fn &&face_lighter, bool merge_faces = false);
 	void generateCuboidTextureCoords(aabb3f const &box, f32 *coords);
 	void drawAutoLightedCuboid(aabb3f box, const TileSpec &tile, f32 const *txc	= nullptr, u8 mask = 0);
 	void drawAutoLightedCuboid(aabb3f box, const TileSpec *tiles, int tile_count, f32 const *txc = nullptr, u8 mask = 0);
 	u8 getNodeBoxMask(aabb3f box, u8 solid_neighbors, u8 sametype_neighbors) const;
 
+// greedy meshing
+	// A full node face that is drawn later as part of a larger quad
+	struct GreedyFace {
+		v3s16 p; // relative to blockpos_nodes
+		u8 face; // cuboid face index
+		video::SColor color;
+		TileSpec tile;
+	};
+	std::vector<GreedyFace> greedy_faces;
+
+	// Returns false if the face can't be merged and has to be drawn as is
+	bool addGreedyFace(int face, const TileSpec &tile, const video::S3DVertex *vertices);
+	// Merges coplanar adjacent faces that look the same into as few quads
+	// as possible and draws them
+	void drawGreedyFaces();
+
 // liquid-specific
 	struct LiquidData {
 		struct NeighborData {
@@ -151,7 +169,7 @@ class MapblockMeshGenerator
 		float offset_h, float offset_v = 0.0);
 
 // drawtypes
-	void drawSolidNode(std::set<content_t> xraySet);
+	void drawSolidNode(const ContentFilter &xray);
 	void drawLiquidNode();
 	void drawGlasslikeNode();
 	void drawGlasslikeFramedNode();
@@ -169,5 +187,5 @@ class MapblockMeshGenerator
 // common
 	void errorUnknownDrawtype();
 	void drawNode();
-	void drawNode(std::set<content_t> xraySet);
+	void drawNode(const ContentFilter &xray);
 };
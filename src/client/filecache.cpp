@@ -86,3 +86,8 @@ bool FileCache::updateCopyFile(const std::string &name, const std::string &src_p
 	createDir();
 	return fs::CopyFileContents(src_path, path);
 }
+
+std::string FileCache::getPath(const std::string &name) const
+{
+	return m_dir + DIR_DELIM + name;
+}
@@ -24,6 +24,9 @@ class FileCache
 	// Copy another file on disk into the cache
 	bool updateCopyFile(const std::string &name, const std::string &src_path);
 
+	// Path of the file that holds `name`
+	std::string getPath(const std::string &name) const;
+
 private:
 	std::string m_dir;
 
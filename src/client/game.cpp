@@ -19,6 +19,7 @@
 #include "client/mapblock_mesh.h"
 #include "client/sound.h"
 #include "client/render/plain.h"
+#include "client/settings_snapshot.h"
 #include "clientmap.h"
 #include "clientmedia.h" // For clientMediaUpdateCacheCopy
 #include "clouds.h"
@@ -594,7 +595,7 @@ bool Game::createClient(const GameStartData &start_data)
 		return false;
 	}
 
-	shader_src->addShaderConstantSetter(new NodeShaderConstantSetter());
+	shader_src->addShaderConstantSetter(new NodeShaderConstantSetter(client->getCompactVertexFormat()));
 
 	auto *scsf = new GameGlobalShaderUniformSetterFactory(client);
 	shader_src->addShaderUniformSetterFactory(scsf);
@@ -2743,13 +2744,14 @@ PointedThing Game::updatePointedThing(
 		v3s16 p = floatToInt(pf, BS);
 
 		// Get selection mesh light level
+		const bool fullbright = SettingsSnapshot::get()->fullbright;
 		MapNode n = map.getNode(p);
-		u16 node_light = getInteriorLight(n, -1, nodedef);
+		u16 node_light = getInteriorLight(n, -1, nodedef, fullbright);
 		u16 light_level = node_light;
 
 		for (const v3s16 &dir : g_6dirs) {
 			n = map.getNode(p + dir);
-			node_light = getInteriorLight(n, -1, nodedef);
+			node_light = getInteriorLight(n, -1, nodedef, fullbright);
 			if (node_light > light_level)
 				light_level = node_light;
 		}
@@ -3589,7 +3591,12 @@ void Game::showOverlayMessage(const char *msg, float dtime, int percent, float *
 }
 void Game::updateAllMapBlocksCallback(const std::string &setting_name, void *data)
 {
-	((Game *) data)->client->updateAllMapBlocks();
+	Client *client = ((Game *) data)->client;
+	// Filter changes only affect meshes containing the (un)filtered nodes
+	if (setting_name == "fullbright")
+		client->updateAllMapBlocks();
+	else
+		client->updateMeshFilter();
 }
 void Game::settingChangedCallback(const std::string &setting_name, void *data)
 {
@@ -30,6 +30,7 @@
 #include "client/texturepaths.h"
 #include "client/joystick_controller.h"
 #include "client/mapblock_mesh.h"
+#include "client/meshgen/compact_vertex.h"
 #include "client/sound.h"
 #include "clientmap.h"
 #include "clientmedia.h" // For clientMediaUpdateCacheCopy
@@ -444,7 +445,10 @@ class GameGlobalShaderUniformSetterFactory : public IShaderUniformSetterFactory
 class NodeShaderConstantSetter : public IShaderConstantSetter
 {
 public:
-	NodeShaderConstantSetter() = default;
+	// `compact_format` is the format of map block mesh vertices, if not regular
+	explicit NodeShaderConstantSetter(const CompactVertexFormat *compact_format = nullptr) :
+		m_compact_format(compact_format)
+	{}
 	~NodeShaderConstantSetter() = default;
 
 	void onGenerate(const std::string &name, ShaderConstants &constants) override
@@ -522,7 +526,17 @@ class NodeShaderConstantSetter : public IShaderConstantSetter
 
 		constants["ENABLE_WAVING_LEAVES"] = g_settings->getBool("enable_waving_leaves") ? 1 : 0;
 		constants["ENABLE_WAVING_PLANTS"] = g_settings->getBool("enable_waving_plants") ? 1 : 0;
+
+		if (m_compact_format) {
+			constants["COMPACT_VERTEX"] = 1;
+			constants["COMPACT_POS_STEP"] = m_compact_format->getPosStep();
+			constants["COMPACT_POS_ORIGIN"] = m_compact_format->getPosOrigin();
+			constants["COMPACT_TCOORD_STEP"] = m_compact_format->getTCoordStep();
+		}
 	}
+
+private:
+	const CompactVertexFormat *m_compact_format;
 };
 
 /****************************************************************************
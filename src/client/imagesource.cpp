@@ -7,10 +7,12 @@
 #include <IFileSystem.h>
 #include "imagefilters.h"
 #include "mesh.h"
+#include "noise.h"
 #include "renderingengine.h"
 #include "settings.h"
 #include "texturepaths.h"
 #include "irrlicht_changes/printing.h"
+#include "threading/mutex_auto_lock.h"
 #include "util/base64.h"
 #include "util/numeric.h"
 #include "util/strfnd.h"
@@ -27,9 +29,10 @@ SourceImageCache::~SourceImageCache() {
 	m_images.clear();
 }
 
-void SourceImageCache::insert(const std::string &name, video::IImage *img, bool prefer_local)
+bool SourceImageCache::insert(const std::string &name, video::IImage *img, bool prefer_local)
 {
 	assert(img); // Pre-condition
+	MutexAutoLock lock(m_mutex);
 	// Remove old image
 	auto n = m_images.find(name);
 	if (n != m_images.end()){
@@ -58,10 +61,12 @@ void SourceImageCache::insert(const std::string &name, video::IImage *img, bool
 	if (need_to_grab)
 		toadd->grab();
 	m_images[name] = toadd;
+	return need_to_grab;
 }
 
 video::IImage* SourceImageCache::get(const std::string &name)
 {
+	MutexAutoLock lock(m_mutex);
 	auto n = m_images.find(name);
 	if (n != m_images.end())
 		return n->second;
@@ -71,10 +76,11 @@ video::IImage* SourceImageCache::get(const std::string &name)
 // Primarily fetches from cache, secondarily tries to read from filesystem
 video::IImage* SourceImageCache::getOrLoad(const std::string &name)
 {
-	auto n = m_images.find(name);
-	if (n != m_images.end()){
-		n->second->grab(); // Grab for caller
-		return n->second;
+	{
+		MutexAutoLock lock(m_mutex);
+		auto n = m_images.find(name);
+		if (n != m_images.end())
+			return n->second;
 	}
 	video::IVideoDriver *driver = RenderingEngine::get_video_driver();
 	std::string path = getTexturePath(name);
@@ -86,12 +92,15 @@ video::IImage* SourceImageCache::getOrLoad(const std::string &name)
 	infostream << "SourceImageCache::getOrLoad(): Loading path \"" << path
 			<< "\"" << std::endl;
 	video::IImage *img = driver->createImageFromFile(path.c_str());
+	if (!img)
+		return nullptr;
 
-	if (img){
-		m_images[name] = img;
-		img->grab(); // Grab for caller
-	}
-	return img;
+	MutexAutoLock lock(m_mutex);
+	// Another thread may have loaded it meanwhile
+	auto inserted = m_images.emplace(name, img);
+	if (!inserted.second)
+		img->drop();
+	return inserted.first->second;
 }
 
 
@@ -304,6 +313,16 @@ static std::string unescape_string(std::string_view str, const char esc = '\\')
 	return out;
 }
 
+/*
+	Whether upscaleImagesToMatchLargest() replaces the second image rather
+	than the first. This includes images of equal area but different shape.
+*/
+static bool upscalesSecondImage(core::dimension2d<u32> dim1,
+	core::dimension2d<u32> dim2)
+{
+	return dim1 != dim2 && dim1.getArea() >= dim2.getArea();
+}
+
 /*
 	Replaces the smaller of the two images with one upscaled to match the
 	dimensions of the other.
@@ -320,7 +339,7 @@ static void upscaleImagesToMatchLargest(video::IImage *& img1,
 		// image dimensions match, no scaling required
 
 	}
-	else if (dim1.Width * dim1.Height < dim2.Width * dim2.Height) {
+	else if (!upscalesSecondImage(dim1, dim2)) {
 		// Upscale img1
 		video::IImage *scaled_image = RenderingEngine::get_video_driver()->
 			createImage(video::ECF_A8R8G8B8, dim2);
@@ -974,7 +993,10 @@ bool ImageSource::generateImagePart(std::string_view part_of_name,
 	if (part_of_name.empty() || part_of_name[0] != '[') {
 		std::string part_s(part_of_name);
 		source_image_names.insert(part_s);
+		// Owned by the cache, which may be shared with other threads,
+		// so don't touch its reference count
 		video::IImage *image = m_sourcecache.getOrLoad(part_s);
+		video::IImage *dummy = nullptr;
 
 		if (!image) {
 			// Do not create the dummy texture
@@ -986,10 +1008,12 @@ bool ImageSource::generateImagePart(std::string_view part_of_name,
 				"Creating a dummy image" << std::endl;
 
 			core::dimension2d<u32> dim(1,1);
-			image = driver->createImage(video::ECF_A8R8G8B8, dim);
+			image = dummy = driver->createImage(video::ECF_A8R8G8B8, dim);
 			sanity_check(image != NULL);
-			image->setPixel(0,0, video::SColor(255,myrand()%256,
-					myrand()%256,myrand()%256));
+			// Images are generated on several threads, so don't use myrand()
+			thread_local PcgRandom pcgrand;
+			image->setPixel(0,0, video::SColor(255,pcgrand.next()%256,
+					pcgrand.next()%256,pcgrand.next()%256));
 		}
 
 		// load as base or blit
@@ -1006,10 +1030,22 @@ bool ImageSource::generateImagePart(std::string_view part_of_name,
 		// Else blit on base.
 		else
 		{
+			// blitBaseImage would replace a smaller image by a scaled copy
+			// and drop it, so scale it here instead. Use the same rule, so
+			// it never gets to scale the image itself.
+			core::dimension2d<u32> dim = baseimg->getDimension();
+			if (upscalesSecondImage(dim, image->getDimension())) {
+				video::IImage *scaled = driver->createImage(video::ECF_A8R8G8B8, dim);
+				image->copyToScaling(scaled);
+				if (dummy)
+					dummy->drop();
+				image = dummy = scaled;
+			}
 			blitBaseImage(image, baseimg);
 		}
 
-		image->drop();
+		if (dummy)
+			dummy->drop();
 	}
 	else
 	{
@@ -1050,6 +1086,7 @@ bool ImageSource::generateImagePart(std::string_view part_of_name,
 					It is an image with a number of cracking stages
 					horizontally tiled.
 				*/
+				source_image_names.insert("crack_anylength.png");
 				video::IImage *img_crack = m_sourcecache.getOrLoad(
 					"crack_anylength.png");
 
@@ -1057,7 +1094,6 @@ bool ImageSource::generateImagePart(std::string_view part_of_name,
 					draw_crack(img_crack, baseimg,
 						use_overlay, frame_count,
 						progression, driver, tiles);
-					img_crack->drop();
 				}
 			}
 		}
@@ -1797,6 +1833,11 @@ ImageSource::ImageSource() :
 		m_setting_anisotropic_filter{g_settings->getBool("anisotropic_filter")}
 {}
 
+ImageSource::~ImageSource()
+{
+	setIntermediateCaching(false);
+}
+
 video::IImage* ImageSource::generateImage(std::string_view name,
 		std::set<std::string> &source_image_names)
 {
@@ -1851,7 +1892,7 @@ video::IImage* ImageSource::generateImage(std::string_view name,
 		using a recursive call.
 	*/
 	if (last_separator_pos != -1) {
-		baseimg = generateImage(name.substr(0, last_separator_pos), source_image_names);
+		baseimg = generateSubImage(name.substr(0, last_separator_pos), source_image_names);
 	}
 
 	/*
@@ -1871,7 +1912,7 @@ video::IImage* ImageSource::generateImage(std::string_view name,
 			&& last_part_of_name.back() == paren_close) {
 		auto name2 = last_part_of_name.substr(1,
 				last_part_of_name.size() - 2);
-		video::IImage *tmp = generateImage(name2, source_image_names);
+		video::IImage *tmp = generateSubImage(name2, source_image_names);
 		if (!tmp) {
 			errorstream << "generateImage(): "
 				"Failed to generate \"" << name2 << "\"\n"
@@ -1910,7 +1951,80 @@ video::IImage* ImageSource::generateImage(std::string_view name,
 	return baseimg;
 }
 
-void ImageSource::insertSourceImage(const std::string &name, video::IImage *img, bool prefer_local)
+video::IImage *ImageSource::generateSubImage(std::string_view name,
+		std::set<std::string> &source_image_names)
+{
+	// Plain source images are cached by m_sourcecache already
+	if (!m_intermediate_caching || name.find_first_of("[^(") == std::string_view::npos)
+		return generateImage(name, source_image_names);
+
+	std::string key(name);
+	const CachedImage *cached = nullptr;
+	bool seen = false;
+	{
+		MutexAutoLock lock(m_intermediate_mutex);
+		auto it = m_intermediate_images.find(key);
+		if (it != m_intermediate_images.end())
+			cached = &it->second;
+		else
+			seen = !m_intermediate_seen.insert(key).second;
+	}
+
+	video::IVideoDriver *driver = RenderingEngine::get_video_driver();
+	if (cached) {
+		// The caller modifies the image in place, so hand out a copy
+		video::IImage *img = driver->createImage(cached->image->getColorFormat(),
+				cached->image->getDimension());
+		cached->image->copyTo(img);
+		source_image_names.insert(cached->source_image_names.begin(),
+				cached->source_image_names.end());
+		return img;
+	}
+
+	std::set<std::string> names;
+	video::IImage *img = generateImage(name, names);
+	if (img && seen) {
+		video::IImage *copy = driver->createImage(img->getColorFormat(),
+				img->getDimension());
+		img->copyTo(copy);
+		MutexAutoLock lock(m_intermediate_mutex);
+		// Another thread may have cached it meanwhile
+		if (!m_intermediate_images.emplace(std::move(key), CachedImage{copy, names}).second)
+			copy->drop();
+	}
+	source_image_names.insert(names.begin(), names.end());
+	return img;
+}
+
+bool ImageSource::insertSourceImage(const std::string &name, video::IImage *img, bool prefer_local)
 {
-	m_sourcecache.insert(name, img, prefer_local);
+	bool inserted = m_sourcecache.insert(name, img, prefer_local);
+
+	// Cached parts may have been made from the old image
+	if (m_intermediate_caching) {
+		setIntermediateCaching(false);
+		setIntermediateCaching(true);
+	}
+	return inserted;
+}
+
+std::string ImageSource::getSettingsKey()
+{
+	std::string key;
+	for (const char *name : {"mip_map", "trilinear_filter", "bilinear_filter",
+			"anisotropic_filter", "texture_min_size"})
+		key.append(g_settings->get(name)).append(";");
+	return key;
+}
+
+void ImageSource::setIntermediateCaching(bool enabled)
+{
+	m_intermediate_caching = enabled;
+	if (enabled)
+		return;
+
+	for (auto &it : m_intermediate_images)
+		it.second.image->drop();
+	m_intermediate_images.clear();
+	m_intermediate_seen.clear();
 }
@@ -5,7 +5,9 @@
 #pragma once
 
 #include <IImage.h>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
 #include <string>
 
@@ -17,23 +19,30 @@ using namespace irr;
 // A cache used for storing source images.
 // (A "source image" is an unmodified image directly taken from the filesystem.)
 // Does not contain modified images.
+// Lookups may happen from several threads at once, but insert() must not
+// race with them.
 class SourceImageCache {
 public:
 	~SourceImageCache();
 
-	void insert(const std::string &name, video::IImage *img, bool prefer_local);
+	// Returns false if a local image was used instead of img
+	bool insert(const std::string &name, video::IImage *img, bool prefer_local);
 
 	video::IImage* get(const std::string &name);
 
 	// Primarily fetches from cache, secondarily tries to read from filesystem.
+	// The returned image belongs to the cache (don't drop it) and stays
+	// valid until the name is inserted again.
 	video::IImage *getOrLoad(const std::string &name);
 private:
 	std::unordered_map<std::string, video::IImage*> m_images;
+	std::mutex m_mutex;
 };
 
 // Generates images using texture modifiers, and caches source images.
 struct ImageSource {
 	ImageSource();
+	~ImageSource();
 
 	/*! Generates an image from a full string like
 	 * "stone.png^mineral_coal.png^[crack:1:0".
@@ -43,7 +52,18 @@ struct ImageSource {
 	video::IImage* generateImage(std::string_view name, std::set<std::string> &source_image_names);
 
 	// Insert a source image into the cache without touching the filesystem.
-	void insertSourceImage(const std::string &name, video::IImage *img, bool prefer_local);
+	// Returns false if a local image was used instead of img.
+	bool insertSourceImage(const std::string &name, video::IImage *img, bool prefer_local);
+
+	// Describes the settings that affect the generated images
+	static std::string getSettingsKey();
+
+	/*! Enables caching of intermediate results, i.e. the base images and
+	 * parenthesized parts that several texture strings have in common.
+	 * Disabling it frees the cached images. generateImage may be called from
+	 * several threads at once, but not while this or insertSourceImage runs.
+	 */
+	void setIntermediateCaching(bool enabled);
 
 	// This was picked so that the image buffer size fits in an s32 (assuming 32bpp).
 	// The exact value is 23170 but this provides some leeway.
@@ -59,6 +79,11 @@ struct ImageSource {
 	bool generateImagePart(std::string_view part_of_name, video::IImage *& baseimg,
 			std::set<std::string> &source_image_names);
 
+	// Same as generateImage, but for a part of a bigger texture string.
+	// Uses a copy of the cached result if the part was generated before.
+	video::IImage *generateSubImage(std::string_view name,
+			std::set<std::string> &source_image_names);
+
 	// Cached settings needed for making textures from meshes
 	bool m_setting_mipmap;
 	bool m_setting_trilinear_filter;
@@ -67,4 +92,17 @@ struct ImageSource {
 
 	// Cache of source images
 	SourceImageCache m_sourcecache;
+
+	struct CachedImage {
+		video::IImage *image;
+		std::set<std::string> source_image_names;
+	};
+
+	bool m_intermediate_caching = false;
+	// Parts that were generated once. A part is only cached when it is
+	// needed a second time, so that unique strings don't fill the cache.
+	std::unordered_set<std::string> m_intermediate_seen;
+	std::unordered_map<std::string, CachedImage> m_intermediate_images;
+	// Protects the two former containers
+	std::mutex m_intermediate_mutex;
 };
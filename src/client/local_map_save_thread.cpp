@@ -0,0 +1,122 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "local_map_save_thread.h"
+#include <sstream>
+#include "database/database.h"
+#include "irrlicht_changes/printing.h"
+#include "log.h"
+#include "mapblock.h"
+#include "profiler.h"
+#include "serialization.h"
+
+// Start writing early once this many blocks are queued
+static constexpr size_t FLUSH_THRESHOLD = 1024;
+// Make the main thread wait for the writer beyond this many queued blocks
+static constexpr size_t QUEUE_LIMIT = 4096;
+
+LocalMapSaveThread::LocalMapSaveThread(MapDatabase *db, int compression_level) :
+	UpdateThread("LocalMapSave"),
+	m_db(db),
+	m_compression_level(compression_level)
+{
+}
+
+LocalMapSaveThread::~LocalMapSaveThread()
+{
+	finish();
+}
+
+void LocalMapSaveThread::saveBlock(MapBlock *block)
+{
+	// Format used for writing
+	const u8 version = SER_FMT_VER_HIGHEST_WRITE;
+
+	std::ostringstream os(std::ios_base::binary);
+	block->serializeUncompressed(os, version, true);
+	block->resetModified();
+
+	bool start_flush;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		// Apply backpressure if the writer can't keep up
+		m_written_cv.wait(lock, [this] {
+			return m_pending.size() < QUEUE_LIMIT || !isRunning();
+		});
+		m_pending[block->getPos()] = os.str();
+		start_flush = m_pending.size() >= FLUSH_THRESHOLD && !m_flush_requested;
+		if (start_flush)
+			m_flush_requested = true;
+	}
+	if (start_flush)
+		deferUpdate();
+}
+
+void LocalMapSaveThread::flush()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_pending.empty())
+			return;
+		m_flush_requested = true;
+	}
+	deferUpdate();
+}
+
+void LocalMapSaveThread::finish()
+{
+	if (isRunning()) {
+		stop();
+		wait();
+	}
+	m_written_cv.notify_all();
+
+	// The thread is gone, write the remainder on the calling thread
+	std::unordered_map<v3s16, std::string> blocks;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		blocks.swap(m_pending);
+	}
+	if (!blocks.empty())
+		writeBlocks(blocks);
+}
+
+void LocalMapSaveThread::doUpdate()
+{
+	std::unordered_map<v3s16, std::string> blocks;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_flush_requested)
+			return;
+		m_flush_requested = false;
+		blocks.swap(m_pending);
+	}
+	// The queue has room again, don't make saveBlock() wait for the write
+	m_written_cv.notify_all();
+
+	if (!blocks.empty())
+		writeBlocks(blocks);
+}
+
+void LocalMapSaveThread::writeBlocks(std::unordered_map<v3s16, std::string> &blocks)
+{
+	ScopeProfiler sp(g_profiler, "Client: Local map saving (sum)");
+
+	const u8 version = SER_FMT_VER_HIGHEST_WRITE;
+	std::ostringstream os(std::ios_base::binary);
+
+	m_db->beginSave();
+	for (auto &it : blocks) {
+		/*
+			[0] u8 serialization version
+			[1] data
+		*/
+		os.str("");
+		os.write((char *)&version, 1);
+		compress(it.second, os, version, m_compression_level);
+		if (!m_db->saveBlock(it.first, os.str()))
+			warningstream << "LocalMapSaveThread: failed to save block "
+				<< it.first << std::endl;
+	}
+	m_db->endSave();
+}
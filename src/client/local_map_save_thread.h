@@ -0,0 +1,63 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "irr_v3d.h"
+#include "util/thread.h"
+
+class MapBlock;
+class MapDatabase;
+
+/*
+	Writes blocks received from the server to the local map database.
+
+	The main thread only serializes a block (without compression) and queues
+	it. Compression and the database writes happen on this thread, batched
+	into one transaction per flush. Repeated updates of the same block
+	position between two flushes are coalesced into a single write.
+*/
+class LocalMapSaveThread : public UpdateThread
+{
+public:
+	// Takes ownership of the database
+	LocalMapSaveThread(MapDatabase *db, int compression_level);
+	~LocalMapSaveThread();
+
+	// Queues the current state of the block for saving
+	void saveBlock(MapBlock *block);
+
+	// Requests writing all queued blocks in one transaction
+	void flush();
+
+	// Stops the thread and synchronously writes what is still queued
+	void finish();
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_pending.size();
+	}
+
+protected:
+	void doUpdate() override;
+
+private:
+	// Writes the given blocks in one transaction
+	void writeBlocks(std::unordered_map<v3s16, std::string> &blocks);
+
+	std::unique_ptr<MapDatabase> m_db;
+	const int m_compression_level;
+
+	std::mutex m_mutex;
+	// Signalled when the queued blocks were taken for writing
+	std::condition_variable m_written_cv;
+	// Uncompressed block data, keyed by block position
+	std::unordered_map<v3s16, std::string> m_pending;
+	bool m_flush_requested = false;
+};
@@ -10,6 +10,7 @@
 #include "collision.h"
 #include "nodedef.h"
 #include "settings.h"
+#include "client/settings_snapshot.h"
 #include "environment.h"
 #include "map.h"
 #include "client.h"
@@ -224,6 +225,7 @@ void LocalPlayer::moveFreecam(f32 dtime, Environment *env, std::vector<Collision
 
 void LocalPlayer::move(f32 dtime, Environment *env, std::vector<CollisionInfo> *collision_info)
 {
+	const auto settings = SettingsSnapshot::get();
 	v3f position = getLegitPosition();
 	v3f speed = getLegitSpeed();
 	// Node at feet position, update each ClientEnvironment::step()
@@ -231,8 +233,8 @@ void LocalPlayer::move(f32 dtime, Environment *env, std::vector<CollisionInfo> *
 		m_standing_node = floatToInt(position, BS);
 
 	PlayerControl &correct_control =
-	(m_freecam && !g_settings->getBool("lua_control")) ? empty_control :
-	(g_settings->getBool("lua_control"))               ? lua_control :
+	(m_freecam && !settings->lua_control) ? empty_control :
+	(settings->lua_control)               ? lua_control :
 	                                                     control;
 
 
@@ -333,7 +335,7 @@ void LocalPlayer::move(f32 dtime, Environment *env, std::vector<CollisionInfo> *
 			nodemgr->get(node2.getContent()).climbable) && !free_move;
 	}
 
-	if (!is_climbing && !free_move && g_settings->getBool("spider")) {
+	if (!is_climbing && !free_move && settings->spider) {
 		v3s16 spider_positions[4] = {
 			floatToInt(position + v3f(+1.0f, +0.0f,  0.0f) * BS, BS),
 			floatToInt(position + v3f(-1.0f, +0.0f,  0.0f) * BS, BS),
@@ -357,8 +359,8 @@ void LocalPlayer::move(f32 dtime, Environment *env, std::vector<CollisionInfo> *
 	// /src/script/common/c_content.cpp and /src/content_sao.cpp
 	float player_stepheight = (m_cao == nullptr) ? 0.0f :
 	((touching_ground ? m_cao->getStepHeight() : (0.2f * BS)) * 
-	(g_settings->getBool("step") ? g_settings->getFloat("step.mult") : 
-		(g_settings->getBool("scaffold") ? 2.0f : 1.0f)));
+	(settings->step ? settings->step_mult : 
+		(settings->scaffold ? 2.0f : 1.0f)));
 
 	v3f accel_f(0, -gravity, 0);
 	const v3f initial_position = position;
@@ -405,7 +407,7 @@ void LocalPlayer::move(f32 dtime, Environment *env, std::vector<CollisionInfo> *
 		Player is allowed to jump when this is true.
 	*/
 	bool touching_ground_was = touching_ground;
-	touching_ground = result.touching_ground || (g_settings->getBool("airjump") && !correct_control.sneak);
+	touching_ground = result.touching_ground || (settings->airjump && !correct_control.sneak);
 	bool sneak_can_jump = false;
 
 	// Max. distance (X, Z) over border for sneaking determined by collision box
@@ -420,7 +422,7 @@ void LocalPlayer::move(f32 dtime, Environment *env, std::vector<CollisionInfo> *
 	/*
 		If sneaking, keep on top of last walked node and don't fall off
 	*/
-	if (could_sneak && m_sneak_node_exists && !g_settings->getBool("autosneak")) {
+	if (could_sneak && m_sneak_node_exists && !settings->autosneak) {
 		const v3f sn_f = intToFloat(m_sneak_node, BS);
 		const v3f bmin = sn_f + m_sneak_node_bb_top.MinEdge;
 		const v3f bmax = sn_f + m_sneak_node_bb_top.MaxEdge;
@@ -535,7 +537,7 @@ void LocalPlayer::move(f32 dtime, Environment *env, std::vector<CollisionInfo> *
 		} else {
 			// jump pressed
 			// Reduce boost when speed already is high
-			if (g_settings->getBool("BHOP")) {
+			if (settings->bhop) {
 				jumpspeed = jumpspeed;
 			} else {
 				jumpspeed = jumpspeed / (1.0f + (m_speed.Y * 2.8f / jumpspeed));
@@ -581,7 +583,7 @@ void LocalPlayer::applyFreecamControl(float dtime, Environment *env)
 	const f32 speed_walk = movement_speed_walk * physics_override.speed_walk;
 	// const f32 speed_fast = movement_speed_fast * physics_override.speed_fast;
 
-	f32 new_speed_fast = g_settings->getFloat("movement_speed_fast") * BS;
+	f32 new_speed_fast = SettingsSnapshot::get()->movement_speed_fast * BS;
 
 	if (always_fly_fast)
 		superspeed = true;
@@ -655,6 +657,7 @@ void LocalPlayer::applyFreecamControl(float dtime, Environment *env)
 
 void LocalPlayer::applyControl(float dtime, Environment *env)
 {
+	const auto settings = SettingsSnapshot::get();
 	// Clear stuff
 	swimming_vertical = false;
 	swimming_pitch = false;
@@ -669,8 +672,8 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 	}
 
 	PlayerControl &correct_control =
-	(m_freecam && !g_settings->getBool("lua_control")) ? empty_control :
-	(g_settings->getBool("lua_control"))               ? lua_control :
+	(m_freecam && !settings->lua_control) ? empty_control :
+	(settings->lua_control)               ? lua_control :
 	                                                     control;
 
 	PlayerSettings &player_settings = getPlayerSettings();
@@ -696,7 +699,7 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 	const f32 speed_walk = movement_speed_walk * physics_override.speed_walk;
 	// const f32 speed_fast = movement_speed_fast * physics_override.speed_fast;
 
-	f32 new_speed_fast = g_settings->getFloat("movement_speed_fast") * BS;
+	f32 new_speed_fast = settings->movement_speed_fast * BS;
 
 	if (always_fly_fast && free_move && fast_move)
 		superspeed = true;
@@ -772,11 +775,11 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 			m_autojump = false;
 	}
 
-	if (g_settings->getBool("BHOP") && control.isMoving() && !g_settings->getBool("freecam") && !g_settings->getBool("free_move") && g_settings->getBool("BHOP.jump")) {
+	if (settings->bhop && control.isMoving() && !settings->freecam && !settings->free_move && settings->bhop_jump) {
 		control.jump = true;
 	}
 
-	if (g_settings->getBool("BHOP") && control.isMoving() && !g_settings->getBool("freecam") && !g_settings->getBool("free_move") && g_settings->getBool("BHOP.sprint")) {
+	if (settings->bhop && control.isMoving() && !settings->freecam && !settings->free_move && settings->bhop_sprint) {
 		control.aux1 = true;
 	}
 
@@ -796,14 +799,14 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 						speedV.Y = speed_walk;
 				}
 			}
-		} else if (m_can_jump || g_settings->getBool("jetpack")) {
+		} else if (m_can_jump || settings->jetpack) {
 			/*
 				NOTE: The d value in move() affects jump height by
 				raising the height at which the jump speed is kept
 				at its starting value
 			*/
 			v3f speedJ = getLegitSpeed();
-			if (speedJ.Y >= -0.5f * BS || g_settings->getBool("jetpack")) {
+			if (speedJ.Y >= -0.5f * BS || settings->jetpack) {
 				speedJ.Y = movement_speed_jump * physics_override.jump;
 				setLegitSpeed(speedJ);
 				m_client->getEventManager()->put(new SimpleTriggerEvent(MtEvent::PLAYER_JUMP));
@@ -826,7 +829,7 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 	if (superspeed || (is_climbing && fast_climb) ||
 			((in_liquid || in_liquid_stable) && fast_climb))
 		speedH = speedH.normalize() * new_speed_fast;
-	else if (correct_control.sneak && !free_move && !in_liquid && !in_liquid_stable && !g_settings->getBool("no_slow"))
+	else if (correct_control.sneak && !free_move && !in_liquid && !in_liquid_stable && !settings->no_slow)
 		speedH = speedH.normalize() * movement_speed_crouch * physics_override.speed_crouch;
 	else
 		speedH = speedH.normalize() * speed_walk;
@@ -842,7 +845,7 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 		if (superspeed || (fast_move && correct_control.aux1))
 			incH = movement_acceleration_fast * physics_override.acceleration_fast * BS * dtime;
 		else
-			if (g_settings->getBool("BHOP")) {
+			if (settings->bhop) {
 				incH = (movement_acceleration_air*100) * (physics_override.acceleration_air*100) * BS * dtime;
 			} else {
 				incH = movement_acceleration_air * physics_override.acceleration_air * BS * dtime;
@@ -852,7 +855,7 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 			((in_liquid || in_liquid_stable) && fast_climb)) {
 		incH = incV = movement_acceleration_fast * physics_override.acceleration_fast * BS * dtime;
 	} else {
-		if (g_settings->getBool("BHOP")) {
+		if (settings->bhop) {
 			incH = incV = (movement_acceleration_default*100) * (physics_override.acceleration_default*100) * BS * dtime;
 		} else {
 			incH = incV = movement_acceleration_default * physics_override.acceleration_default * BS * dtime;
@@ -871,7 +874,7 @@ void LocalPlayer::applyControl(float dtime, Environment *env)
 	}
 
 	// Accelerate to target speed with maximum increment
-	if (g_settings->getBool("BHOP") && control.jump && g_settings->getBool("BHOP.speed")) {
+	if (settings->bhop && control.jump && settings->bhop_speed) {
 		accelerate((speedH*1.2 + speedV*1.2) * physics_override.speed, incH * physics_override.speed * slip_factor, incV * physics_override.speed, pitch_move);
 	} else {
  	accelerate((speedH + speedV) * physics_override.speed, incH * physics_override.speed * slip_factor, incV * physics_override.speed, pitch_move);
@@ -927,7 +930,7 @@ v3f LocalPlayer::getEyeOffset() const
 
 ClientActiveObject *LocalPlayer::getParent() const
 {
-	return (m_cao && ! g_settings->getBool("entity_speed")) ? m_cao->getParent() : nullptr;
+	return (m_cao && ! SettingsSnapshot::get()->entity_speed) ? m_cao->getParent() : nullptr;
 }
 
 bool LocalPlayer::isDead() const
@@ -945,7 +948,7 @@ void LocalPlayer::tryReattach(int id)
 
 bool LocalPlayer::isWaitingForReattach() const
 {
-	return g_settings->getBool("entity_speed") && m_cao && ! m_cao->getParent() && m_cao->m_waiting_for_reattach > 0;
+	return SettingsSnapshot::get()->entity_speed && m_cao && ! m_cao->getParent() && m_cao->m_waiting_for_reattach > 0;
 }
 
 EntityRelationship LocalPlayer::getEntityRelationship(GenericCAO *playerObj) {
@@ -967,13 +970,9 @@ EntityRelationship LocalPlayer::getEntityRelationship(GenericCAO *playerObj) {
 		std::string address = m_client->getAddressName().c_str();
 		u16 port = serverAddress.getPort();
 		std::string server_url = address + ":" + toPaddedString(port);
+		const auto settings = SettingsSnapshot::get();
 
-		Json::Value friends = {};
-		try {
-			friends = g_settings->getJson("friends");
-		} catch (std::exception& e) {
-			g_settings->set("friends", "{}");
-		}
+		const Json::Value &friends = settings->friends;
 
 		if (!friends.isNull() && friends.isMember(server_url) && friends[server_url].isString()) {
 			std::vector<std::string> server_friends = str_split(friends[server_url].asString(), ',');
@@ -987,12 +986,7 @@ EntityRelationship LocalPlayer::getEntityRelationship(GenericCAO *playerObj) {
 			}
 		}
 
-		Json::Value staff = {};
-		try {
-			staff = g_settings->getJson("staff");
-		} catch (std::exception& e) {
-			g_settings->set("staff", "{}");
-		}
+		const Json::Value &staff = settings->staff;
 
 		if (!staff.isNull() && staff.isMember(server_url) && staff[server_url].isString()) {
 			std::vector<std::string> server_staff = str_split(staff[server_url].asString(), ',');
@@ -1006,12 +1000,7 @@ EntityRelationship LocalPlayer::getEntityRelationship(GenericCAO *playerObj) {
 			}
 		}
 
-		Json::Value enemies = {};
-		try {
-			enemies = g_settings->getJson("enemies");
-		} catch (std::exception& e) {
-			g_settings->set("enemies", "{}");
-		}
+		const Json::Value &enemies = settings->enemies;
 
 		if (!enemies.isNull() && enemies.isMember(server_url) && enemies[server_url].isString()) {
 			std::vector<std::string> server_enemies = str_split(enemies[server_url].asString(), ',');
@@ -1025,12 +1014,7 @@ EntityRelationship LocalPlayer::getEntityRelationship(GenericCAO *playerObj) {
 			}
 		}
 
-		Json::Value allies = {};
-		try {
-			allies = g_settings->getJson("allies");
-		} catch (std::exception& e) {
-			g_settings->set("allies", "{}");
-		}
+		const Json::Value &allies = settings->allies;
 
 		if (!allies.isNull() && allies.isMember(server_url) && allies[server_url].isString()) {
 			std::vector<std::string> server_allies = str_split(allies[server_url].asString(), ',');
@@ -1094,7 +1078,8 @@ void LocalPlayer::accelerate(const v3f &target_speed, const f32 max_increase_H,
 {	
 	f32 yaw, pitch;
 
-	if (g_settings->getBool("detached_camera") || g_settings->getBool("freecam")) {
+	const auto settings = SettingsSnapshot::get();
+	if (settings->detached_camera || settings->freecam) {
 		yaw = getLegitYaw();
 		pitch = getLegitPitch();
 	} else {
@@ -1145,7 +1130,7 @@ float LocalPlayer::getSlipFactor(Environment *env, const v3f &speedH)
 	Map *map = &env->getMap();
 	const ContentFeatures &f = nodemgr->get(map->getNode(getStandingNodePos()));
 	int slippery = 0;
-	if (f.walkable && !g_settings->getBool("antislip"))
+	if (f.walkable && !SettingsSnapshot::get()->antislip)
 		slippery = itemgroup_get(f.groups, "slippery");
 
 	if (slippery >= 1) {
@@ -1159,9 +1144,10 @@ float LocalPlayer::getSlipFactor(Environment *env, const v3f &speedH)
 
 void LocalPlayer::handleAutojump(f32 dtime, Environment *env, const collisionMoveResult &result, v3f initial_position, v3f initial_speed)
 {
+	const auto settings = SettingsSnapshot::get();
 	PlayerControl &correct_control =
-	(m_freecam && !g_settings->getBool("lua_control")) ? empty_control :
-	(g_settings->getBool("lua_control"))               ? lua_control :
+	(m_freecam && !settings->lua_control) ? empty_control :
+	(settings->lua_control)               ? lua_control :
 	                                                     control;
 														 
 	v3f position = getLegitPosition();
@@ -1236,11 +1222,11 @@ void LocalPlayer::handleAutojump(f32 dtime, Environment *env, const collisionMov
 
 void LocalPlayer::setPitch(f32 pitch) {
 	m_pitch = pitch;
-	if (!m_freecam && !g_settings->getBool("detached_camera"))
+	if (!m_freecam && !SettingsSnapshot::get()->detached_camera)
 		m_legit_pitch = m_pitch;
 }
 void LocalPlayer::setLegitPitch(f32 pitch) {
-	if (m_freecam || g_settings->getBool("detached_camera"))
+	if (m_freecam || SettingsSnapshot::get()->detached_camera)
 		m_legit_pitch = pitch;
 	else
 		setPitch(pitch);
@@ -1248,11 +1234,11 @@ void LocalPlayer::setLegitPitch(f32 pitch) {
 
 void LocalPlayer::setYaw(f32 yaw) {
 	m_yaw = yaw;
-	if (!m_freecam && !g_settings->getBool("detached_camera"))
+	if (!m_freecam && !SettingsSnapshot::get()->detached_camera)
 		m_legit_yaw = m_yaw;
 }
 void LocalPlayer::setLegitYaw(f32 yaw) {
-	if (m_freecam || g_settings->getBool("detached_camera"))
+	if (m_freecam || SettingsSnapshot::get()->detached_camera)
 		m_legit_yaw = yaw;
 	else
 		setYaw(yaw);
@@ -16,6 +16,8 @@
 #include "util/directiontables.h"
 #include "util/tracy_wrapper.h"
 #include "client/meshgen/collector.h"
+#include "client/meshgen/compact_vertex.h"
+#include "client/meshgen/content_filter.h"
 #include "client/renderingengine.h"
 #include <array>
 #include <algorithm>
@@ -45,19 +47,26 @@ void MeshMakeData::fillBlockDataBegin(const v3s16 &blockpos)
 	v3s16 blockpos_nodes = m_blockpos*MAP_BLOCKSIZE;
 
 	m_vmanip.clear();
-	// extra 1 block thick layer around the mesh
-	VoxelArea voxel_area(blockpos_nodes - v3s16(1,1,1) * MAP_BLOCKSIZE,
-			blockpos_nodes + v3s16(1,1,1) * (m_side_length + MAP_BLOCKSIZE) - v3s16(1,1,1));
+	// extra HALO nodes thick layer around the mesh
+	VoxelArea voxel_area(blockpos_nodes - v3s16(1,1,1) * HALO,
+			blockpos_nodes + v3s16(1,1,1) * (m_side_length + HALO) - v3s16(1,1,1));
 	m_vmanip.addArea(voxel_area);
 }
 
-void MeshMakeData::fillBlockData(const v3s16 &bp, MapNode *data)
+void MeshMakeData::fillBlockData(const v3s16 &bp, const MapNode *data)
 {
 	v3s16 data_size(MAP_BLOCKSIZE, MAP_BLOCKSIZE, MAP_BLOCKSIZE);
 	VoxelArea data_area(v3s16(0,0,0), data_size - v3s16(1,1,1));
 
 	v3s16 blockpos_nodes = bp * MAP_BLOCKSIZE;
-	m_vmanip.copyFrom(data, data_area, v3s16(0,0,0), blockpos_nodes, data_size);
+	VoxelArea copy_area = m_vmanip.m_area.intersect(
+			VoxelArea(blockpos_nodes, blockpos_nodes + data_size - v3s16(1,1,1)));
+	if (copy_area.hasEmptyExtent())
+		return;
+
+	const v3s32 &extent = copy_area.getExtent();
+	m_vmanip.copyFrom(data, data_area, copy_area.MinEdge - blockpos_nodes,
+			copy_area.MinEdge, v3s16(extent.X, extent.Y, extent.Z));
 }
 
 void MeshMakeData::fillSingleNode(MapNode data, MapNode padding)
@@ -93,25 +102,25 @@ void MeshMakeData::setCrack(int crack_level, v3s16 crack_pos)
 	Single light bank.
 */
 static u8 getInteriorLight(enum LightBank bank, MapNode n, s32 increment,
-	const NodeDefManager *ndef)
+	const NodeDefManager *ndef, bool fullbright)
 {
-	if (g_settings->getBool("fullbright"))
-	return 255;
+	if (fullbright)
+		return 255;
 
 	u8 light = n.getLight(bank, ndef->getLightingFlags(n));
 	light = rangelim(light + increment, 0, LIGHT_SUN);
-	return decode_light(light);
+	return decode_light(light, false);
 }
 
 /*
 	Calculate non-smooth lighting at interior of node.
 	Both light banks.
 */
-u16 getInteriorLight(MapNode n, s32 increment, const NodeDefManager *ndef)
+u16 getInteriorLight(MapNode n, s32 increment, const NodeDefManager *ndef,
+	bool fullbright)
 {
-	
-	u16 day = getInteriorLight(LIGHTBANK_DAY, n, increment, ndef);
-	u16 night = getInteriorLight(LIGHTBANK_NIGHT, n, increment, ndef);
+	u16 day = getInteriorLight(LIGHTBANK_DAY, n, increment, ndef, fullbright);
+	u16 night = getInteriorLight(LIGHTBANK_NIGHT, n, increment, ndef, fullbright);
 	return day | (night << 8);
 }
 
@@ -119,10 +128,11 @@ u16 getInteriorLight(MapNode n, s32 increment, const NodeDefManager *ndef)
 	Calculate non-smooth lighting at face of node.
 	Single light bank.
 */
-static u8 getFaceLight(enum LightBank bank, MapNode n, MapNode n2, const NodeDefManager *ndef)
+static u8 getFaceLight(enum LightBank bank, MapNode n, MapNode n2,
+	const NodeDefManager *ndef, bool fullbright)
 {
-	if (g_settings->getBool("fullbright"))
-	return 255;
+	if (fullbright)
+		return 255;
 
 	ContentLightingFlags f1 = ndef->getLightingFlags(n);
 	ContentLightingFlags f2 = ndef->getLightingFlags(n2);
@@ -140,17 +150,18 @@ static u8 getFaceLight(enum LightBank bank, MapNode n, MapNode n2, const NodeDef
 	if(light_source > light)
 		light = light_source;
 
-	return decode_light(light);
+	return decode_light(light, false);
 }
 
 /*
 	Calculate non-smooth lighting at face of node.
 	Both light banks.
 */
-u16 getFaceLight(MapNode n, MapNode n2, const NodeDefManager *ndef)
+u16 getFaceLight(MapNode n, MapNode n2, const NodeDefManager *ndef,
+	bool fullbright)
 {
-	u16 day = getFaceLight(LIGHTBANK_DAY, n, n2, ndef);
-	u16 night = getFaceLight(LIGHTBANK_NIGHT, n, n2, ndef);
+	u16 day = getFaceLight(LIGHTBANK_DAY, n, n2, ndef, fullbright);
+	u16 night = getFaceLight(LIGHTBANK_NIGHT, n, n2, ndef, fullbright);
 	return day | (night << 8);
 }
 
@@ -162,6 +173,7 @@ static u16 getSmoothLightCombined(const v3s16 &p,
 	const std::array<v3s16,8> &dirs, MeshMakeData *data)
 {
 	const NodeDefManager *ndef = data->m_nodedef;
+	const bool fullbright = data->m_fullbright;
 
 	u16 ambient_occlusion = 0;
 	u16 light_count = 0;
@@ -187,8 +199,8 @@ static u16 getSmoothLightCombined(const v3s16 &p,
 			u8 light_level_night = n.getLight(LIGHTBANK_NIGHT, f.getLightingFlags());
 			if (light_level_day == LIGHT_SUN)
 				direct_sunlight = true;
-			light_day += decode_light(light_level_day);
-			light_night += decode_light(light_level_night);
+			light_day += decode_light(light_level_day, fullbright);
+			light_night += decode_light(light_level_night, fullbright);
 			light_count++;
 		} else {
 			ambient_occlusion++;
@@ -226,14 +238,14 @@ static u16 getSmoothLightCombined(const v3s16 &p,
 
 	// Boost brightness around light sources
 	bool skip_ambient_occlusion_day = false;
-	if (decode_light(light_source_max) >= light_day) {
-		light_day = decode_light(light_source_max);
+	if (decode_light(light_source_max, fullbright) >= light_day) {
+		light_day = decode_light(light_source_max, fullbright);
 		skip_ambient_occlusion_day = true;
 	}
 
 	bool skip_ambient_occlusion_night = false;
-	if(decode_light(light_source_max) >= light_night) {
-		light_night = decode_light(light_source_max);
+	if(decode_light(light_source_max, fullbright) >= light_night) {
+		light_night = decode_light(light_source_max, fullbright);
 		skip_ambient_occlusion_night = true;
 	}
 
@@ -432,23 +444,7 @@ void getNodeTile(MapNode mn, const v3s16 &p, const v3s16 &dir, MeshMakeData *dat
 	getNodeTileN(mn, p, dir_to_tile[facedir][dir_i].tile, data, tile);
 	tile.rotation = tile.world_aligned ? TileRotation::None : dir_to_tile[facedir][dir_i].rotation;
 }
-std::set<content_t> splitToContentT(std::string str, const NodeDefManager *ndef)
-{
-	str += "\n";
-	std::set<content_t> dat;
-	std::string buf;
-	for (char c : str) {
-		if (c == ',' || c == '\n') {
-			if (! buf.empty()) {
-				dat.insert(ndef->getId(buf));
-			}
-			buf.clear();
-		} else if (c != ' ') {
-			buf += c;
-		}
-	}
-	return dat;
-}
+
 /*
 	MapBlockBspTree
 */
@@ -581,26 +577,32 @@ s32 MapBlockBspTree::buildTree(v3f normal, v3f origin, float delta, const std::v
 	return nodes.size() - 1;
 }
 
-void MapBlockBspTree::traverse(s32 node, v3f viewpoint, std::vector<s32> &output) const
+void MapBlockBspTree::traverse(s32 node, v3f viewpoint, std::vector<s32> &output,
+		f32 &safe_radius) const
 {
 	if (node < 0) return; // recursion break;
 
 	const TreeNode &n = nodes[node];
 	float factor = n.normal.dotProduct(viewpoint - n.origin);
 
+	// The side of a leaf only decides whether its triangles are skipped
+	// when seen edge-on, so only the planes of inner nodes matter
+	if (n.front_ref >= 0 || n.back_ref >= 0)
+		safe_radius = std::min(safe_radius, std::fabs(factor));
+
 	if (factor > 0)
-		traverse(n.back_ref, viewpoint, output);
+		traverse(n.back_ref, viewpoint, output, safe_radius);
 	else
-		traverse(n.front_ref, viewpoint, output);
+		traverse(n.front_ref, viewpoint, output, safe_radius);
 
 	if (factor != 0)
 		for (s32 i : n.triangle_refs)
 			output.push_back(i);
 
 	if (factor > 0)
-		traverse(n.front_ref, viewpoint, output);
+		traverse(n.front_ref, viewpoint, output, safe_radius);
 	else
-		traverse(n.back_ref, viewpoint, output);
+		traverse(n.back_ref, viewpoint, output, safe_radius);
 }
 
 
@@ -620,6 +622,76 @@ void PartialMeshBuffer::draw(video::IVideoDriver *driver) const
 	MapBlockMesh
 */
 
+// Sides of a node (in draw3DBox order) whose neighbor has a different content
+static u8 get_differing_sides(MeshMakeData *data, v3s16 p, MapNode n)
+{
+	static const v3s16 dirs[6] = {
+		v3s16(0, 0, -1), v3s16(0, 0, 1), v3s16(-1, 0, 0),
+		v3s16(1, 0, 0), v3s16(0, 1, 0), v3s16(0, -1, 0)
+	};
+	u8 sides = 0;
+	for (int i = 0; i < 6; i++) {
+		if (data->m_vmanip.getNodeNoExNoEmerge(p + dirs[i]).getContent() != n.getContent())
+			sides |= 1 << i;
+	}
+	return sides;
+}
+
+// Same as MapNode::getNeighbors, but reads from the meshgen area
+static u8 get_connected_neighbors(MeshMakeData *data, v3s16 p, MapNode n)
+{
+	const NodeDefManager *ndef = data->m_nodedef;
+	const ContentFeatures &f = ndef->get(n);
+	if (f.drawtype != NDT_NODEBOX || f.node_box.type != NODEBOX_CONNECTED)
+		return 0;
+
+	static const std::pair<v3s16, u8> dirs[6] = {
+		{v3s16(0, 1, 0), 1}, {v3s16(0, -1, 0), 2}, {v3s16(0, 0, -1), 4},
+		{v3s16(-1, 0, 0), 8}, {v3s16(0, 0, 1), 16}, {v3s16(1, 0, 0), 32}
+	};
+	u8 neighbors = 0;
+	for (auto &dir : dirs) {
+		MapNode n2 = data->m_vmanip.getNodeNoExNoEmerge(p + dir.first);
+		if (ndef->nodeboxConnects(n, n2, dir.second))
+			neighbors |= dir.second;
+	}
+	return neighbors;
+}
+
+/*
+	Creates a mesh buffer from the collected geometry, in the compact vertex
+	format if one is given. The index buffer is left empty if `with_indices`
+	is false.
+*/
+static scene::IMeshBuffer *createMeshBuffer(const PreMeshBuffer &p,
+		const CompactVertexFormat *compact_format, bool with_indices)
+{
+	if (!compact_format) {
+		auto *buf = new scene::SMeshBuffer();
+		if (with_indices) {
+			buf->append(&p.vertices[0], p.vertices.size(),
+				&p.indices[0], p.indices.size());
+		} else {
+			buf->append(&p.vertices[0], p.vertices.size(), nullptr, 0);
+		}
+		return buf;
+	}
+
+	auto *buf = new scene::SMeshBufferCompact();
+	auto &vertices = buf->Vertices->Data;
+	vertices.reserve(p.vertices.size());
+	// Packed positions can't be read back, so the box is computed here
+	aabb3f box(p.vertices[0].Pos);
+	for (const video::S3DVertex &v : p.vertices) {
+		vertices.push_back(compact_format->pack(v));
+		box.addInternalPoint(v.Pos);
+	}
+	buf->setBoundingBox(box);
+	if (with_indices)
+		buf->Indices->Data = p.indices;
+	return buf;
+}
+
 MapBlockMesh::MapBlockMesh(Client *client, MeshMakeData *data):
 	m_tsrc(client->getTextureSource()),
 	m_shdrsrc(client->getShaderSource()),
@@ -629,11 +701,15 @@ MapBlockMesh::MapBlockMesh(Client *client, MeshMakeData *data):
 {
 	ZoneScoped;
 
-	std::set<content_t> nodeESPSet = splitToContentT(g_settings->get("enable_node_esp.nodes"), data->m_nodedef);
+	static const ContentFilter empty_filter;
+	const ContentFilter &esp_filter = data->m_filter ? data->m_filter->node_esp : empty_filter;
+	const ContentFilter &xray_filter = data->m_filter ? data->m_filter->xray : empty_filter;
 
 	for (auto &m : m_mesh)
 		m = make_irr<scene::SMesh>();
 
+	const CompactVertexFormat *compact_format = client->getCompactVertexFormat();
+
 	auto mesh_grid = data->m_mesh_grid;
 	v3s16 bp = data->m_blockpos;
 	// Only generate minimap mapblocks at grid aligned coordinates.
@@ -656,30 +732,42 @@ MapBlockMesh::MapBlockMesh(Client *client, MeshMakeData *data):
 		}
 	}
 
-
-		/*
+	/*
 		NodeESP
 	*/
-	{
+	if (!esp_filter.empty()) {
+		const NodeDefManager *ndef = data->m_nodedef;
 		v3s16 blockpos_nodes = data->m_blockpos * MAP_BLOCKSIZE;
-		for (s16 x = 0; x < MAP_BLOCKSIZE; x++) {
-			for (s16 y = 0; y < MAP_BLOCKSIZE; y++) {
-				for (s16 z = 0; z < MAP_BLOCKSIZE; z++) {
-					v3s16 pos = v3s16(x, y, z) + blockpos_nodes;
-					const MapNode &node = data->m_vmanip.getNodeRefUnsafeCheckFlags(pos);
-					if (nodeESPSet.find(node.getContent()) != nodeESPSet.end())
-						esp_nodes.insert(pos);
-				}
+		// Overlay positions are relative to the mesh grid cell, like the mesh
+		v3f origin = intToFloat(mesh_grid.getMeshPos(bp) * MAP_BLOCKSIZE, BS);
+		std::vector<aabb3f> boxes;
+		v3s16 ofs;
+		for (ofs.Z = 0; ofs.Z < data->m_side_length; ofs.Z++)
+		for (ofs.Y = 0; ofs.Y < data->m_side_length; ofs.Y++)
+		for (ofs.X = 0; ofs.X < data->m_side_length; ofs.X++) {
+			v3s16 pos = blockpos_nodes + ofs;
+			const MapNode &node = data->m_vmanip.getNodeRefUnsafeCheckFlags(pos);
+			if (!esp_filter.contains(node.getContent()))
+				continue;
+
+			// Nodes enclosed by the same content are not highlighted
+			u8 sides = get_differing_sides(data, pos, node);
+			if (!sides)
+				continue;
+
+			boxes.clear();
+			node.getSelectionBoxes(ndef, &boxes, get_connected_neighbors(data, pos, node));
+			video::SColor color = ndef->get(node).getNodeEspColor();
+			v3f node_pos = intToFloat(pos, BS) - origin;
+			for (aabb3f box : boxes) {
+				box.MinEdge += node_pos;
+				box.MaxEdge += node_pos;
+				m_overlay.addBox(box, color, sides);
+				m_overlay_targets.push_back({box.getCenter(), color});
 			}
 		}
 	}
-/*
-	  X-Ray settings
-	*/
-	std::set<content_t> xraySet;
-	if (g_settings->getBool("xray"))
-		xraySet = splitToContentT(
-			g_settings->get("xray.nodes"), data->m_nodedef);
+
 	// algin vertices to mesh grid, not meshgen area
 	v3f offset = intToFloat((data->m_blockpos - mesh_grid.getMeshPos(data->m_blockpos)) * MAP_BLOCKSIZE, BS);
 
@@ -687,7 +775,7 @@ MapBlockMesh::MapBlockMesh(Client *client, MeshMakeData *data):
 
 	{
 		// Generate everything
-		MapblockMeshGenerator(data, &collector).generate(xraySet);
+		MapblockMeshGenerator(data, &collector).generate(xray_filter);
 	}
 
 	/*
@@ -746,11 +834,11 @@ MapBlockMesh::MapBlockMesh(Client *client, MeshMakeData *data):
 				p.layer.applyMaterialOptions(material, layer);
 			}
 
-			scene::SMeshBuffer *buf = new scene::SMeshBuffer();
-			buf->Material = material;
-			if (p.layer.isTransparent()) {
-				buf->append(&p.vertices[0], p.vertices.size(), nullptr, 0);
-
+			// Transparent triangles are indexed by the BSP tree instead
+			const bool transparent = p.layer.isTransparent();
+			scene::IMeshBuffer *buf = createMeshBuffer(p, compact_format, !transparent);
+			buf->getMaterial() = material;
+			if (transparent) {
 				MeshTriangle t;
 				t.buffer = buf;
 				m_transparent_triangles.reserve(p.indices.size() / 3);
@@ -758,12 +846,10 @@ MapBlockMesh::MapBlockMesh(Client *client, MeshMakeData *data):
 					t.p1 = p.indices[i];
 					t.p2 = p.indices[i + 1];
 					t.p3 = p.indices[i + 2];
-					t.updateAttributes();
+					t.updateAttributes(p.vertices[t.p1].Pos,
+							p.vertices[t.p2].Pos, p.vertices[t.p3].Pos);
 					m_transparent_triangles.push_back(t);
 				}
-			} else {
-				buf->append(&p.vertices[0], p.vertices.size(),
-					&p.indices[0], p.indices.size());
 			}
 			mesh->addMeshBuffer(buf);
 			buf->drop();
@@ -840,31 +926,37 @@ bool MapBlockMesh::animate(bool faraway, float time, int crack,
 	return true;
 }
 
-void MapBlockMesh::updateTransparentBuffers(v3f camera_pos, v3s16 block_pos,
+bool MapBlockMesh::sortTransparentTriangles(v3f camera_pos, v3s16 block_pos,
 		bool group_by_buffers)
 {
 	// nothing to do if the entire block is opaque
 	if (m_transparent_triangles.empty())
-		return;
+		return false;
 
 	v3f block_posf = intToFloat(block_pos * MAP_BLOCKSIZE, BS);
 	v3f rel_camera_pos = camera_pos - block_posf;
 
-	std::vector<s32> triangle_refs;
-	m_bsp_tree.traverse(rel_camera_pos, triangle_refs);
+	// reuse the last order as long as no splitting plane was crossed
+	if (!m_transparent_buffers_consolidated && !m_transparent_buffers.empty() &&
+			group_by_buffers == m_sorted_group_by_buffers &&
+			rel_camera_pos.getDistanceFrom(m_sorted_viewpoint) < m_sorted_radius)
+		return false;
 
-	// arrange index sequences into partial buffers
-	m_transparent_buffers_consolidated = false;
-	m_transparent_buffers.clear();
+	std::vector<s32> triangle_refs;
+	m_sorted_radius = m_bsp_tree.traverse(rel_camera_pos, triangle_refs);
+	m_sorted_viewpoint = rel_camera_pos;
+	m_sorted_group_by_buffers = group_by_buffers;
 
-	std::vector<std::pair<scene::SMeshBuffer *, std::vector<u16>>> ordered_strains;
-	std::unordered_map<scene::SMeshBuffer *, size_t> strain_idxs;
+	// arrange index sequences into strains per buffer
+	auto &ordered_strains = m_sorted_strains;
+	ordered_strains.clear();
+	std::unordered_map<scene::IMeshBuffer *, size_t> strain_idxs;
 
 	if (group_by_buffers) {
 		// find (reversed) order for strains, by iterating front-to-back
 		// (if a buffer A has a triangle nearer than all triangles of another
 		// buffer B, A should be drawn in front of (=after) B)
-		scene::SMeshBuffer *current_buffer = nullptr;
+		scene::IMeshBuffer *current_buffer = nullptr;
 		for (auto it = triangle_refs.rbegin(); it != triangle_refs.rend(); ++it) {
 			const auto &t = m_transparent_triangles[*it];
 			if (current_buffer == t.buffer)
@@ -878,7 +970,7 @@ void MapBlockMesh::updateTransparentBuffers(v3f camera_pos, v3s16 block_pos,
 	}
 
 	// find order for triangles, by iterating back-to-front
-	scene::SMeshBuffer *current_buffer = nullptr;
+	scene::IMeshBuffer *current_buffer = nullptr;
 	std::vector<u16> *current_strain = nullptr;
 	for (auto i : triangle_refs) {
 		const auto &t = m_transparent_triangles[i];
@@ -898,15 +990,21 @@ void MapBlockMesh::updateTransparentBuffers(v3f camera_pos, v3s16 block_pos,
 		current_strain->push_back(t.p3);
 	}
 
-	m_transparent_buffers.reserve(ordered_strains.size());
 	if (group_by_buffers) {
 		// the order was reversed
-		for (auto it = ordered_strains.rbegin(); it != ordered_strains.rend(); ++it)
-			m_transparent_buffers.emplace_back(it->first, std::move(it->second));
-	} else {
-		for (auto it = ordered_strains.begin(); it != ordered_strains.end(); ++it)
-			m_transparent_buffers.emplace_back(it->first, std::move(it->second));
+		std::reverse(ordered_strains.begin(), ordered_strains.end());
 	}
+	return true;
+}
+
+void MapBlockMesh::applyTransparentOrder()
+{
+	m_transparent_buffers_consolidated = false;
+	m_transparent_buffers.clear();
+	m_transparent_buffers.reserve(m_sorted_strains.size());
+	for (auto &strain : m_sorted_strains)
+		m_transparent_buffers.emplace_back(strain.first, std::move(strain.second));
+	m_sorted_strains.clear();
 }
 
 void MapBlockMesh::consolidateTransparentBuffers()
@@ -915,7 +1013,7 @@ void MapBlockMesh::consolidateTransparentBuffers()
 		return;
 	m_transparent_buffers.clear();
 
-	scene::SMeshBuffer *current_buffer = nullptr;
+	scene::IMeshBuffer *current_buffer = nullptr;
 	std::vector<u16> current_strain;
 
 	// use the fact that m_transparent_triangles is already arranged by buffer
@@ -995,3 +1093,74 @@ u8 get_solid_sides(MeshMakeData *data)
 	}
 	return result;
 }
+
+std::vector<content_t> get_mesh_contents(MeshMakeData *data)
+{
+	v3s16 blockpos_nodes = data->m_blockpos * MAP_BLOCKSIZE;
+	const s16 side = data->m_side_length;
+
+	std::vector<content_t> result;
+	content_t last = CONTENT_IGNORE;
+	v3s16 p;
+	for (p.Z = -1; p.Z <= side; p.Z++)
+	for (p.Y = -1; p.Y <= side; p.Y++)
+	for (p.X = -1; p.X <= side; p.X++) {
+		content_t c = data->m_vmanip.getNodeNoExNoEmerge(blockpos_nodes + p).getContent();
+		// skip runs of the same content to keep the list short before sorting
+		if (c == last)
+			continue;
+		last = c;
+		result.push_back(c);
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+std::vector<std::pair<v3s16, std::shared_ptr<const BlockOpacity>>>
+		get_block_opacity(MeshMakeData *data)
+{
+	static const auto empty = [] {
+		auto o = std::make_shared<BlockOpacity>();
+		o->empty = true;
+		return o;
+	}();
+	static const auto full = [] {
+		auto o = std::make_shared<BlockOpacity>();
+		o->nodes.set();
+		o->full = true;
+		return o;
+	}();
+
+	const NodeDefManager *ndef = data->m_nodedef;
+	const s16 cell_size = data->m_side_length / MAP_BLOCKSIZE;
+
+	std::vector<std::pair<v3s16, std::shared_ptr<const BlockOpacity>>> result;
+	result.reserve(cell_size * cell_size * cell_size);
+
+	v3s16 offset;
+	for (offset.Z = 0; offset.Z < cell_size; offset.Z++)
+	for (offset.Y = 0; offset.Y < cell_size; offset.Y++)
+	for (offset.X = 0; offset.X < cell_size; offset.X++) {
+		v3s16 blockpos = data->m_blockpos + offset;
+		v3s16 blockpos_nodes = blockpos * MAP_BLOCKSIZE;
+		auto opacity = std::make_shared<BlockOpacity>();
+		u32 i = 0;
+		v3s16 p;
+		for (p.Z = 0; p.Z < MAP_BLOCKSIZE; p.Z++)
+		for (p.Y = 0; p.Y < MAP_BLOCKSIZE; p.Y++)
+		for (p.X = 0; p.X < MAP_BLOCKSIZE; p.X++, i++) {
+			const MapNode &n = data->m_vmanip.getNodeRefUnsafe(blockpos_nodes + p);
+			if (!ndef->getLightingFlags(n).light_propagates)
+				opacity->nodes[i] = true;
+		}
+
+		if (opacity->nodes.none())
+			result.emplace_back(blockpos, empty);
+		else if (opacity->nodes.all())
+			result.emplace_back(blockpos, full);
+		else
+			result.emplace_back(blockpos, std::move(opacity));
+	}
+	return result;
+}
@@ -11,9 +11,13 @@
 
 #include "util/numeric.h"
 #include "client/tile.h"
+#include "client/meshgen/overlay_buffer.h"
 #include "voxel.h"
 #include <array>
+#include <bitset>
+#include <limits>
 #include <map>
+#include <memory>
 #include <unordered_map>
 
 namespace irr::video {
@@ -24,6 +28,7 @@ class Client;
 class NodeDefManager;
 class IShaderSource;
 class ITextureSource;
+struct MeshFilterContext;
 
 /*
 	Mesh making stuff
@@ -35,12 +40,17 @@ struct MinimapMapblock;
 
 struct MeshMakeData
 {
+	// Width of the border around the meshgen area that is filled in, in nodes.
+	// Node neighbors are one node away, but rooted plantlike nodes are lit
+	// from the node above them, which needs another one.
+	static constexpr s16 HALO = 2;
+
 	VoxelManipulator m_vmanip;
 
 	// base pos of meshgen area, in blocks
 	v3s16 m_blockpos = v3s16(-1337,-1337,-1337);
 	// size of meshgen area, in nodes.
-	// vmanip will have at least an extra 1 node onion layer.
+	// vmanip will have an extra HALO nodes thick onion layer.
 	// area is expected to fit into mesh grid cell.
 	u16 m_side_length;
 	// vertex positions will be relative to this grid
@@ -50,17 +60,26 @@ struct MeshMakeData
 	v3s16 m_crack_pos_relative = v3s16(-1337,-1337,-1337);
 	bool m_generate_minimap = false;
 	bool m_smooth_lighting = false;
+	// light every node as if it was in sunlight
+	bool m_fullbright = false;
 	bool m_enable_water_reflections = false;
+	// merge faces of full nodes into larger quads
+	bool m_greedy_meshing = false;
 
 	const NodeDefManager *m_nodedef;
 
+	// Settings-driven node filters (X-Ray, node ESP), may be null
+	std::shared_ptr<const MeshFilterContext> m_filter;
+
 	MeshMakeData(const NodeDefManager *ndef, u16 side_lingth, MeshGrid mesh_grid);
 
 	/*
 		Copy block data manually (to allow optimizations by the caller)
+		Only the part of a block that lies within the meshgen area or its
+		border is copied.
 	*/
 	void fillBlockDataBegin(const v3s16 &blockpos);
-	void fillBlockData(const v3s16 &bp, MapNode *data);
+	void fillBlockData(const v3s16 &bp, const MapNode *data);
 
 	/*
 		Prepare block data for rendering a single node located at (0,0,0).
@@ -73,32 +92,25 @@ struct MeshMakeData
 	void setCrack(int crack_level, v3s16 crack_pos);
 };
 
-// represents a triangle as indexes into the vertex buffer in SMeshBuffer
+// represents a triangle as indexes into the vertex buffer of a mesh buffer
 class MeshTriangle
 {
 public:
-	scene::SMeshBuffer *buffer;
+	scene::IMeshBuffer *buffer;
 	u16 p1, p2, p3;
 	v3f centroid;
+	v3f normal;
 	float areaSQ;
 
-	void updateAttributes()
+	// The positions are passed in, as the buffer may store them packed
+	void updateAttributes(const v3f &v1, const v3f &v2, const v3f &v3)
 	{
-		v3f v1 = buffer->getPosition(p1);
-		v3f v2 = buffer->getPosition(p2);
-		v3f v3 = buffer->getPosition(p3);
-
 		centroid = (v1 + v2 + v3) / 3;
-		areaSQ = (v2-v1).crossProduct(v3-v1).getLengthSQ() / 4;
+		normal = (v2-v1).crossProduct(v3-v1);
+		areaSQ = normal.getLengthSQ() / 4;
 	}
 
-	v3f getNormal() const {
-		v3f v1 = buffer->getPosition(p1);
-		v3f v2 = buffer->getPosition(p2);
-		v3f v3 = buffer->getPosition(p3);
-
-		return (v2-v1).crossProduct(v3-v1);
-	}
+	v3f getNormal() const { return normal; }
 };
 
 /**
@@ -112,9 +124,15 @@ class MapBlockBspTree
 
 	void buildTree(const std::vector<MeshTriangle> *triangles, u16 side_lingth);
 
-	void traverse(v3f viewpoint, std::vector<s32> &output) const
+	/*
+		Appends the triangles in back-to-front order as seen from `viewpoint`.
+		Returns how far the viewpoint can move without changing the order.
+	*/
+	f32 traverse(v3f viewpoint, std::vector<s32> &output) const
 	{
-		traverse(root, viewpoint, output);
+		f32 safe_radius = std::numeric_limits<f32>::max();
+		traverse(root, viewpoint, output, safe_radius);
+		return safe_radius;
 	}
 
 private:
@@ -128,14 +146,16 @@ class MapBlockBspTree
 		s32 back_ref;
 
 		TreeNode() = default;
+		// The normal is stored normalized, so that the distance to the plane
+		// is known during traversal
 		TreeNode(v3f normal, v3f origin, const std::vector<s32> &triangle_refs, s32 front_ref, s32 back_ref) :
-				normal(normal), origin(origin), triangle_refs(triangle_refs), front_ref(front_ref), back_ref(back_ref)
+				normal(normal.normalize()), origin(origin), triangle_refs(triangle_refs), front_ref(front_ref), back_ref(back_ref)
 		{}
 	};
 
 
 	s32 buildTree(v3f normal, v3f origin, float delta, const std::vector<s32> &list, u32 depth);
-	void traverse(s32 node, v3f viewpoint, std::vector<s32> &output) const;
+	void traverse(s32 node, v3f viewpoint, std::vector<s32> &output, f32 &safe_radius) const;
 
 	const std::vector<MeshTriangle> *triangles = nullptr; // this reference is managed externally
 	std::vector<TreeNode> nodes; // list of nodes
@@ -151,7 +171,7 @@ class MapBlockBspTree
 class PartialMeshBuffer
 {
 public:
-	PartialMeshBuffer(scene::SMeshBuffer *buffer, std::vector<u16> &&vertex_indices) :
+	PartialMeshBuffer(scene::IMeshBuffer *buffer, std::vector<u16> &&vertex_indices) :
 			m_buffer(buffer), m_indices(make_irr<scene::SIndexBuffer>())
 	{
 		m_indices->Data = std::move(vertex_indices);
@@ -163,7 +183,7 @@ class PartialMeshBuffer
 	void draw(video::IVideoDriver *driver) const;
 
 private:
-	scene::SMeshBuffer *m_buffer;
+	scene::IMeshBuffer *m_buffer;
 	irr_ptr<scene::SIndexBuffer> m_indices;
 };
 
@@ -236,7 +256,22 @@ class MapBlockMesh
 	 *     buffers are ordered relative to each other (with respect to their nearest
 	 *     triangle).
 	 */
-	void updateTransparentBuffers(v3f camera_pos, v3s16 block_pos, bool group_by_buffers);
+	void updateTransparentBuffers(v3f camera_pos, v3s16 block_pos, bool group_by_buffers)
+	{
+		if (sortTransparentTriangles(camera_pos, block_pos, group_by_buffers))
+			applyTransparentOrder();
+	}
+
+	/** First half of updateTransparentBuffers(), which only computes the order.
+	 * Does not touch any Irrlicht objects, so it may run on a worker thread
+	 * (one thread per mesh at a time).
+	 * @return false if the current buffers are still in the right order,
+	 *     e.g. because the camera did not cross any splitting plane
+	 */
+	bool sortTransparentTriangles(v3f camera_pos, v3s16 block_pos, bool group_by_buffers);
+	/// Second half of updateTransparentBuffers(), must run on the main thread
+	void applyTransparentOrder();
+
 	void consolidateTransparentBuffers();
 
 	/// get the list of transparent buffers
@@ -245,7 +280,14 @@ class MapBlockMesh
 		return this->m_transparent_buffers;
 	}
 
-	std::set<v3s16> esp_nodes;
+	/// Node ESP boxes, positioned relative to the mesh like getMesh()
+	OverlayBuffer &getOverlay() { return m_overlay; }
+
+	/// Centers of the node ESP boxes, for drawing tracers
+	const std::vector<OverlayTarget> &getOverlayTargets() const
+	{
+		return m_overlay_targets;
+	}
 
 private:
 
@@ -280,6 +322,17 @@ class MapBlockMesh
 	std::vector<PartialMeshBuffer> m_transparent_buffers;
 	// Is m_transparent_buffers currently in consolidated form?
 	bool m_transparent_buffers_consolidated = false;
+	// Result of sortTransparentTriangles() that is not applied yet
+	std::vector<std::pair<scene::IMeshBuffer *, std::vector<u16>>> m_sorted_strains;
+	// Viewpoint (relative to the block) and settings of the last sort. The
+	// order stays valid while the viewpoint is within m_sorted_radius.
+	v3f m_sorted_viewpoint;
+	f32 m_sorted_radius = -1.0f;
+	bool m_sorted_group_by_buffers = false;
+
+	// Node ESP geometry, kept on the GPU as long as the mesh lives
+	OverlayBuffer m_overlay{true};
+	std::vector<OverlayTarget> m_overlay_targets;
 };
 
 /*!
@@ -297,8 +350,10 @@ class MapBlockMesh
 video::SColor encode_light(u16 light, u8 emissive_light);
 
 // Compute light at node
-u16 getInteriorLight(MapNode n, s32 increment, const NodeDefManager *ndef);
-u16 getFaceLight(MapNode n, MapNode n2, const NodeDefManager *ndef);
+u16 getInteriorLight(MapNode n, s32 increment, const NodeDefManager *ndef,
+		bool fullbright);
+u16 getFaceLight(MapNode n, MapNode n2, const NodeDefManager *ndef,
+		bool fullbright);
 u16 getSmoothLightSolid(const v3s16 &p, const v3s16 &face_dir, const v3s16 &corner, MeshMakeData *data);
 u16 getSmoothLightTransparent(const v3s16 &p, const v3s16 &corner, MeshMakeData *data);
 
@@ -339,3 +394,31 @@ void getNodeTile(MapNode mn, const v3s16 &p, const v3s16 &dir, MeshMakeData *dat
 /// Bits:
 /// 0 0 -Z +Z -X +X -Y +Y
 u8 get_solid_sides(MeshMakeData *data);
+
+/// Return the sorted content IDs found in the meshgen area including the
+/// one node border around it, i.e. everything the mesh depends on
+std::vector<content_t> get_mesh_contents(MeshMakeData *data);
+
+/// Nodes of a MapBlock that do not propagate light, one bit per node in
+/// MapBlock data order. Used by the client to test occlusion without
+/// looking up node definitions.
+struct BlockOpacity
+{
+	std::bitset<MAP_BLOCKSIZE * MAP_BLOCKSIZE * MAP_BLOCKSIZE> nodes;
+	// Summary for the common cases of air and underground blocks
+	bool empty = false;
+	bool full = false;
+
+	// p is relative to the block
+	bool isOpaque(v3s16 p) const
+	{
+		if (empty || full)
+			return full;
+		return nodes[p.Z * MAP_BLOCKSIZE * MAP_BLOCKSIZE + p.Y * MAP_BLOCKSIZE + p.X];
+	}
+};
+
+/// Return the opacity of every MapBlock in the meshgen area (without the
+/// border). Empty and fully opaque blocks share one instance each.
+std::vector<std::pair<v3s16, std::shared_ptr<const BlockOpacity>>>
+		get_block_opacity(MeshMakeData *data);
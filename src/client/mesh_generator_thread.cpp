@@ -4,6 +4,7 @@
 
 #include "mesh_generator_thread.h"
 #include "settings.h"
+#include "client/settings_snapshot.h"
 #include "profiler.h"
 #include "client.h"
 #include "mapblock.h"
@@ -41,18 +42,15 @@ MeshUpdateQueue::MeshUpdateQueue(Client *client):
 {
 	m_cache_smooth_lighting = g_settings->getBool("smooth_lighting");
 	m_cache_enable_water_reflections = g_settings->getBool("enable_water_reflections");
+	m_cache_greedy_meshing = g_settings->getBool("greedy_meshing");
 }
 
 MeshUpdateQueue::~MeshUpdateQueue()
 {
 	MutexAutoLock lock(m_mutex);
 
-	for (QueuedMeshUpdate *q : m_queue) {
-		for (auto block : q->map_blocks)
-			if (block)
-				block->refDrop();
-		delete q;
-	}
+	for (auto &it : m_queue)
+		delete it.second.q;
 }
 
 bool MeshUpdateQueue::addBlock(Map *map, v3s16 p, bool ack_block_to_server, bool urgent)
@@ -68,56 +66,28 @@ bool MeshUpdateQueue::addBlock(Map *map, v3s16 p, bool ack_block_to_server, bool
 	// Mesh is placed at the corner block of a chunk
 	// (where all coordinate are divisible by the chunk size)
 	v3s16 mesh_position(mesh_grid.getMeshPos(p));
-	/*
-		Mark the block as urgent if requested
-	*/
-	if (urgent)
-		m_urgents.insert(mesh_position);
 
 	/*
 		Find if block is already in queue.
 		If it is, update the data and quit.
 	*/
-	for (QueuedMeshUpdate *q : m_queue) {
-		if (q->p == mesh_position) {
-			// NOTE: We are not adding a new position to the queue, thus
-			//       refcount_from_queue stays the same.
-			if(ack_block_to_server)
-				q->ack_list.push_back(p);
-			q->crack_level = m_client->getCrackLevel();
-			q->crack_pos = m_client->getCrackPos();
-			q->urgent |= urgent;
-			v3s16 pos;
-			int i = 0;
-			for (pos.X = q->p.X - 1; pos.X <= q->p.X + mesh_grid.cell_size; pos.X++)
-			for (pos.Z = q->p.Z - 1; pos.Z <= q->p.Z + mesh_grid.cell_size; pos.Z++)
-			for (pos.Y = q->p.Y - 1; pos.Y <= q->p.Y + mesh_grid.cell_size; pos.Y++) {
-				if (!q->map_blocks[i]) {
-					MapBlock *block = map->getBlockNoCreateNoEx(pos);
-					if (block) {
-						block->refGrab();
-						q->map_blocks[i] = block;
-					}
-				}
-				i++;
-			}
-			return true;
+	auto existing = m_queue.find(mesh_position);
+	if (existing != m_queue.end()) {
+		QueuedMeshUpdate *q = existing->second.q;
+		// NOTE: We are not adding a new position to the queue, thus
+		//       refcount_from_queue stays the same.
+		if(ack_block_to_server)
+			q->ack_list.push_back(p);
+		q->crack_level = m_client->getCrackLevel();
+		q->crack_pos = m_client->getCrackPos();
+		// Blocks may have changed or appeared since
+		q->block_data = getBlockData(map, mesh_position);
+		// Move to the urgent lane if requested
+		if (urgent && !q->urgent) {
+			q->urgent = true;
+			schedule(mesh_position, existing->second, true);
 		}
-	}
-
-	/*
-		Make a list of blocks necessary for mesh generation and lock the blocks in memory.
-	*/
-	std::vector<MapBlock *> map_blocks;
-	map_blocks.reserve((mesh_grid.cell_size+2)*(mesh_grid.cell_size+2)*(mesh_grid.cell_size+2));
-	v3s16 pos;
-	for (pos.X = mesh_position.X - 1; pos.X <= mesh_position.X + mesh_grid.cell_size; pos.X++)
-	for (pos.Z = mesh_position.Z - 1; pos.Z <= mesh_position.Z + mesh_grid.cell_size; pos.Z++)
-	for (pos.Y = mesh_position.Y - 1; pos.Y <= mesh_position.Y + mesh_grid.cell_size; pos.Y++) {
-		MapBlock *block = map->getBlockNoCreateNoEx(pos);
-		map_blocks.push_back(block);
-		if (block)
-			block->refGrab();
+		return true;
 	}
 
 	/*
@@ -130,8 +100,14 @@ bool MeshUpdateQueue::addBlock(Map *map, v3s16 p, bool ack_block_to_server, bool
 	q->crack_level = m_client->getCrackLevel();
 	q->crack_pos = m_client->getCrackPos();
 	q->urgent = urgent;
-	q->map_blocks = std::move(map_blocks);
-	m_queue.push_back(q);
+	q->block_data = getBlockData(map, mesh_position);
+	auto &entry = m_queue[mesh_position];
+	entry.q = q;
+	schedule(mesh_position, entry, true);
+
+	// Don't let outdated heap nodes pile up
+	if (m_heap.size() + m_urgent_heap.size() > 2 * m_queue.size() + 64)
+		rebuildHeaps();
 
 	return true;
 }
@@ -144,20 +120,9 @@ QueuedMeshUpdate *MeshUpdateQueue::pop()
 	{
 		MutexAutoLock lock(m_mutex);
 
-		bool must_be_urgent = !m_urgents.empty();
-		for (auto i = m_queue.begin(); i != m_queue.end(); ++i) {
-			QueuedMeshUpdate *q = *i;
-			if (must_be_urgent && m_urgents.count(q->p) == 0)
-				continue;
-			// Make sure no two threads are processing the same mapblock, as that causes racing conditions
-			if (m_inflight_blocks.find(q->p) != m_inflight_blocks.end())
-				continue;
-			m_queue.erase(i);
-			m_urgents.erase(q->p);
-			m_inflight_blocks.insert(q->p);
-			result = q;
-			break;
-		}
+		result = popFrom(m_urgent_heap);
+		if (!result)
+			result = popFrom(m_heap);
 	}
 
 	if (result)
@@ -170,6 +135,113 @@ void MeshUpdateQueue::done(v3s16 pos)
 {
 	MutexAutoLock lock(m_mutex);
 	m_inflight_blocks.erase(pos);
+
+	// An update that arrived meanwhile can go now
+	if (m_deferred.erase(pos) > 0) {
+		auto it = m_queue.find(pos);
+		if (it != m_queue.end())
+			schedule(pos, it->second, false);
+	}
+}
+
+std::vector<std::shared_ptr<const MapNode[]>> MeshUpdateQueue::getBlockData(
+		Map *map, v3s16 mesh_position)
+{
+	MeshGrid mesh_grid = m_client->getMeshGrid();
+
+	std::vector<std::shared_ptr<const MapNode[]>> block_data;
+	block_data.reserve((mesh_grid.cell_size+2)*(mesh_grid.cell_size+2)*(mesh_grid.cell_size+2));
+	v3s16 pos;
+	for (pos.X = mesh_position.X - 1; pos.X <= mesh_position.X + mesh_grid.cell_size; pos.X++)
+	for (pos.Z = mesh_position.Z - 1; pos.Z <= mesh_position.Z + mesh_grid.cell_size; pos.Z++)
+	for (pos.Y = mesh_position.Y - 1; pos.Y <= mesh_position.Y + mesh_grid.cell_size; pos.Y++) {
+		MapBlock *block = map->getBlockNoCreateNoEx(pos);
+		block_data.push_back(block ? block->getNodeSnapshot() : nullptr);
+	}
+	return block_data;
+}
+
+void MeshUpdateQueue::setCameraBlock(v3s16 blockpos)
+{
+	MutexAutoLock lock(m_mutex);
+	v3s16 mesh_pos = m_client->getMeshGrid().getMeshPos(blockpos);
+	if (mesh_pos == m_camera_mesh_pos)
+		return;
+	m_camera_mesh_pos = mesh_pos;
+	// All distances changed
+	rebuildHeaps();
+}
+
+void MeshUpdateQueue::schedule(v3s16 p, QueueEntry &entry, bool new_seq)
+{
+	if (new_seq)
+		entry.seq = m_next_seq++;
+
+	// Make sure no two threads are processing the same mapblock, as that causes racing conditions
+	if (m_inflight_blocks.count(p) > 0) {
+		m_deferred.insert(p);
+		return;
+	}
+
+	v3s32 d = v3s32(p.X, p.Y, p.Z) -
+			v3s32(m_camera_mesh_pos.X, m_camera_mesh_pos.Y, m_camera_mesh_pos.Z);
+	HeapNode node{(u32)d.getLengthSQ(), entry.seq, p};
+	if (entry.q->urgent)
+		m_urgent_heap.push(node);
+	else
+		m_heap.push(node);
+}
+
+QueuedMeshUpdate *MeshUpdateQueue::popFrom(std::priority_queue<HeapNode> &heap)
+{
+	while (!heap.empty()) {
+		HeapNode node = heap.top();
+		heap.pop();
+
+		auto it = m_queue.find(node.p);
+		if (it == m_queue.end() || it->second.seq != node.seq)
+			continue; // outdated
+
+		QueuedMeshUpdate *q = it->second.q;
+		m_queue.erase(it);
+		m_inflight_blocks.insert(q->p);
+		return q;
+	}
+	return nullptr;
+}
+
+void MeshUpdateQueue::rebuildHeaps()
+{
+	m_heap = {};
+	m_urgent_heap = {};
+	for (auto &it : m_queue) {
+		if (m_deferred.count(it.first) == 0)
+			schedule(it.first, it.second, false);
+	}
+}
+
+std::optional<ContentFilter> MeshUpdateQueue::updateFilter()
+{
+	MutexAutoLock lock(m_mutex);
+	auto old_filter = std::move(m_filter);
+	m_filter = MeshFilterContext::create(m_client->ndef());
+	if (!old_filter)
+		return std::nullopt;
+
+	ContentFilter changed = ContentFilter::symmetricDifference(
+			old_filter->xray, m_filter->xray);
+	changed.merge(ContentFilter::symmetricDifference(
+			old_filter->node_esp, m_filter->node_esp));
+	return changed;
+}
+
+std::shared_ptr<const MeshFilterContext> MeshUpdateQueue::getFilter()
+{
+	MutexAutoLock lock(m_mutex);
+	// Built lazily, as node definitions are not available at construction
+	if (!m_filter)
+		m_filter = MeshFilterContext::create(m_client->ndef());
+	return m_filter;
 }
 
 
@@ -187,14 +259,19 @@ void MeshUpdateQueue::fillDataFromMapBlocks(QueuedMeshUpdate *q)
 	for (pos.X = q->p.X - 1; pos.X <= q->p.X + mesh_grid.cell_size; pos.X++)
 	for (pos.Z = q->p.Z - 1; pos.Z <= q->p.Z + mesh_grid.cell_size; pos.Z++)
 	for (pos.Y = q->p.Y - 1; pos.Y <= q->p.Y + mesh_grid.cell_size; pos.Y++) {
-		MapBlock *block = q->map_blocks[i++];
-		data->fillBlockData(pos, block ? block->getData() : block_placeholder.data);
+		const MapNode *block_data = q->block_data[i++].get();
+		data->fillBlockData(pos, block_data ? block_data : block_placeholder.data);
 	}
+	// Not needed anymore, let the blocks drop outdated copies
+	q->block_data.clear();
 
 	data->setCrack(q->crack_level, q->crack_pos);
 	data->m_generate_minimap = !!m_client->getMinimap();
 	data->m_smooth_lighting = m_cache_smooth_lighting;
+	data->m_fullbright = SettingsSnapshot::get()->fullbright;
 	data->m_enable_water_reflections = m_cache_enable_water_reflections;
+	data->m_greedy_meshing = m_cache_greedy_meshing;
+	data->m_filter = getFilter();
 }
 
 /*
@@ -225,9 +302,10 @@ void MeshUpdateWorkerThread::doUpdate()
 		r.p = q->p;
 		r.mesh = mesh_new;
 		r.solid_sides = get_solid_sides(q->data);
+		r.contents = get_mesh_contents(q->data);
+		r.opacity = get_block_opacity(q->data);
 		r.ack_list = std::move(q->ack_list);
 		r.urgent = q->urgent;
-		r.map_blocks = q->map_blocks;
 
 		m_manager->putResult(r);
 		m_queue_in->done(q->p);
@@ -6,13 +6,16 @@
 
 #include <ctime>
 #include <mutex>
+#include <queue>
 #include <unordered_map>
 #include <unordered_set>
 #include "mapblock_mesh.h"
+#include "client/meshgen/content_filter.h"
 #include "threading/mutex_auto_lock.h"
 #include "util/thread.h"
 #include <vector>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 struct QueuedMeshUpdate
@@ -22,7 +25,8 @@ struct QueuedMeshUpdate
 	int crack_level = -1;
 	v3s16 crack_pos;
 	MeshMakeData *data = nullptr; // This is generated in MeshUpdateQueue::pop()
-	std::vector<MapBlock *> map_blocks;
+	// Node data of the cell and the surrounding blocks, null for missing blocks
+	std::vector<std::shared_ptr<const MapNode[]>> block_data;
 	bool urgent = false;
 
 	QueuedMeshUpdate() = default;
@@ -31,6 +35,11 @@ struct QueuedMeshUpdate
 
 /*
 	A thread-safe queue of mesh update tasks and a cache of MapBlock data
+
+	Updates are keyed by mesh position, so that repeated requests for the same
+	mesh are merged. Urgent updates are handed out first, otherwise the mesh
+	closest to the camera goes first. Updates of meshes that are being
+	generated right now wait aside until that is done.
 */
 class MeshUpdateQueue
 {
@@ -56,6 +65,13 @@ class MeshUpdateQueue
 	// Marks a position as finished, unblocking the next update
 	void done(v3s16 pos);
 
+	// Sets the block the camera is in, which the updates are ordered by
+	void setCameraBlock(v3s16 blockpos);
+
+	// Rebuilds the filter snapshot from the settings. Returns the content IDs
+	// whose filtering changed, or nothing if there was no previous snapshot.
+	std::optional<ContentFilter> updateFilter();
+
 	u32 size()
 	{
 		MutexAutoLock lock(m_mutex);
@@ -63,17 +79,63 @@ class MeshUpdateQueue
 	}
 
 private:
+	struct QueueEntry
+	{
+		QueuedMeshUpdate *q;
+		// Identifies the current heap node of the entry, see HeapNode
+		u64 seq;
+	};
+
+	struct HeapNode
+	{
+		u32 distance_sq;
+		// Older entries go first among equally distant ones. A node is
+		// outdated if its seq does not match the one of the entry anymore.
+		u64 seq;
+		v3s16 p;
+
+		bool operator<(const HeapNode &other) const
+		{
+			// std::priority_queue puts the greatest element on top
+			if (distance_sq != other.distance_sq)
+				return distance_sq > other.distance_sq;
+			return seq > other.seq;
+		}
+	};
+
+	// Collects the node data needed for the mesh at mesh_position
+	std::vector<std::shared_ptr<const MapNode[]>> getBlockData(Map *map,
+			v3s16 mesh_position);
+
+	// Pushes the entry at p to the heap of its lane
+	void schedule(v3s16 p, QueueEntry &entry, bool new_seq);
+	// Takes the next valid entry from a heap, or returns nullptr
+	QueuedMeshUpdate *popFrom(std::priority_queue<HeapNode> &heap);
+	// Rebuilds both heaps, dropping outdated nodes
+	void rebuildHeaps();
+
 	Client *m_client;
-	std::vector<QueuedMeshUpdate *> m_queue;
-	std::unordered_set<v3s16> m_urgents;
+	// All updates that were not picked up yet, by mesh position
+	std::unordered_map<v3s16, QueueEntry> m_queue;
+	std::priority_queue<HeapNode> m_urgent_heap;
+	std::priority_queue<HeapNode> m_heap;
+	// Positions in m_queue that are not in a heap because they are in flight
+	std::unordered_set<v3s16> m_deferred;
 	std::unordered_set<v3s16> m_inflight_blocks;
+	u64 m_next_seq = 0;
+	v3s16 m_camera_mesh_pos;
 	std::mutex m_mutex;
 
+	// Shared by all mesh jobs until invalidated
+	std::shared_ptr<const MeshFilterContext> m_filter;
+
 	// TODO: Add callback to update these when g_settings changes, and update all meshes
 	bool m_cache_smooth_lighting;
 	bool m_cache_enable_water_reflections;
+	bool m_cache_greedy_meshing;
 
 	void fillDataFromMapBlocks(QueuedMeshUpdate *q);
+	std::shared_ptr<const MeshFilterContext> getFilter();
 };
 
 struct MeshUpdateResult
@@ -81,9 +143,10 @@ struct MeshUpdateResult
 	v3s16 p = v3s16(-1338, -1338, -1338);
 	MapBlockMesh *mesh = nullptr;
 	u8 solid_sides;
+	std::vector<content_t> contents;
+	std::vector<std::pair<v3s16, std::shared_ptr<const BlockOpacity>>> opacity;
 	std::vector<v3s16> ack_list;
 	bool urgent = false;
-	std::vector<MapBlock *> map_blocks;
 
 	MeshUpdateResult() = default;
 };
@@ -119,6 +182,15 @@ class MeshUpdateManager
 	void putResult(const MeshUpdateResult &r);
 	bool getNextResult(MeshUpdateResult &r);
 
+	// Must be called when the X-Ray or node ESP settings change
+	std::optional<ContentFilter> updateFilter() { return m_queue_in.updateFilter(); }
+
+	// Number of queued mesh updates that have not been picked up yet
+	u32 getQueueSize() { return m_queue_in.size(); }
+
+	// Meshes closer to this block are generated first
+	void setCameraBlock(v3s16 blockpos) { m_queue_in.setCameraBlock(blockpos); }
+
 
 	void start();
 	void stop();
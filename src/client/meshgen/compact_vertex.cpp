@@ -0,0 +1,83 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "compact_vertex.h"
+#include <cmath>
+#include "constants.h"
+
+// Half the extent of a grid cell including the margin, in position steps
+static s32 getHalfExtent(const MeshGrid &grid)
+{
+	s32 half_size = grid.cell_size * MAP_BLOCKSIZE / 2;
+	return (half_size + CompactVertexFormat::MARGIN) * CompactVertexFormat::POS_STEPS_PER_NODE;
+}
+
+// Texture coordinate steps per texture repeat. Cuboid faces take their
+// coordinates from the node position within the meshgen area (see
+// generateCuboidTextureCoords()), which may be up to the cell size either way.
+static s32 getTCoordSteps(const MeshGrid &grid)
+{
+	const s32 max_tcoord = grid.cell_size * MAP_BLOCKSIZE + CompactVertexFormat::TCOORD_MARGIN;
+	s32 steps = CompactVertexFormat::MAX_TCOORD_STEPS;
+	while (steps > 1 && max_tcoord * steps > S16_MAX)
+		steps /= 2;
+	return steps;
+}
+
+static s16 packValue(f32 value, f32 steps)
+{
+	return core::clamp<f32>(std::round(value * steps), -S16_MAX, S16_MAX);
+}
+
+bool CompactVertexFormat::supports(const MeshGrid &grid)
+{
+	return getHalfExtent(grid) < S16_MAX &&
+			getTCoordSteps(grid) >= MIN_TCOORD_STEPS;
+}
+
+CompactVertexFormat::CompactVertexFormat(const MeshGrid &grid) :
+	m_origin(grid.cell_size * MAP_BLOCKSIZE / 2 * BS),
+	m_max_translation(S16_MAX - getHalfExtent(grid)),
+	m_tcoord_steps(getTCoordSteps(grid))
+{
+	assert(supports(grid));
+}
+
+video::S3DVertexCompact CompactVertexFormat::pack(const video::S3DVertex &v) const
+{
+	const f32 pos_steps = 1.0f / getPosStep();
+	video::S3DVertexCompact ret;
+	ret.Pos[0] = packValue(v.Pos.X - m_origin, pos_steps);
+	ret.Pos[1] = packValue(v.Pos.Y - m_origin, pos_steps);
+	ret.Pos[2] = packValue(v.Pos.Z - m_origin, pos_steps);
+	ret.Normal[0] = packValue(v.Normal.X, S8_MAX);
+	ret.Normal[1] = packValue(v.Normal.Y, S8_MAX);
+	ret.Normal[2] = packValue(v.Normal.Z, S8_MAX);
+	ret.Color = v.Color;
+	ret.TCoords[0] = packValue(v.TCoords.X, m_tcoord_steps);
+	ret.TCoords[1] = packValue(v.TCoords.Y, m_tcoord_steps);
+	return ret;
+}
+
+video::S3DVertex CompactVertexFormat::unpack(const video::S3DVertexCompact &v) const
+{
+	const f32 pos_step = getPosStep();
+	const f32 tcoord_step = getTCoordStep();
+	return video::S3DVertex(
+		v3f(v.Pos[0], v.Pos[1], v.Pos[2]) * pos_step + m_origin,
+		v3f(v.Normal[0], v.Normal[1], v.Normal[2]) / S8_MAX,
+		v.Color,
+		v2f(v.TCoords[0], v.TCoords[1]) * tcoord_step);
+}
+
+bool CompactVertexFormat::getTranslationSteps(v3f translation, v3s32 &steps) const
+{
+	const f32 pos_steps = 1.0f / getPosStep();
+	for (int i = 0; i < 3; i++) {
+		f32 value = std::round(translation[i] * pos_steps);
+		if (std::fabs(value) > m_max_translation)
+			return false;
+		steps[i] = value;
+	}
+	return true;
+}
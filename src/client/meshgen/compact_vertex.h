@@ -0,0 +1,64 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <S3DVertex.h>
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include "util/numeric.h"
+
+/*
+	Packs map block mesh vertices into video::S3DVertexCompact, which takes
+	20 instead of 36 bytes per vertex.
+
+	Positions are stored in 1/256 node steps relative to the center of the
+	mesh grid cell, with room for geometry that sticks out of the cell by up
+	to MARGIN nodes. Texture coordinates of cuboid faces follow the node
+	position within the cell, so they are stored in the finest steps (up to
+	1/1024) that cover the cell size. Values outside of the range are
+	clamped.
+
+	Shaders that draw these meshes get the scale factors as constants and
+	have to apply them, see NodeShaderConstantSetter.
+*/
+class CompactVertexFormat
+{
+public:
+	static constexpr s32 POS_STEPS_PER_NODE = 256;
+	// Range of texture coordinate steps per texture repeat
+	static constexpr s32 MAX_TCOORD_STEPS = 1024;
+	static constexpr s32 MIN_TCOORD_STEPS = 256;
+	// How far meshes may extend beyond their grid cell, in nodes
+	static constexpr s32 MARGIN = 16;
+	// How far texture coordinates may exceed the cell size
+	static constexpr s32 TCOORD_MARGIN = 4;
+
+	// Whether meshes of the given grid fit into the position range and
+	// their texture coordinates can be stored precisely enough
+	static bool supports(const MeshGrid &grid);
+
+	explicit CompactVertexFormat(const MeshGrid &grid);
+
+	// Distance between position steps, in BS units
+	f32 getPosStep() const { return (f32)BS / POS_STEPS_PER_NODE; }
+	// Position that is stored as zero, on each axis
+	f32 getPosOrigin() const { return m_origin; }
+	f32 getTCoordStep() const { return 1.0f / m_tcoord_steps; }
+
+	video::S3DVertexCompact pack(const video::S3DVertex &v) const;
+	video::S3DVertex unpack(const video::S3DVertexCompact &v) const;
+
+	/*
+		Converts a translation between two meshes (a multiple of the block
+		size) to position steps. Fails if translated vertices could leave
+		the position range.
+	*/
+	bool getTranslationSteps(v3f translation, v3s32 &steps) const;
+
+private:
+	f32 m_origin;
+	// Largest translation on each axis, in steps
+	s32 m_max_translation;
+	s32 m_tcoord_steps;
+};
@@ -0,0 +1,79 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "content_filter.h"
+#include <bitset>
+#include "nodedef.h"
+#include "settings.h"
+
+ContentFilter ContentFilter::fromNodeList(const std::string &list,
+		const NodeDefManager *ndef)
+{
+	ContentFilter filter;
+	std::string buf;
+	auto flush = [&] () {
+		content_t c;
+		if (!buf.empty() && ndef->getId(buf, c))
+			filter.insert(c);
+		buf.clear();
+	};
+	for (char c : list) {
+		if (c == ',' || c == '\n')
+			flush();
+		else if (c != ' ')
+			buf += c;
+	}
+	flush();
+	return filter;
+}
+
+void ContentFilter::insert(content_t c)
+{
+	const size_t word = c >> 6;
+	if (word >= m_bits.size())
+		m_bits.resize(word + 1, 0);
+	const u64 mask = (u64)1 << (c & 63);
+	if (!(m_bits[word] & mask)) {
+		m_bits[word] |= mask;
+		m_count++;
+	}
+}
+
+void ContentFilter::merge(const ContentFilter &other)
+{
+	if (other.m_bits.size() > m_bits.size())
+		m_bits.resize(other.m_bits.size(), 0);
+	for (size_t i = 0; i < other.m_bits.size(); i++)
+		m_bits[i] |= other.m_bits[i];
+	updateCount();
+}
+
+ContentFilter ContentFilter::symmetricDifference(const ContentFilter &a,
+		const ContentFilter &b)
+{
+	ContentFilter result = a;
+	if (b.m_bits.size() > result.m_bits.size())
+		result.m_bits.resize(b.m_bits.size(), 0);
+	for (size_t i = 0; i < b.m_bits.size(); i++)
+		result.m_bits[i] ^= b.m_bits[i];
+	result.updateCount();
+	return result;
+}
+
+void ContentFilter::updateCount()
+{
+	m_count = 0;
+	for (u64 word : m_bits)
+		m_count += std::bitset<64>(word).count();
+}
+
+std::shared_ptr<const MeshFilterContext> MeshFilterContext::create(
+		const NodeDefManager *ndef)
+{
+	auto ctx = std::make_shared<MeshFilterContext>();
+	if (g_settings->getBool("xray"))
+		ctx->xray = ContentFilter::fromNodeList(g_settings->get("xray.nodes"), ndef);
+	ctx->node_esp = ContentFilter::fromNodeList(
+			g_settings->get("enable_node_esp.nodes"), ndef);
+	return ctx;
+}
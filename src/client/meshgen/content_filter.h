@@ -0,0 +1,67 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "irrlichttypes.h"
+#include "mapnode.h"
+
+class NodeDefManager;
+
+/*
+	Flat bitset over content_t, used for O(1) membership tests in the
+	mesh generator's inner loops.
+*/
+class ContentFilter
+{
+public:
+	ContentFilter() = default;
+
+	// Parses a comma- or newline-separated list of node names.
+	// Names that are not registered are ignored.
+	static ContentFilter fromNodeList(const std::string &list,
+			const NodeDefManager *ndef);
+
+	void insert(content_t c);
+
+	// Adds all content IDs of `other` to this filter
+	void merge(const ContentFilter &other);
+
+	// Returns the content IDs contained in exactly one of both filters
+	static ContentFilter symmetricDifference(const ContentFilter &a,
+			const ContentFilter &b);
+
+	bool contains(content_t c) const
+	{
+		const size_t word = c >> 6;
+		return word < m_bits.size() && (m_bits[word] >> (c & 63)) & 1;
+	}
+
+	bool empty() const { return m_count == 0; }
+	size_t size() const { return m_count; }
+
+private:
+	void updateCount();
+
+	std::vector<u64> m_bits;
+	size_t m_count = 0;
+};
+
+/*
+	Immutable snapshot of all settings-driven node filters consulted
+	during mesh generation. A single instance is shared by all mesh
+	workers until the settings change and a new one is published.
+*/
+struct MeshFilterContext
+{
+	// Nodes hidden by X-Ray (empty if X-Ray is disabled)
+	ContentFilter xray;
+	// Nodes whose positions are collected for node ESP
+	ContentFilter node_esp;
+
+	// Reads the current filter settings from g_settings
+	static std::shared_ptr<const MeshFilterContext> create(
+			const NodeDefManager *ndef);
+};
@@ -0,0 +1,138 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "overlay_buffer.h"
+#include <IVideoDriver.h>
+#include "irr_v2d.h"
+
+// Corner indices into aabb3f::getEdges(), as used by draw3DBox
+static const u16 box_edge_indices[24] = {
+	5, 1, 1, 3, 3, 7, 7, 5, 0, 2, 2, 6, 6, 4, 4, 0, 1, 0, 3, 2, 7, 6, 5, 4
+};
+
+// Two triangles per side: front, back, left, right, top, bottom
+static const u16 box_face_indices[6][6] = {
+	{0, 1, 5, 0, 5, 4},
+	{3, 6, 7, 3, 2, 6},
+	{0, 3, 1, 0, 2, 3},
+	{5, 6, 4, 5, 7, 6},
+	{1, 3, 7, 1, 7, 5},
+	{0, 4, 2, 2, 4, 6},
+};
+
+scene::SMeshBuffer *OverlayBuffer::getBuffer(Batch &batch, u32 vertex_count,
+		scene::E_PRIMITIVE_TYPE type, std::vector<u8> *&base_alpha)
+{
+	if (batch.used > 0) {
+		scene::SMeshBuffer *buf = batch.buffers[batch.used - 1].get();
+		if (buf->getVertexCount() + vertex_count <= U16_MAX + 1) {
+			base_alpha = &batch.base_alpha[batch.used - 1];
+			return buf;
+		}
+	}
+
+	if (batch.used == batch.buffers.size()) {
+		auto buf = make_irr<scene::SMeshBuffer>();
+		buf->setPrimitiveType(type);
+		if (m_static)
+			buf->setHardwareMappingHint(scene::EHM_STATIC);
+		batch.buffers.push_back(std::move(buf));
+		batch.base_alpha.emplace_back();
+	}
+	base_alpha = &batch.base_alpha[batch.used];
+	return batch.buffers[batch.used++].get();
+}
+
+void OverlayBuffer::addBox(const aabb3f &box, video::SColor color, u8 sides)
+{
+	v3f corners[8];
+	box.getEdges(corners);
+
+	std::vector<u8> *base_alpha;
+	scene::SMeshBuffer *buf = getBuffer(m_edges, 8, scene::EPT_LINES, base_alpha);
+	u16 first = buf->getVertexCount();
+	for (const v3f &corner : corners) {
+		buf->Vertices->Data.emplace_back(corner, v3f(), color, v2f());
+		base_alpha->push_back(color.getAlpha());
+	}
+	for (u16 i : box_edge_indices)
+		buf->Indices->Data.push_back(first + i);
+
+	if (!(sides & 63))
+		return;
+
+	buf = getBuffer(m_faces, 8, scene::EPT_TRIANGLES, base_alpha);
+	first = buf->getVertexCount();
+	for (const v3f &corner : corners) {
+		buf->Vertices->Data.emplace_back(corner, v3f(), color, v2f());
+		base_alpha->push_back(color.getAlpha());
+	}
+	for (int side = 0; side < 6; side++) {
+		if (!(sides & (1 << side)))
+			continue;
+		for (u16 i : box_face_indices[side])
+			buf->Indices->Data.push_back(first + i);
+	}
+}
+
+void OverlayBuffer::addLine(const v3f &from, const v3f &to, video::SColor color)
+{
+	std::vector<u8> *base_alpha;
+	scene::SMeshBuffer *buf = getBuffer(m_lines, 2, scene::EPT_LINES, base_alpha);
+	u16 first = buf->getVertexCount();
+	buf->Vertices->Data.emplace_back(from, v3f(), color, v2f());
+	buf->Vertices->Data.emplace_back(to, v3f(), color, v2f());
+	base_alpha->push_back(color.getAlpha());
+	base_alpha->push_back(color.getAlpha());
+	buf->Indices->Data.push_back(first);
+	buf->Indices->Data.push_back(first + 1);
+}
+
+void OverlayBuffer::clear()
+{
+	for (Batch *batch : {&m_edges, &m_faces, &m_lines}) {
+		for (size_t i = 0; i < batch->used; i++) {
+			batch->buffers[i]->Vertices->Data.clear();
+			batch->buffers[i]->Indices->Data.clear();
+			batch->buffers[i]->setDirty();
+			batch->base_alpha[i].clear();
+		}
+		batch->used = 0;
+		batch->alpha = -1;
+	}
+}
+
+void OverlayBuffer::drawBoxes(video::IVideoDriver *driver, int draw_type,
+		int edge_alpha, int face_alpha)
+{
+	if (draw_type == 0 || draw_type == 2)
+		draw(driver, m_edges, edge_alpha);
+	if (draw_type == 1 || draw_type == 2)
+		draw(driver, m_faces, face_alpha);
+}
+
+void OverlayBuffer::drawLines(video::IVideoDriver *driver)
+{
+	draw(driver, m_lines, -1);
+}
+
+void OverlayBuffer::draw(video::IVideoDriver *driver, Batch &batch, int alpha)
+{
+	if (alpha < 0 || alpha > 255)
+		alpha = -1;
+
+	if (alpha != batch.alpha) {
+		// Opacity settings changed, recolor the vertices
+		for (size_t i = 0; i < batch.used; i++) {
+			auto &vertices = batch.buffers[i]->Vertices->Data;
+			const auto &base_alpha = batch.base_alpha[i];
+			for (size_t j = 0; j < vertices.size(); j++)
+				vertices[j].Color.setAlpha(alpha < 0 ? base_alpha[j] : alpha);
+			batch.buffers[i]->setDirty(scene::EBT_VERTEX);
+		}
+		batch.alpha = alpha;
+	}
+
+	for (size_t i = 0; i < batch.used; i++)
+		driver->drawMeshBuffer(batch.buffers[i].get());
+}
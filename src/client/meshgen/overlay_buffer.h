@@ -0,0 +1,81 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+#include <vector>
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include "irr_aabb3d.h"
+#include "irr_ptr.h"
+#include <CMeshBuffer.h>
+
+namespace irr::video {
+	class IVideoDriver;
+}
+
+// A highlighted position, e.g. the end of a tracer line
+struct OverlayTarget
+{
+	v3f pos;
+	video::SColor color;
+};
+
+/*
+	Collects highlight geometry (boxes and lines) into a few mesh buffers
+	so that it can be drawn with one call per buffer instead of one
+	immediate-mode call per box.
+
+	Static instances are built once, e.g. by the mesh workers along with
+	MapBlockMesh, and stay on the GPU until they are destroyed. Other
+	instances are meant to be cleared and refilled every frame.
+*/
+class OverlayBuffer
+{
+public:
+	explicit OverlayBuffer(bool is_static = false) : m_static(is_static) {}
+
+	// Adds an axis aligned box. `sides` selects the faces that are filled,
+	// using the same bit order as IVideoDriver::draw3DBox.
+	void addBox(const aabb3f &box, video::SColor color, u8 sides = 63);
+
+	void addLine(const v3f &from, const v3f &to, video::SColor color);
+
+	// Removes all geometry but keeps the allocated buffers
+	void clear();
+
+	bool empty() const { return m_edges.used == 0 && m_lines.used == 0; }
+
+	/*
+		Draws the boxes like IVideoDriver::draw3DBox does, using the current
+		material and world transformation. draw_type 0 draws the edges, 1 the
+		faces and 2 both. An alpha within 0-255 replaces the alpha of the
+		box colors.
+	*/
+	void drawBoxes(video::IVideoDriver *driver, int draw_type,
+			int edge_alpha, int face_alpha);
+
+	void drawLines(video::IVideoDriver *driver);
+
+private:
+	struct Batch
+	{
+		std::vector<irr_ptr<scene::SMeshBuffer>> buffers;
+		// Alpha of the vertex colors as added, per buffer
+		std::vector<std::vector<u8>> base_alpha;
+		// Number of buffers in use
+		size_t used = 0;
+		// Alpha override currently applied to the vertices
+		int alpha = -1;
+	};
+
+	// Returns a buffer with room for `vertex_count` more vertices
+	scene::SMeshBuffer *getBuffer(Batch &batch, u32 vertex_count,
+			scene::E_PRIMITIVE_TYPE type, std::vector<u8> *&base_alpha);
+
+	void draw(video::IVideoDriver *driver, Batch &batch, int alpha);
+
+	bool m_static;
+	Batch m_edges;
+	Batch m_faces;
+	Batch m_lines;
+};
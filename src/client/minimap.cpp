@@ -4,6 +4,7 @@
 
 #include "minimap.h"
 #include <cmath>
+#include <cstring>
 #include "client.h"
 #include "clientmap.h"
 #include "settings.h"
@@ -76,6 +77,7 @@ void MinimapUpdateThread::doUpdate()
 	QueuedMinimapUpdate update;
 
 	while (popBlockUpdate(&update)) {
+		m_dirty_columns.emplace(update.pos.X, update.pos.Z);
 		if (update.data) {
 			// Swap two values in the map using single lookup
 			auto result = m_blocks_cache.insert(std::make_pair(update.pos, update.data));
@@ -108,50 +110,157 @@ void MinimapUpdateThread::getMap(v3s16 pos, s16 size, s16 height)
 	v3s16 blockpos_min = getNodeBlockPos(pos_min);
 	v3s16 blockpos_max = getNodeBlockPos(pos_max);
 
-// clear the map
-	for (int z = 0; z < size; z++)
-	for (int x = 0; x < size; x++) {
-		MinimapPixel &mmpixel = data->minimap_scan[x + z * size];
-		mmpixel.air_count = 0;
-		mmpixel.height = 0;
-		mmpixel.n = MapNode(CONTENT_AIR);
-	}
-
-// draw the map
-	v3s16 blockpos;
-	for (blockpos.Z = blockpos_min.Z; blockpos.Z <= blockpos_max.Z; ++blockpos.Z)
-	for (blockpos.Y = blockpos_min.Y; blockpos.Y <= blockpos_max.Y; ++blockpos.Y)
-	for (blockpos.X = blockpos_min.X; blockpos.X <= blockpos_max.X; ++blockpos.X) {
-		auto pblock = m_blocks_cache.find(blockpos);
+	if (blockpos_min.Y != m_tiles_y_min || blockpos_max.Y != m_tiles_y_max) {
+		m_tiles.clear();
+		m_tiles_y_min = blockpos_min.Y;
+		m_tiles_y_max = blockpos_max.Y;
+	}
+	for (v2s16 column : m_dirty_columns)
+		m_tiles.erase(column);
+
+	const v2s16 area_min(pos_min.X, pos_min.Z);
+	const v2s16 area_max(pos_max.X, pos_max.Z);
+	const v2s16 shift(pos.X - m_scan_pos.X, pos.Z - m_scan_pos.Z);
+	bool scroll = m_scan_valid && size == m_scan_size && height == m_scan_height &&
+			pos.Y == m_scan_pos.Y &&
+			std::abs(shift.X) < size && std::abs(shift.Y) < size;
+
+	if (scroll) {
+		// Keep what is still in view, then fill in the strips that came
+		// into view and the columns that changed
+		scrollScan(size, shift);
+		if (shift.X > 0)
+			fillScan(pos_min, size, v2s16(area_max.X - shift.X + 1, area_min.Y), area_max);
+		else if (shift.X < 0)
+			fillScan(pos_min, size, area_min, v2s16(area_min.X - shift.X - 1, area_max.Y));
+		if (shift.Y > 0)
+			fillScan(pos_min, size, v2s16(area_min.X, area_max.Y - shift.Y + 1), area_max);
+		else if (shift.Y < 0)
+			fillScan(pos_min, size, area_min, v2s16(area_max.X, area_min.Y - shift.Y - 1));
+
+		for (v2s16 column : m_dirty_columns) {
+			v2s16 column_min = column * MAP_BLOCKSIZE;
+			v2s16 column_max = column_min + v2s16(MAP_BLOCKSIZE - 1, MAP_BLOCKSIZE - 1);
+			fillScan(pos_min, size, componentwise_max(column_min, area_min),
+					componentwise_min(column_max, area_max));
+		}
+	} else {
+		fillScan(pos_min, size, area_min, area_max);
+	}
+	m_dirty_columns.clear();
+
+	m_scan_valid = true;
+	m_scan_pos = pos;
+	m_scan_size = size;
+	m_scan_height = height;
+
+	// Forget the tiles that went far out of view
+	const size_t columns = (blockpos_max.X - blockpos_min.X + 1) *
+			(blockpos_max.Z - blockpos_min.Z + 1);
+	if (m_tiles.size() > 4 * columns) {
+		for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+			const v2s16 &column = it->first;
+			if (column.X < blockpos_min.X || column.X > blockpos_max.X ||
+					column.Y < blockpos_min.Z || column.Y > blockpos_max.Z)
+				it = m_tiles.erase(it);
+			else
+				++it;
+		}
+	}
+}
+
+const MinimapTile &MinimapUpdateThread::getTile(v2s16 column)
+{
+	auto &tile = m_tiles[column];
+	if (tile)
+		return *tile;
+
+	tile = std::make_unique<MinimapTile>();
+	for (auto &pixel : tile->data) {
+		pixel.n = MapNode(CONTENT_AIR);
+		pixel.y = 0;
+		pixel.air_count = 0;
+	}
+
+	// Merge the blocks from bottom to top, so that the topmost node wins
+	for (s16 y = m_tiles_y_min; y <= m_tiles_y_max; y++) {
+		auto pblock = m_blocks_cache.find(v3s16(column.X, y, column.Y));
 		if (pblock == m_blocks_cache.end())
 			continue;
 		const MinimapMapblock &block = *pblock->second;
 
-		v3s16 block_node_min(blockpos * MAP_BLOCKSIZE);
-		v3s16 block_node_max(block_node_min + MAP_BLOCKSIZE - 1);
-		// clip
-		v3s16 range_min = componentwise_max(block_node_min, pos_min);
-		v3s16 range_max = componentwise_min(block_node_max, pos_max);
-
-		v3s16 pos;
-		pos.Y = range_min.Y;
-		for (pos.Z = range_min.Z; pos.Z <= range_max.Z; ++pos.Z)
-		for (pos.X = range_min.X; pos.X <= range_max.X; ++pos.X) {
-			v3s16 inblock_pos = pos - block_node_min;
-			const MinimapPixel &in_pixel =
-				block.data[inblock_pos.Z * MAP_BLOCKSIZE + inblock_pos.X];
-
-			v3s16 inmap_pos = pos - pos_min;
-			MinimapPixel &out_pixel =
-				data->minimap_scan[inmap_pos.X + inmap_pos.Z * size];
+		for (size_t i = 0; i < MAP_BLOCKSIZE * MAP_BLOCKSIZE; i++) {
+			const MinimapPixel &in_pixel = block.data[i];
+			MinimapTile::Pixel &out_pixel = tile->data[i];
 
 			out_pixel.air_count += in_pixel.air_count;
 			if (in_pixel.n.param0 != CONTENT_AIR) {
 				out_pixel.n = in_pixel.n;
-				out_pixel.height = inmap_pos.Y + in_pixel.height;
+				out_pixel.y = y * MAP_BLOCKSIZE + in_pixel.height;
 			}
 		}
 	}
+	return *tile;
+}
+
+void MinimapUpdateThread::fillScan(v3s16 pos_min, s16 size,
+		v2s16 area_min, v2s16 area_max)
+{
+	if (area_min.X > area_max.X || area_min.Y > area_max.Y)
+		return;
+
+	v2s16 column_min = getContainerPos(area_min, MAP_BLOCKSIZE);
+	v2s16 column_max = getContainerPos(area_max, MAP_BLOCKSIZE);
+
+	v2s16 column;
+	for (column.Y = column_min.Y; column.Y <= column_max.Y; ++column.Y)
+	for (column.X = column_min.X; column.X <= column_max.X; ++column.X) {
+		const MinimapTile &tile = getTile(column);
+
+		v2s16 tile_node_min = column * MAP_BLOCKSIZE;
+		v2s16 tile_node_max = tile_node_min + v2s16(MAP_BLOCKSIZE - 1, MAP_BLOCKSIZE - 1);
+		// clip
+		v2s16 range_min = componentwise_max(tile_node_min, area_min);
+		v2s16 range_max = componentwise_min(tile_node_max, area_max);
+
+		v2s16 pos;
+		for (pos.Y = range_min.Y; pos.Y <= range_max.Y; ++pos.Y)
+		for (pos.X = range_min.X; pos.X <= range_max.X; ++pos.X) {
+			v2s16 intile_pos = pos - tile_node_min;
+			const MinimapTile::Pixel &in_pixel =
+				tile.data[intile_pos.Y * MAP_BLOCKSIZE + intile_pos.X];
+
+			MinimapPixel &out_pixel = data->minimap_scan[
+				(pos.X - pos_min.X) + (pos.Y - pos_min.Z) * size];
+
+			out_pixel.air_count = in_pixel.air_count;
+			out_pixel.n = in_pixel.n;
+			out_pixel.height = in_pixel.n.param0 != CONTENT_AIR ?
+				MYMAX(in_pixel.y - pos_min.Y, 0) : 0;
+		}
+	}
+}
+
+void MinimapUpdateThread::scrollScan(s16 size, v2s16 shift)
+{
+	MinimapPixel *scan = data->minimap_scan;
+	const s32 width = size - std::abs(shift.X);
+	const s32 x_dst = shift.X < 0 ? -shift.X : 0;
+	const s32 x_src = shift.X > 0 ? shift.X : 0;
+	auto move_row = [&] (s32 z) {
+		std::memmove(&scan[x_dst + z * size], &scan[x_src + (z + shift.Y) * size],
+				width * sizeof(MinimapPixel));
+	};
+
+	// Go against the direction of the move, so that no row is overwritten
+	// before it has been moved
+	if (shift.Y >= 0) {
+		for (s32 z = 0; z < size - shift.Y; z++)
+			move_row(z);
+	} else {
+		for (s32 z = size - 1; z >= -shift.Y; z--)
+			move_row(z);
+	}
 }
 
 ////
@@ -379,48 +488,61 @@ void Minimap::setAngle(f32 angle)
 
 void Minimap::blitMinimapPixelsToImageRadar(video::IImage *map_image)
 {
+	// The image is ECF_A8R8G8B8, so pixels can be written as SColor values
+	u32 *pixels = static_cast<u32 *>(map_image->getData());
+	const u32 pitch = map_image->getPitch() / 4;
 	video::SColor c(240, 0, 0, 0);
-	for (s16 x = 0; x < data->mode.map_size; x++)
 	for (s16 z = 0; z < data->mode.map_size; z++) {
-		MinimapPixel *mmpixel = &data->minimap_scan[x + z * data->mode.map_size];
+		u32 *row = &pixels[(data->mode.map_size - z - 1) * pitch];
+		for (s16 x = 0; x < data->mode.map_size; x++) {
+			MinimapPixel *mmpixel = &data->minimap_scan[x + z * data->mode.map_size];
 
-		if (mmpixel->air_count > 0)
-			c.setGreen(core::clamp(core::round32(32 + mmpixel->air_count * 8), 0, 255));
-		else
-			c.setGreen(0);
+			if (mmpixel->air_count > 0)
+				c.setGreen(core::clamp(core::round32(32 + mmpixel->air_count * 8), 0, 255));
+			else
+				c.setGreen(0);
 
-		map_image->setPixel(x, data->mode.map_size - z - 1, c);
+			row[x] = c.color;
+		}
 	}
 }
 
 void Minimap::blitMinimapPixelsToImageSurface(
 	video::IImage *map_image, video::IImage *heightmap_image)
 {
+	// Both images are ECF_A8R8G8B8, see blitMinimapPixelsToImageRadar
+	u32 *pixels = static_cast<u32 *>(map_image->getData());
+	u32 *heights = static_cast<u32 *>(heightmap_image->getData());
+	const u32 pitch = map_image->getPitch() / 4;
+	const u32 heightmap_pitch = heightmap_image->getPitch() / 4;
+
 	// This variable creation/destruction has a 1% cost on rendering minimap
 	video::SColor tilecolor;
-	for (s16 x = 0; x < data->mode.map_size; x++)
 	for (s16 z = 0; z < data->mode.map_size; z++) {
-		MinimapPixel *mmpixel = &data->minimap_scan[x + z * data->mode.map_size];
+		u32 *row = &pixels[(data->mode.map_size - z - 1) * pitch];
+		u32 *height_row = &heights[(data->mode.map_size - z - 1) * heightmap_pitch];
+		for (s16 x = 0; x < data->mode.map_size; x++) {
+			MinimapPixel *mmpixel = &data->minimap_scan[x + z * data->mode.map_size];
 
-		const ContentFeatures &f = m_ndef->get(mmpixel->n);
-		const TileDef *tile = &f.tiledef[0];
+			const ContentFeatures &f = m_ndef->get(mmpixel->n);
+			const TileDef *tile = &f.tiledef[0];
 
-		// Color of the 0th tile (mostly this is the topmost)
-		if(tile->has_color)
-			tilecolor = tile->color;
-		else
-			mmpixel->n.getColor(f, &tilecolor);
+			// Color of the 0th tile (mostly this is the topmost)
+			if(tile->has_color)
+				tilecolor = tile->color;
+			else
+				mmpixel->n.getColor(f, &tilecolor);
 
-		tilecolor.setRed(tilecolor.getRed() * f.minimap_color.getRed() / 255);
-		tilecolor.setGreen(tilecolor.getGreen() * f.minimap_color.getGreen() / 255);
-		tilecolor.setBlue(tilecolor.getBlue() * f.minimap_color.getBlue() / 255);
-		tilecolor.setAlpha(240);
+			tilecolor.setRed(tilecolor.getRed() * f.minimap_color.getRed() / 255);
+			tilecolor.setGreen(tilecolor.getGreen() * f.minimap_color.getGreen() / 255);
+			tilecolor.setBlue(tilecolor.getBlue() * f.minimap_color.getBlue() / 255);
+			tilecolor.setAlpha(240);
 
-		map_image->setPixel(x, data->mode.map_size - z - 1, tilecolor);
+			row[x] = tilecolor.color;
 
-		u32 h = mmpixel->height;
-		heightmap_image->setPixel(x,data->mode.map_size - z - 1,
-			video::SColor(255, h, h, h));
+			u32 h = mmpixel->height;
+			height_row[x] = video::SColor(255, h, h, h).color;
+		}
 	}
 }
 
@@ -447,18 +569,47 @@ video::IImage *Minimap::getMinimapMask()
 	return data->minimap_mask_square;
 }
 
+// Replaces the contents of the texture with the image, creating the texture
+// if it doesn't fit. Reusing it saves allocating a new one on each update.
+static void update_texture(video::IVideoDriver *driver, video::ITexture *&texture,
+		const io::path &name, video::IImage *image)
+{
+	if (texture && texture->getSize() == image->getDimension() &&
+			texture->getOriginalSize() == image->getDimension() &&
+			texture->getColorFormat() == image->getColorFormat() &&
+			texture->getPitch() == image->getPitch()) {
+		if (void *pixels = texture->lock(video::ETLM_WRITE_ONLY)) {
+			memcpy(pixels, image->getData(), image->getImageDataSizeInBytes());
+			texture->unlock();
+			texture->regenerateMipMapLevels();
+			return;
+		}
+	}
+
+	if (texture)
+		driver->removeTexture(texture);
+	texture = driver->addTexture(name, image);
+}
+
 video::ITexture *Minimap::getMinimapTexture()
 {
 	// update minimap textures when new scan is ready
 	if (data->map_invalidated && data->mode.type != MINIMAP_TYPE_TEXTURE)
 		return data->texture;
 
-	// create minimap and heightmap images in memory
+	// create minimap and heightmap images in memory, or reuse them
 	core::dimension2d<u32> dim(data->mode.map_size, data->mode.map_size);
-	video::IImage *map_image       = driver->createImage(video::ECF_A8R8G8B8, dim);
-	video::IImage *heightmap_image = driver->createImage(video::ECF_A8R8G8B8, dim);
-	video::IImage *minimap_image   = driver->createImage(video::ECF_A8R8G8B8,
-		core::dimension2d<u32>(MINIMAP_MAX_SX, MINIMAP_MAX_SY));
+	if (!m_map_image || m_map_image->getDimension() != dim) {
+		m_map_image.reset(driver->createImage(video::ECF_A8R8G8B8, dim));
+		m_heightmap_image.reset(driver->createImage(video::ECF_A8R8G8B8, dim));
+	}
+	if (!m_minimap_image) {
+		m_minimap_image.reset(driver->createImage(video::ECF_A8R8G8B8,
+			core::dimension2d<u32>(MINIMAP_MAX_SX, MINIMAP_MAX_SY)));
+	}
+	video::IImage *map_image       = m_map_image.get();
+	video::IImage *heightmap_image = m_heightmap_image.get();
+	video::IImage *minimap_image   = m_minimap_image.get();
 
 	// Blit MinimapPixels to images
 	switch(data->mode.type) {
@@ -493,27 +644,31 @@ video::ITexture *Minimap::getMinimapTexture()
 	}
 
 	map_image->copyToScaling(minimap_image);
-	map_image->drop();
 
 	video::IImage *minimap_mask = getMinimapMask();
 
-	for (s16 y = 0; y < MINIMAP_MAX_SY; y++)
-	for (s16 x = 0; x < MINIMAP_MAX_SX; x++) {
-		const video::SColor &mask_col = minimap_mask->getPixel(x, y);
-		if (!mask_col.getAlpha())
-			minimap_image->setPixel(x, y, video::SColor(0,0,0,0));
+	if (minimap_mask->getColorFormat() == video::ECF_A8R8G8B8 &&
+			minimap_mask->getDimension() == minimap_image->getDimension()) {
+		const u32 *mask = static_cast<const u32 *>(minimap_mask->getData());
+		u32 *pixels = static_cast<u32 *>(minimap_image->getData());
+		for (u32 i = 0; i < MINIMAP_MAX_SX * MINIMAP_MAX_SY; i++) {
+			if (!video::SColor(mask[i]).getAlpha())
+				pixels[i] = 0;
+		}
+	} else {
+		for (s16 y = 0; y < MINIMAP_MAX_SY; y++)
+		for (s16 x = 0; x < MINIMAP_MAX_SX; x++) {
+			const video::SColor &mask_col = minimap_mask->getPixel(x, y);
+			if (!mask_col.getAlpha())
+				minimap_image->setPixel(x, y, video::SColor(0,0,0,0));
+		}
 	}
 
-	if (data->texture)
-		driver->removeTexture(data->texture);
-	if (data->heightmap_texture)
-		driver->removeTexture(data->heightmap_texture);
-
-	data->texture = driver->addTexture("minimap__", minimap_image);
-	data->heightmap_texture =
-		driver->addTexture("minimap_heightmap__", heightmap_image);
-	minimap_image->drop();
-	heightmap_image->drop();
+	update_texture(driver, data->texture, "minimap__", minimap_image);
+	// The heightmap is only used by the surface mode shader
+	if (data->mode.type == MINIMAP_TYPE_SURFACE || !data->heightmap_texture)
+		update_texture(driver, data->heightmap_texture, "minimap_heightmap__",
+				heightmap_image);
 
 	data->map_invalidated = true;
 
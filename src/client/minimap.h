@@ -13,7 +13,10 @@
 #include "mapnode.h"
 #include "util/thread.h"
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace irr {
@@ -71,6 +74,18 @@ struct MinimapMapblock {
 	MinimapPixel data[MAP_BLOCKSIZE * MAP_BLOCKSIZE];
 };
 
+//! The blocks of a block column within the scanned height range, merged
+struct MinimapTile {
+	struct Pixel {
+		//! The topmost node, and its world Y position
+		MapNode n;
+		s16 y;
+		u16 air_count;
+	};
+
+	Pixel data[MAP_BLOCKSIZE * MAP_BLOCKSIZE];
+};
+
 struct MinimapData {
 	MinimapModeDef mode;
 	v3s16 pos;
@@ -110,9 +125,30 @@ class MinimapUpdateThread : public UpdateThread {
 	virtual void doUpdate();
 
 private:
+	// Returns the tile of a block column, merging its blocks if needed
+	const MinimapTile &getTile(v2s16 column);
+	// Copies the nodes within area_min and area_max (X and Z, inclusive)
+	// from the tiles to the scan starting at pos_min
+	void fillScan(v3s16 pos_min, s16 size, v2s16 area_min, v2s16 area_max);
+	// Moves the scan contents by -shift, as if the scan area moved by shift
+	void scrollScan(s16 size, v2s16 shift);
+
 	std::mutex m_queue_mutex;
 	std::deque<QueuedMinimapUpdate> m_update_queue;
 	std::map<v3s16, MinimapMapblock *> m_blocks_cache;
+
+	// Tiles by block column, made for the block Y range below
+	std::unordered_map<v2s16, std::unique_ptr<MinimapTile>> m_tiles;
+	s16 m_tiles_y_min = 0;
+	s16 m_tiles_y_max = -1;
+	// Columns with block updates since the last scan
+	std::unordered_set<v2s16> m_dirty_columns;
+
+	// Parameters of the scan in data->minimap_scan
+	bool m_scan_valid = false;
+	v3s16 m_scan_pos;
+	s16 m_scan_size = 0;
+	s16 m_scan_height = 0;
 };
 
 class Minimap {
@@ -176,4 +212,9 @@ class Minimap {
 	std::mutex m_mutex;
 	std::list<std::unique_ptr<MinimapMarker>> m_markers;
 	std::list<v2f> m_active_markers;
+
+	// Kept between texture updates, all ECF_A8R8G8B8
+	irr_ptr<video::IImage> m_map_image;
+	irr_ptr<video::IImage> m_heightmap_image;
+	irr_ptr<video::IImage> m_minimap_image;
 };
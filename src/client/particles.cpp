@@ -3,6 +3,7 @@
 // Copyright (C) 2013 celeron55, Perttu Ahola <celeron55@gmail.com>
 
 #include "particles.h"
+#include <algorithm>
 #include <cmath>
 #include <array>
 #include "client.h"
@@ -46,16 +47,11 @@ Particle::Particle(
 		ParticleSpawner *parent,
 		std::unique_ptr<ClientParticleTexture> owned_texture
 	) :
-		m_expiration(p.expirationtime),
-
 		m_base_color(color),
 
 		m_texture(texture),
 		m_texpos(texpos),
 		m_texsize(texsize),
-		m_pos(p.pos),
-		m_velocity(p.vel),
-		m_acceleration(p.acc),
 		m_p(p),
 
 		m_parent(parent),
@@ -63,187 +59,43 @@ Particle::Particle(
 {
 }
 
-Particle::~Particle()
-{
-	if (m_buffer)
-		m_buffer->release(m_index);
-}
+/*
+	ParticleStepContext
+*/
 
-bool Particle::attachToBuffer(ParticleBuffer *buffer)
+ParticleStepContext::ParticleStepContext(ClientEnvironment *env) :
+	env(env),
+	daynight_ratio(env->getDayNightRatio()),
+	right(1, 0, 0),
+	up(0, 1, 0)
 {
-	auto index_opt = buffer->allocate();
-	if (index_opt.has_value()) {
-		m_index = index_opt.value();
-		m_buffer = buffer;
-		return true;
+	LocalPlayer *player = env->getLocalPlayer();
+	player_pos = player->getPosition() / BS;
+	camera_offset = intToFloat(env->getCameraOffset(), BS);
+
+	// Same rotation as applied to each vertex before, see #10398
+	for (v3f *axis : {&right, &up}) {
+		axis->rotateYZBy(player->getPitch());
+		axis->rotateXZBy(player->getYaw());
 	}
-	return false;
 }
 
-void Particle::step(float dtime, ClientEnvironment *env)
+u8 ParticleStepContext::getLight(v3s16 p)
 {
-	m_time += dtime;
-
-	// apply drag (not handled by collisionMoveSimple) and brownian motion
-	v3f av = vecAbsolute(m_velocity);
-	av -= av * (m_p.drag * dtime);
-	m_velocity = av*vecSign(m_velocity) + v3f(m_p.jitter.pickWithin())*dtime;
-
-	if (m_p.collisiondetection) {
-		aabb3f box(v3f(-m_p.size / 2.0f), v3f(m_p.size / 2.0f));
-		v3f p_pos = m_pos * BS;
-		v3f p_velocity = m_velocity * BS;
-		collisionMoveResult r = collisionMoveSimple(env, env->getGameDef(),
-			box, 0.0f, dtime, &p_pos, &p_velocity, m_acceleration * BS, nullptr,
-			m_p.object_collision);
-
-		f32 bounciness = m_p.bounce.pickWithin();
-		if (r.collides && (m_p.collision_removal || bounciness > 0)) {
-			if (m_p.collision_removal) {
-				// force expiration of the particle
-				m_expiration = -1.0f;
-			} else if (bounciness > 0) {
-				/* cheap way to get a decent bounce effect is to only invert the
-				 * largest component of the velocity vector, so e.g. you don't
-				 * have a rock immediately bounce back in your face when you try
-				 * to skip it across the water (as would happen if we simply
-				 * downscaled and negated the velocity vector). this means
-				 * bounciness will work properly for cubic objects, but meshes
-				 * with diagonal angles and entities will not yield the correct
-				 * visual. this is probably unavoidable */
-				if (av.Y > av.X && av.Y > av.Z) {
-					m_velocity.Y = -(m_velocity.Y * bounciness);
-				} else if (av.X > av.Y && av.X > av.Z) {
-					m_velocity.X = -(m_velocity.X * bounciness);
-				} else if (av.Z > av.Y && av.Z > av.X) {
-					m_velocity.Z = -(m_velocity.Z * bounciness);
-				} else { // well now we're in a bit of a pickle
-					m_velocity = -(m_velocity * bounciness);
-				}
-			}
-		} else {
-			m_velocity = p_velocity / BS;
-		}
-		m_pos = p_pos / BS;
-	} else {
-		// apply velocity and acceleration to position
-		m_pos += (m_velocity + m_acceleration * 0.5f * dtime) * dtime;
-		// apply acceleration to velocity
-		m_velocity += m_acceleration * dtime;
-	}
-
-	if (m_p.animation.type != TAT_NONE) {
-		m_animation_time += dtime;
-		int frame_length_i = 0;
-		m_p.animation.determineParams(
-				m_texture.ref->getSize(),
-				NULL, &frame_length_i, NULL);
-		float frame_length = frame_length_i / 1000.0;
-		while (m_animation_time > frame_length) {
-			m_animation_frame++;
-			m_animation_time -= frame_length;
-		}
-	}
-
-	// animate particle alpha in accordance with settings
-	float alpha = 1.f;
-	if (m_texture.tex != nullptr)
-		alpha = m_texture.tex -> alpha.blend(m_time / (m_expiration+0.1f));
-
-	// Update lighting
-	auto col = updateLight(env);
-	col.setAlpha(255 * alpha);
-
-	// Update model
-	updateVertices(env, col);
-}
+	auto it = m_lights.find(p);
+	if (it != m_lights.end())
+		return it->second;
 
-video::SColor Particle::updateLight(ClientEnvironment *env)
-{
-	u8 light = 0;
+	u8 light;
 	bool pos_ok;
-
-	v3s16 p = v3s16(
-		floor(m_pos.X+0.5),
-		floor(m_pos.Y+0.5),
-		floor(m_pos.Z+0.5)
-	);
 	MapNode n = env->getClientMap().getNode(p, &pos_ok);
 	if (pos_ok)
-		light = n.getLightBlend(env->getDayNightRatio(),
+		light = n.getLightBlend(daynight_ratio,
 				env->getGameDef()->ndef()->getLightingFlags(n));
 	else
-		light = blend_light(env->getDayNightRatio(), LIGHT_SUN, 0);
-
-	u8 m_light = decode_light(light + m_p.glow);
-	return video::SColor(255,
-		m_light * m_base_color.getRed() / 255,
-		m_light * m_base_color.getGreen() / 255,
-		m_light * m_base_color.getBlue() / 255);
-}
-
-void Particle::updateVertices(ClientEnvironment *env, video::SColor color)
-{
-	f32 tx0, tx1, ty0, ty1;
-	v2f scale;
-
-	if (!m_buffer)
-		return;
-
-	video::S3DVertex *vertices = m_buffer->getVertices(m_index);
-
-	if (m_texture.tex != nullptr)
-		scale = m_texture.tex -> scale.blend(m_time / (m_expiration+0.1f));
-	else
-		scale = v2f(1.f, 1.f);
-
-	if (m_p.animation.type != TAT_NONE) {
-		const v2u32 texsize = m_texture.ref->getSize();
-		v2f texcoord, framesize_f;
-		v2u32 framesize;
-		texcoord = m_p.animation.getTextureCoords(texsize, m_animation_frame);
-		m_p.animation.determineParams(texsize, NULL, NULL, &framesize);
-		framesize_f = v2f::from(framesize) / v2f::from(texsize);
-
-		tx0 = m_texpos.X + texcoord.X;
-		tx1 = m_texpos.X + texcoord.X + framesize_f.X * m_texsize.X;
-		ty0 = m_texpos.Y + texcoord.Y;
-		ty1 = m_texpos.Y + texcoord.Y + framesize_f.Y * m_texsize.Y;
-	} else {
-		tx0 = m_texpos.X;
-		tx1 = m_texpos.X + m_texsize.X;
-		ty0 = m_texpos.Y;
-		ty1 = m_texpos.Y + m_texsize.Y;
-	}
-
-	auto half = m_p.size * .5f,
-	     hx   = half * scale.X,
-	     hy   = half * scale.Y;
-	vertices[0] = video::S3DVertex(-hx, -hy,
-		0, 0, 0, 0, color, tx0, ty1);
-	vertices[1] = video::S3DVertex(hx, -hy,
-		0, 0, 0, 0, color, tx1, ty1);
-	vertices[2] = video::S3DVertex(hx, hy,
-		0, 0, 0, 0, color, tx1, ty0);
-	vertices[3] = video::S3DVertex(-hx, hy,
-		0, 0, 0, 0, color, tx0, ty0);
-
-	// Update position -- see #10398
-	auto *player = env->getLocalPlayer();
-	v3s16 camera_offset = env->getCameraOffset();
-
-	for (u16 i = 0; i < 4; i++) {
-		video::S3DVertex &vertex = vertices[i];
-		if (m_p.vertical) {
-			v3f ppos = player->getPosition() / BS;
-			vertex.Pos.rotateXZBy(std::atan2(ppos.Z - m_pos.Z, ppos.X - m_pos.X) /
-				core::DEGTORAD + 90);
-		} else {
-			vertex.Pos.rotateYZBy(player->getPitch());
-			vertex.Pos.rotateXZBy(player->getYaw());
-		}
-		vertex.Pos += m_pos * BS - intToFloat(camera_offset, BS);
-	}
+		light = blend_light(daynight_ratio, LIGHT_SUN, 0);
+	m_lights.emplace(p, light);
+	return light;
 }
 
 /*
@@ -270,18 +122,6 @@ ParticleSpawner::ParticleSpawner(
 		float spawntime = myrand_float() * p.time;
 		m_spawntimes.push_back(spawntime);
 	}
-
-	size_t max_particles = 0; // maximum number of particles likely to be visible at any given time
-	assert(p.time >= 0);
-	if (p.time != 0) {
-		auto maxGenerations = p.time / std::min(p.exptime.start.min, p.exptime.end.min);
-		max_particles = p.amount / maxGenerations;
-	} else {
-		auto longestLife = std::max(p.exptime.start.max, p.exptime.end.max);
-		max_particles = p.amount * longestLife;
-	}
-
-	p_manager->reserveParticleSpace(max_particles * 1.2);
 }
 
 namespace {
@@ -569,7 +409,7 @@ std::optional<u16> ParticleBuffer::allocate()
 		m_free_list.pop_back();
 		auto *vertices = static_cast<video::S3DVertex*>(m_mesh_buffer->getVertices());
 		u16 *indices = m_mesh_buffer->getIndices();
-		// reset vertices, because it is only written in Particle::step()
+		// reset vertices, because they are only written in step()
 		for (u16 i = 0; i < 4; i++)
 			vertices[4 * index + i] = video::S3DVertex();
 		for (u16 i = 0; i < 6; i++)
@@ -586,6 +426,16 @@ std::optional<u16> ParticleBuffer::allocate()
 	std::array<video::S3DVertex, 4> vertices {};
 	m_mesh_buffer->append(&vertices.front(), 4, quad_indices, 6);
 	index = m_count++;
+
+	m_pos.emplace_back();
+	m_velocity.emplace_back();
+	m_acceleration.emplace_back();
+	m_drag.emplace_back();
+	m_time.push_back(0.0f);
+	m_expiration.push_back(0.0f);
+	m_free_motion.push_back(0.0f);
+	m_jitter.push_back(0);
+	m_particles.emplace_back();
 	return index;
 }
 
@@ -595,15 +445,220 @@ void ParticleBuffer::release(u16 index)
 	u16 *indices = m_mesh_buffer->getIndices();
 	for (u16 i = 0; i < 6; i++)
 		indices[6 * index + i] = 0;
+
+	Particle *particle = m_particles[index].get();
+	if (ParticleSpawner *parent = particle->getParent()) {
+		assert(parent->hasActive());
+		parent->decrActive();
+	}
+	if (particle->m_p.collisiondetection) {
+		auto it = std::find(m_colliding.begin(), m_colliding.end(), index);
+		*it = m_colliding.back();
+		m_colliding.pop_back();
+	}
+
+	m_velocity[index] = v3f();
+	m_acceleration[index] = v3f();
+	m_drag[index] = v3f();
+	m_free_motion[index] = 0.0f;
+	m_jitter[index] = 0;
+	m_particles[index].reset();
 	m_free_list.push_back(index);
 }
 
-video::S3DVertex *ParticleBuffer::getVertices(u16 index)
+bool ParticleBuffer::add(std::unique_ptr<Particle> particle)
 {
-	if (index >= m_count)
-		return nullptr;
+	auto index_opt = allocate();
+	if (!index_opt.has_value())
+		return false;
+	const u16 index = index_opt.value();
+	const ParticleParameters &p = particle->m_p;
+
+	m_pos[index] = p.pos;
+	m_velocity[index] = p.vel;
+	m_acceleration[index] = p.acc;
+	m_drag[index] = p.drag;
+	m_time[index] = 0.0f;
+	m_expiration[index] = p.expirationtime;
+	m_free_motion[index] = p.collisiondetection ? 0.0f : 1.0f;
+	m_jitter[index] = p.jitter.min.val != v3f() || p.jitter.max.val != v3f();
+	if (p.collisiondetection)
+		m_colliding.push_back(index);
+	m_particles[index] = std::move(particle);
+	return true;
+}
+
+void ParticleBuffer::step(float dtime, ParticleStepContext &ctx)
+{
+	for (u16 i = 0; i < m_count; i++) {
+		if (m_particles[i] && m_expiration[i] < m_time[i])
+			release(i);
+	}
+	if (isEmpty())
+		return;
+
+	// The loops below run over plain arrays and don't branch, so that
+	// they can be vectorized. Unused indices are at rest and stay there.
+	for (u16 i = 0; i < m_count; i++)
+		m_time[i] += dtime;
+
+	// apply drag (not handled by collisionMoveSimple)
+	for (u16 i = 0; i < m_count; i++)
+		m_velocity[i] -= m_velocity[i] * (m_drag[i] * dtime);
+
+	// brownian motion
+	for (u16 i = 0; i < m_count; i++) {
+		if (m_jitter[i])
+			m_velocity[i] += v3f(m_particles[i]->m_p.jitter.pickWithin()) * dtime;
+	}
+
+	for (u16 i = 0; i < m_count; i++) {
+		const f32 t = m_free_motion[i] * dtime;
+		// apply velocity and acceleration to position
+		m_pos[i] += (m_velocity[i] + m_acceleration[i] * 0.5f * dtime) * t;
+		// apply acceleration to velocity
+		m_velocity[i] += m_acceleration[i] * t;
+	}
+
+	for (u16 i : m_colliding)
+		collide(i, dtime, ctx.env);
+
+	auto *vertices = static_cast<video::S3DVertex *>(m_mesh_buffer->getVertices());
+	for (u16 i = 0; i < m_count; i++) {
+		if (m_particles[i])
+			updateVertices(i, dtime, ctx, &vertices[4 * i]);
+	}
 	m_bounding_box_dirty = true;
-	return &(static_cast<video::S3DVertex *>(m_mesh_buffer->getVertices())[4 * index]);
+}
+
+void ParticleBuffer::collide(u16 index, float dtime, ClientEnvironment *env)
+{
+	const ParticleParameters &p = m_particles[index]->m_p;
+	v3f &velocity = m_velocity[index];
+
+	aabb3f box(v3f(-p.size / 2.0f), v3f(p.size / 2.0f));
+	v3f p_pos = m_pos[index] * BS;
+	v3f p_velocity = velocity * BS;
+	collisionMoveResult r = collisionMoveSimple(env, env->getGameDef(),
+		box, 0.0f, dtime, &p_pos, &p_velocity, m_acceleration[index] * BS, nullptr,
+		p.object_collision);
+
+	f32 bounciness = p.bounce.pickWithin();
+	if (r.collides && (p.collision_removal || bounciness > 0)) {
+		if (p.collision_removal) {
+			// force expiration of the particle
+			m_expiration[index] = -1.0f;
+		} else if (bounciness > 0) {
+			/* cheap way to get a decent bounce effect is to only invert the
+			 * largest component of the velocity vector, so e.g. you don't
+			 * have a rock immediately bounce back in your face when you try
+			 * to skip it across the water (as would happen if we simply
+			 * downscaled and negated the velocity vector). this means
+			 * bounciness will work properly for cubic objects, but meshes
+			 * with diagonal angles and entities will not yield the correct
+			 * visual. this is probably unavoidable */
+			v3f av = vecAbsolute(velocity);
+			if (av.Y > av.X && av.Y > av.Z) {
+				velocity.Y = -(velocity.Y * bounciness);
+			} else if (av.X > av.Y && av.X > av.Z) {
+				velocity.X = -(velocity.X * bounciness);
+			} else if (av.Z > av.Y && av.Z > av.X) {
+				velocity.Z = -(velocity.Z * bounciness);
+			} else { // well now we're in a bit of a pickle
+				velocity = -(velocity * bounciness);
+			}
+		}
+	} else {
+		velocity = p_velocity / BS;
+	}
+	m_pos[index] = p_pos / BS;
+}
+
+void ParticleBuffer::updateVertices(u16 index, float dtime, ParticleStepContext &ctx,
+		video::S3DVertex *vertices)
+{
+	Particle &particle = *m_particles[index];
+	const ParticleParameters &p = particle.m_p;
+	const ClientParticleTexRef &texture = particle.m_texture;
+	const v3f pos = m_pos[index];
+	const f32 lifetime = m_time[index] / (m_expiration[index] + 0.1f);
+
+	if (p.animation.type != TAT_NONE) {
+		particle.m_animation_time += dtime;
+		int frame_length_i = 0;
+		p.animation.determineParams(
+				texture.ref->getSize(),
+				NULL, &frame_length_i, NULL);
+		float frame_length = frame_length_i / 1000.0;
+		while (particle.m_animation_time > frame_length) {
+			particle.m_animation_frame++;
+			particle.m_animation_time -= frame_length;
+		}
+	}
+
+	// animate particle alpha in accordance with settings
+	float alpha = 1.f;
+	if (texture.tex != nullptr)
+		alpha = texture.tex->alpha.blend(lifetime);
+
+	// Update lighting
+	v3s16 light_pos(
+		floor(pos.X + 0.5),
+		floor(pos.Y + 0.5),
+		floor(pos.Z + 0.5)
+	);
+	u8 light = decode_light(ctx.getLight(light_pos) + p.glow);
+	const video::SColor &base_color = particle.m_base_color;
+	video::SColor color(255 * alpha,
+		light * base_color.getRed() / 255,
+		light * base_color.getGreen() / 255,
+		light * base_color.getBlue() / 255);
+
+	// Update model
+	f32 tx0, tx1, ty0, ty1;
+	v2f scale;
+
+	if (texture.tex != nullptr)
+		scale = texture.tex->scale.blend(lifetime);
+	else
+		scale = v2f(1.f, 1.f);
+
+	if (p.animation.type != TAT_NONE) {
+		const v2u32 texsize = texture.ref->getSize();
+		v2f texcoord, framesize_f;
+		v2u32 framesize;
+		texcoord = p.animation.getTextureCoords(texsize, particle.m_animation_frame);
+		p.animation.determineParams(texsize, NULL, NULL, &framesize);
+		framesize_f = v2f::from(framesize) / v2f::from(texsize);
+
+		tx0 = particle.m_texpos.X + texcoord.X;
+		tx1 = particle.m_texpos.X + texcoord.X + framesize_f.X * particle.m_texsize.X;
+		ty0 = particle.m_texpos.Y + texcoord.Y;
+		ty1 = particle.m_texpos.Y + texcoord.Y + framesize_f.Y * particle.m_texsize.Y;
+	} else {
+		tx0 = particle.m_texpos.X;
+		tx1 = particle.m_texpos.X + particle.m_texsize.X;
+		ty0 = particle.m_texpos.Y;
+		ty1 = particle.m_texpos.Y + particle.m_texsize.Y;
+	}
+
+	v3f right = ctx.right;
+	v3f up = ctx.up;
+	if (p.vertical) {
+		right = v3f(1, 0, 0);
+		right.rotateXZBy(std::atan2(ctx.player_pos.Z - pos.Z,
+				ctx.player_pos.X - pos.X) / core::DEGTORAD + 90);
+		up = v3f(0, 1, 0);
+	}
+	const f32 half = p.size * .5f;
+	right *= half * scale.X;
+	up *= half * scale.Y;
+
+	const v3f center = pos * BS - ctx.camera_offset;
+	vertices[0] = video::S3DVertex(center - right - up, v3f(), color, v2f(tx0, ty1));
+	vertices[1] = video::S3DVertex(center + right - up, v3f(), color, v2f(tx1, ty1));
+	vertices[2] = video::S3DVertex(center + right + up, v3f(), color, v2f(tx1, ty0));
+	vertices[3] = video::S3DVertex(center - right + up, v3f(), color, v2f(tx0, ty0));
 }
 
 void ParticleBuffer::OnRegisterSceneNode()
@@ -709,22 +764,12 @@ void ParticleManager::stepParticles(float dtime)
 {
 	MutexAutoLock lock(m_particle_list_lock);
 
-	for (size_t i = 0; i < m_particles.size();) {
-		Particle &p = *m_particles[i];
-		if (p.isExpired()) {
-			ParticleSpawner *parent = p.getParent();
-			if (parent) {
-				assert(parent->hasActive());
-				parent->decrActive();
-			}
-			// delete
-			m_particles[i] = std::move(m_particles.back());
-			m_particles.pop_back();
-		} else {
-			p.step(dtime, m_env);
-			++i;
-		}
-	}
+	if (m_particle_buffers.empty())
+		return;
+
+	ParticleStepContext ctx(m_env);
+	for (auto &buffer : m_particle_buffers)
+		buffer->step(dtime, ctx);
 }
 
 void ParticleManager::stepBuffers(float dtime)
@@ -764,8 +809,6 @@ void ParticleManager::clearAll()
 	m_particle_spawners.clear();
 	m_dying_particle_spawners.clear();
 
-	m_particles.clear();
-
 	// have to remove from scene first because it keeps a reference
 	for (auto &it : m_particle_buffers)
 		it->remove();
@@ -951,13 +994,6 @@ void ParticleManager::addNodeParticle(IGameDef *gamedef,
 		color));
 }
 
-void ParticleManager::reserveParticleSpace(size_t max_estimate)
-{
-	MutexAutoLock lock(m_particle_list_lock);
-
-	m_particles.reserve(m_particles.size() + max_estimate);
-}
-
 static void setBlendMode(video::SMaterial &material, BlendMode blendmode)
 {
 	video::E_BLEND_FACTOR bfsrc, bfdst;
@@ -1033,19 +1069,12 @@ bool ParticleManager::addParticle(std::unique_ptr<Particle> toadd)
 	auto material = getMaterialForParticle(toadd.get());
 
 	ParticleBuffer *found = nullptr;
-	// simple shortcut when multiple particles of the same type get added
-	if (!m_particles.empty()) {
-		auto &last = m_particles.back();
-		if (last->getBuffer() && last->getBuffer()->getMaterial(0) == material)
-			found = last->getBuffer();
-	}
-	// search fitting buffer
-	if (!found) {
-		for (auto &buffer : m_particle_buffers) {
-			if (buffer->getMaterial(0) == material) {
-				found = buffer.get();
-				break;
-			}
+	// search fitting buffer, particles of the same type tend to be added
+	// together with the newest buffer
+	for (auto it = m_particle_buffers.rbegin(); it != m_particle_buffers.rend(); ++it) {
+		if ((*it)->getMaterial(0) == material) {
+			found = it->get();
+			break;
 		}
 	}
 	// or create a new one
@@ -1055,11 +1084,10 @@ bool ParticleManager::addParticle(std::unique_ptr<Particle> toadd)
 		m_particle_buffers.push_back(std::move(tmp));
 	}
 
-	if (!toadd->attachToBuffer(found)) {
+	if (!found->add(std::move(toadd))) {
 		infostream << "ParticleManager: buffer full, dropping particle" << std::endl;
 		return false;
 	}
-	m_particles.push_back(std::move(toadd));
 	return true;
 }
 
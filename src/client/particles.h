@@ -12,6 +12,7 @@
 
 #include <mutex>
 #include <memory>
+#include <optional>
 #include <vector>
 #include <unordered_map>
 #include "../particles.h"
@@ -61,8 +62,13 @@ struct ClientParticleTexRef
 class ParticleSpawner;
 class ParticleBuffer;
 
+/*
+	Properties of a particle that stay the same while it moves.
+	The simulation state lives in the ParticleBuffer it belongs to.
+*/
 class Particle
 {
+	friend class ParticleBuffer;
 public:
 	Particle(
 		const ParticleParameters &p,
@@ -74,15 +80,8 @@ class Particle
 		std::unique_ptr<ClientParticleTexture> owned_texture = nullptr
 	);
 
-	~Particle();
-
 	DISABLE_CLASS_COPY(Particle)
 
-	void step(float dtime, ClientEnvironment *env);
-
-	bool isExpired () const
-	{ return m_expiration < m_time; }
-
 	ParticleSpawner *getParent() const { return m_parent; }
 
 	const ClientParticleTexRef &getTextureRef() const { return m_texture; }
@@ -90,28 +89,13 @@ class Particle
 	ParticleParamTypes::BlendMode getBlendMode() const
 	{ return m_texture.tex ? m_texture.tex->blendmode : m_p.texture.blendmode; }
 
-	ParticleBuffer *getBuffer() const { return m_buffer; }
-	bool attachToBuffer(ParticleBuffer *buffer);
-
 private:
-	video::SColor updateLight(ClientEnvironment *env);
-	void updateVertices(ClientEnvironment *env, video::SColor color);
-
-	ParticleBuffer *m_buffer = nullptr;
-	u16 m_index; // index in m_buffer
-
-	float m_time = 0.0f;
-	float m_expiration;
-
 	// Color without lighting
 	video::SColor m_base_color;
 
 	ClientParticleTexRef m_texture;
 	v2f m_texpos;
 	v2f m_texsize;
-	v3f m_pos;
-	v3f m_velocity;
-	v3f m_acceleration;
 
 	const ParticleParameters m_p;
 
@@ -123,6 +107,29 @@ class Particle
 	std::unique_ptr<ClientParticleTexture> m_owned_texture;
 };
 
+/*
+	Data shared by all particles during one ParticleManager step
+*/
+struct ParticleStepContext
+{
+	explicit ParticleStepContext(ClientEnvironment *env);
+
+	// Blended light at the node, looked up once per step
+	u8 getLight(v3s16 p);
+
+	ClientEnvironment *env;
+	u32 daynight_ratio;
+	// Local player position, in nodes
+	v3f player_pos;
+	v3f camera_offset;
+	// Axes of the quads of particles that face the camera
+	v3f right;
+	v3f up;
+
+private:
+	std::unordered_map<v3s16, u8> m_lights;
+};
+
 class ParticleSpawner
 {
 public:
@@ -163,14 +170,12 @@ class ParticleBuffer : public scene::ISceneNode
 	// for pointer stability
 	DISABLE_CLASS_COPY(ParticleBuffer)
 
-	/// Reserves one more slot for a particle (4 vertices, 6 indices)
-	/// @return particle index within buffer
-	std::optional<u16> allocate();
-	/// Frees the particle at `index`
-	void release(u16 index);
+	/// Takes ownership of the particle and starts simulating it
+	/// @return false if the buffer is full
+	bool add(std::unique_ptr<Particle> particle);
 
-	/// @return video::S3DVertex[4]
-	video::S3DVertex *getVertices(u16 index);
+	/// Removes expired particles, moves the others and updates their vertices
+	void step(float dtime, ParticleStepContext &ctx);
 
 	inline bool isEmpty() const {
 		return m_free_list.size() == m_count;
@@ -193,6 +198,16 @@ class ParticleBuffer : public scene::ISceneNode
 	static constexpr u16 MAX_PARTICLES_PER_BUFFER = 16000;
 
 private:
+	/// Reserves one more slot for a particle (4 vertices, 6 indices)
+	/// @return particle index within buffer
+	std::optional<u16> allocate();
+	/// Frees the particle at `index`
+	void release(u16 index);
+
+	void collide(u16 index, float dtime, ClientEnvironment *env);
+	void updateVertices(u16 index, float dtime, ParticleStepContext &ctx,
+			video::S3DVertex *vertices);
+
 	irr_ptr<scene::SMeshBuffer> m_mesh_buffer;
 	// unused (e.g. expired) particle indices for re-use
 	std::vector<u16> m_free_list;
@@ -201,6 +216,23 @@ class ParticleBuffer : public scene::ISceneNode
 	// total count of contained particles
 	u16 m_count = 0;
 	mutable bool m_bounding_box_dirty = true;
+
+	// Simulation state by particle index. Unused indices are kept at rest
+	// so that the integration loops don't need to skip them.
+	std::vector<v3f> m_pos;
+	std::vector<v3f> m_velocity;
+	std::vector<v3f> m_acceleration;
+	std::vector<v3f> m_drag;
+	std::vector<f32> m_time;
+	std::vector<f32> m_expiration;
+	// 1 for particles moved by the integration loop, 0 for those with
+	// collision detection, which are moved by collide() instead
+	std::vector<f32> m_free_motion;
+	std::vector<u8> m_jitter;
+	// null for unused indices
+	std::vector<std::unique_ptr<Particle>> m_particles;
+	// Indices of the particles with collision detection
+	std::vector<u16> m_colliding;
 };
 
 /**
@@ -225,8 +257,6 @@ class ParticleManager
 	void addNodeParticle(IGameDef *gamedef, LocalPlayer *player, v3s16 pos,
 		const MapNode &n, const ContentFeatures &f);
 
-	void reserveParticleSpace(size_t max_estimate);
-
 	/**
 	 * This function is only used by client particle spawners
 	 *
@@ -258,7 +288,6 @@ class ParticleManager
 
 	void clearAll();
 
-	std::vector<std::unique_ptr<Particle>> m_particles;
 	std::unordered_map<u64, std::unique_ptr<ParticleSpawner>> m_particle_spawners;
 	std::vector<std::unique_ptr<ParticleSpawner>> m_dying_particle_spawners;
 	std::vector<irr_ptr<ParticleBuffer>> m_particle_buffers;
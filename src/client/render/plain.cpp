@@ -15,7 +15,8 @@
 #include "client/content_cao.h"
 #include "nodedef.h"
 #include "settings.h"
-#include "client/mapblock_mesh.h"	
+#include "client/mapblock_mesh.h"
+#include "client/settings_snapshot.h"
 #include "script/scripting_client.h"
 #include "core.h"
 
@@ -59,59 +60,44 @@ void DrawHUD::run(PipelineContext &context)
 		context.hud->drawLuaElements(context.client->getCamera()->getOffset());
 		context.client->getCamera()->drawNametags();
 
-		if (g_settings->getBool("enable_health_esp")) {	
+		if (SettingsSnapshot::get()->enable_health_esp) {
 			context.client->getCamera()->drawHealthESP(context.dtime);
 		}
 	}
 	context.device->getGUIEnvironment()->drawAll();
 }
 
-u8 DrawTracersAndESP::getDifferentNeighborFlags(v3s16 p, Map &map, const MapNode &node) {
-	u8 flags = 0;
-	for (int i = 0; i < 6; ++i) {
-		MapNode neighbor = map.getNode(p + directions[i]);
-		if (neighbor.getContent() != node.getContent()) {
-			flags |= (1 << i);
-		}
-	}
-	return flags;
-}
-
 void DrawTracersAndESP::run(PipelineContext &context)
 {
 	auto driver = context.device->getVideoDriver();
 
-	draw_entity_esp = g_settings->getBool("enable_entity_esp");
-	draw_entity_tracers = g_settings->getBool("enable_entity_tracers");
-	draw_player_esp = g_settings->getBool("enable_player_esp");
-	draw_player_tracers = g_settings->getBool("enable_player_tracers");
-	draw_node_esp = g_settings->getBool("enable_node_esp");
-	draw_node_tracers = g_settings->getBool("enable_node_tracers");
-
-	v3f entity_color = g_settings->getV3F("entity_esp_color").value();
-	v3f friend_color = g_settings->getV3F("friend_esp_color").value();
-	v3f enemy_color = g_settings->getV3F("enemy_esp_color").value();
-	v3f allied_color = g_settings->getV3F("allied_esp_color").value();
-	v3f staff_color = g_settings->getV3F("staff_esp_color").value();
-
-	entity_esp_color = video::SColor(255, entity_color.X, entity_color.Y, entity_color.Z);
-	friend_esp_color = video::SColor(255, friend_color.X, friend_color.Y, friend_color.Z);
-	enemy_esp_color = video::SColor(255, enemy_color.X, enemy_color.Y, enemy_color.Z);
-	allied_esp_color = video::SColor(255, allied_color.X, allied_color.Y, allied_color.Z);
-	staff_esp_color = video::SColor(255, staff_color.X, staff_color.Y, staff_color.Z);
+	const auto settings = SettingsSnapshot::get();
+
+	draw_entity_esp = settings->enable_entity_esp;
+	draw_entity_tracers = settings->enable_entity_tracers;
+	draw_player_esp = settings->enable_player_esp;
+	draw_player_tracers = settings->enable_player_tracers;
+	draw_node_esp = settings->enable_node_esp;
+	draw_node_tracers = settings->enable_node_tracers;
+
+	entity_esp_color = settings->entity_esp_color;
+	friend_esp_color = settings->friend_esp_color;
+	enemy_esp_color = settings->enemy_esp_color;
+	allied_esp_color = settings->allied_esp_color;
+	staff_esp_color = settings->staff_esp_color;
 
 	int targetDT = 2;
 	int targetEO = 255;
 	int targetFO = 127;
-	playerDT = g_settings->getU32("esp.player.drawType");
-	playerEO = g_settings->getU32("esp.player.edgeOpacity");
-	playerFO = g_settings->getU32("esp.player.faceOpacity");
-	entityDT = g_settings->getU32("esp.entity.drawType");
-	entityEO = g_settings->getU32("esp.entity.edgeOpacity");
-	entityFO = g_settings->getU32("esp.entity.faceOpacity");
-	nodeDT = g_settings->getU32("esp.node.drawType");
-	nodeEO = g_settings->getU32("esp.node.edgeOpacity");
-	nodeFO = g_settings->getU32("esp.node.faceOpacity");
+	playerDT = settings->esp_player_draw_type;
+	playerEO = settings->esp_player_edge_opacity;
+	playerFO = settings->esp_player_face_opacity;
+	entityDT = settings->esp_entity_draw_type;
+	entityEO = settings->esp_entity_edge_opacity;
+	entityFO = settings->esp_entity_face_opacity;
+	nodeDT = settings->esp_node_draw_type;
+	nodeEO = settings->esp_node_edge_opacity;
+	nodeFO = settings->esp_node_face_opacity;
 
 	LocalPlayer *player = context.client->getEnv().getLocalPlayer();
 	ClientEnvironment &env = context.client->getEnv();
@@ -135,6 +121,11 @@ void DrawTracersAndESP::run(PipelineContext &context)
 	material.ZWriteEnable = irr::video::EZW_OFF;
 	driver->setMaterial(material);
 
+	m_player_boxes.clear();
+	m_entity_boxes.clear();
+	m_target_boxes.clear();
+	m_tracers.clear();
+
 	//int pCnt = 0, eCnt = 0, nCnt = 0;
 
  	if (draw_entity_esp || draw_entity_tracers || draw_player_esp || draw_player_tracers) {
@@ -143,7 +134,7 @@ void DrawTracersAndESP::run(PipelineContext &context)
 		env.getAllActiveObjects(current_pos, allObjects);
 		for (auto &clientobject : allObjects) {
 			ClientActiveObject *cao = clientobject.obj;
-			if ((cao->isLocalPlayer() && !g_settings->getBool("freecam")))
+			if ((cao->isLocalPlayer() && !settings->freecam))
 				continue;
 			GenericCAO *obj = dynamic_cast<GenericCAO *>(cao);
 			if (!obj) {
@@ -193,20 +184,20 @@ void DrawTracersAndESP::run(PipelineContext &context)
 			box.MaxEdge += pos;
 
 			if (draw_esp) {
-				if (RenderingCore::combat_target != NULL && obj->getId() == RenderingCore::combat_target && (g_settings->getBool("enable_combat_target_hud.target_highlight") && g_settings->getBool("enable_combat_target_hud"))) {
-					driver->draw3DBox(box, RenderingCore::target_esp_color, targetDT, targetEO, targetFO);
+				if (RenderingCore::combat_target != NULL && obj->getId() == RenderingCore::combat_target && (settings->enable_combat_target_hud_target_highlight && settings->enable_combat_target_hud)) {
+					m_target_boxes.addBox(box, RenderingCore::target_esp_color);
 				} else {
 					if (is_player) {
 						//pCnt += 1;
-						driver->draw3DBox(box, color, playerDT, playerEO, playerFO);
+						m_player_boxes.addBox(box, color);
 					} else if (!cao->getParent()) {
 						//eCnt += 1;
-						driver->draw3DBox(box, color, entityDT, entityEO, entityFO);
+						m_entity_boxes.addBox(box, color);
 					}			
 				}
 			}
 			if (draw_tracers) {
-				driver->draw3DLine(eye_pos, box.getCenter(), color);
+				m_tracers.addLine(eye_pos, box.getCenter(), color);
 			}
 		}
 	}
@@ -214,35 +205,46 @@ void DrawTracersAndESP::run(PipelineContext &context)
 		Map &map = env.getMap();
 		std::vector<v3s16> positions;
 		map.listAllLoadedBlocks(positions);
+
+		const v3f player_pos = player->getLegitPosition();
+		const f32 range = wanted_range * BS;
+		const s16 cell_size = context.client->getMeshGrid().cell_size;
+		const f32 cell_radius = cell_size * MAP_BLOCKSIZE * BS * 0.5f * std::sqrt(3.0f);
 		for (v3s16 blockp : positions) {
 			MapBlock *block = map.getBlockNoCreate(blockp);
-			if (!block->mesh)
+			MapBlockMesh *mesh = block->mesh;
+			if (!mesh)
 				continue;
-			for (v3s16 p : block->mesh->esp_nodes) {
-				v3f pos = intToFloat(p, BS) - camera_offset;
-				if ((intToFloat(p, BS) - player->getLegitPosition()).getLengthSQ() > (wanted_range*BS) * (wanted_range*BS))
-					continue;
-				MapNode node = map.getNode(p);
-				//nCnt += 1;
-				u8 diffNeighbors = getDifferentNeighborFlags(p, map, node);
-				if (!diffNeighbors)
-					continue;
-				std::vector<aabb3f> boxes;
-				node.getSelectionBoxes(context.client->getNodeDefManager(), &boxes, node.getNeighbors(p, &map));
-				video::SColor color = context.client->getNodeDefManager()->get(node).getNodeEspColor();
-				for (aabb3f box : boxes) {
-					box.MinEdge += pos;
-					box.MaxEdge += pos;
-					if (draw_node_esp) {
-						driver->draw3DBox(box, color, nodeDT, nodeEO, nodeFO, diffNeighbors);
-					}
-					if (draw_node_tracers)
-						driver->draw3DLine(eye_pos, box.getCenter(), color);
+
+			// The overlay geometry is prebuilt per mesh, cull whole meshes
+			const v3f mesh_pos = intToFloat(block->getPosRelative(), BS);
+			v3f center = mesh_pos + v3f(cell_size * MAP_BLOCKSIZE * BS * 0.5f);
+			if (center.getDistanceFrom(player_pos) > range + cell_radius)
+				continue;
+
+			if (draw_node_esp && !mesh->getOverlay().empty()) {
+				core::matrix4 transform;
+				transform.setTranslation(mesh_pos - camera_offset);
+				driver->setTransform(video::ETS_WORLD, transform);
+				mesh->getOverlay().drawBoxes(driver, nodeDT, nodeEO, nodeFO);
+			}
+			if (draw_node_tracers) {
+				for (const OverlayTarget &target : mesh->getOverlayTargets()) {
+					v3f pos = mesh_pos + target.pos;
+					if (pos.getDistanceFromSQ(player_pos) > range * range)
+						continue;
+					m_tracers.addLine(eye_pos, pos - camera_offset, target.color);
 				}
 			}
 		}
 	}
 
+	driver->setTransform(video::ETS_WORLD, core::IdentityMatrix);
+	m_player_boxes.drawBoxes(driver, playerDT, playerEO, playerFO);
+	m_entity_boxes.drawBoxes(driver, entityDT, entityEO, entityFO);
+	m_target_boxes.drawBoxes(driver, targetDT, targetEO, targetFO);
+	m_tracers.drawLines(driver);
+
 	driver->setMaterial(oldmaterial);
 }
 
@@ -260,8 +262,9 @@ void DrawTaskBlocksAndTracers::run(PipelineContext &context)
 {
 	auto driver = context.device->getVideoDriver();
 
-	draw_task_blocks = g_settings->getBool("enable_task_nodes");
-	draw_task_tracers = g_settings->getBool("enable_task_tracers");
+	const auto settings = SettingsSnapshot::get();
+	draw_task_blocks = settings->enable_task_nodes;
+	draw_task_tracers = settings->enable_task_tracers;
 
 	float time = context.device->getTimer()->getTime() / 1000.0f;
 
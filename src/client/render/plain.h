@@ -8,6 +8,7 @@
 #include "pipeline.h"
 #include "map.h"
 #include "mapnode.h"
+#include "client/meshgen/overlay_buffer.h"
 
 /**
  * Implements a pipeline step that renders the 3D scene
@@ -65,16 +66,11 @@ class DrawTracersAndESP : public RenderStep
 	virtual void run(PipelineContext &context) override;
 
 private:
-	u8 getDifferentNeighborFlags(v3s16 p, Map &map, const MapNode &node);
-
-	static inline const v3s16 directions[6] = {
-		v3s16(0, 0, -1),  // Front
-		v3s16(0, 0, 1), // Back
-		v3s16(-1, 0, 0), // Left
-		v3s16(1, 0, 0),  // Right
-		v3s16(0, 1, 0),  // Top
-		v3s16(0, -1, 0)  // Bottom
-	};
+	// Geometry collected while iterating the objects, drawn in a few batches
+	OverlayBuffer m_player_boxes;
+	OverlayBuffer m_entity_boxes;
+	OverlayBuffer m_target_boxes;
+	OverlayBuffer m_tracers;
 
 	bool draw_entity_esp;
 	bool draw_entity_tracers;
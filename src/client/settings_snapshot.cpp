@@ -0,0 +1,190 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "settings_snapshot.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "settings.h"
+
+const static std::string SettingsSnapshot_names[] = {
+	"fullbright", "enable_health_esp", "enable_health_esp.players_only",
+	"enable_health_esp.type", "enable_entity_esp", "enable_entity_tracers",
+	"enable_player_esp", "enable_player_tracers", "enable_node_esp",
+	"enable_node_tracers", "enable_combat_target_hud",
+	"enable_combat_target_hud.target_highlight", "enable_task_nodes",
+	"enable_task_tracers",
+	"entity_esp_color", "friend_esp_color", "enemy_esp_color",
+	"allied_esp_color", "staff_esp_color",
+	"esp.player.drawType", "esp.player.edgeOpacity", "esp.player.faceOpacity",
+	"esp.entity.drawType", "esp.entity.edgeOpacity", "esp.entity.faceOpacity",
+	"esp.node.drawType", "esp.node.edgeOpacity", "esp.node.faceOpacity",
+	"float_above_parent", "fov_setting", "fov.step", "left_hand", "nobob",
+	"freecam", "free_move", "detached_camera", "lua_control", "spider", "step",
+	"step.mult", "scaffold", "airjump", "autosneak", "BHOP", "BHOP.jump",
+	"BHOP.sprint", "BHOP.speed", "jetpack", "no_slow", "entity_speed",
+	"antislip", "movement_speed_fast",
+	"friends", "staff", "enemies", "allies"
+};
+
+static video::SColor readColor(const std::string &name)
+{
+	v3f c = g_settings->getV3F(name).value_or(v3f());
+	return video::SColor(255, c.X, c.Y, c.Z);
+}
+
+static Json::Value readJson(const std::string &name)
+{
+	try {
+		return g_settings->getJson(name);
+	} catch (std::exception &e) {
+		return Json::Value();
+	}
+}
+
+void SettingsSnapshot::readGlobalSettings()
+{
+	fullbright = g_settings->getBool("fullbright");
+	enable_health_esp = g_settings->getBool("enable_health_esp");
+	enable_health_esp_players_only = g_settings->getBool("enable_health_esp.players_only");
+	health_esp_bar = g_settings->exists("enable_health_esp.type") &&
+			g_settings->get("enable_health_esp.type") == "Health Bar";
+	enable_entity_esp = g_settings->getBool("enable_entity_esp");
+	enable_entity_tracers = g_settings->getBool("enable_entity_tracers");
+	enable_player_esp = g_settings->getBool("enable_player_esp");
+	enable_player_tracers = g_settings->getBool("enable_player_tracers");
+	enable_node_esp = g_settings->getBool("enable_node_esp");
+	enable_node_tracers = g_settings->getBool("enable_node_tracers");
+	enable_combat_target_hud = g_settings->getBool("enable_combat_target_hud");
+	enable_combat_target_hud_target_highlight =
+			g_settings->getBool("enable_combat_target_hud.target_highlight");
+	enable_task_nodes = g_settings->getBool("enable_task_nodes");
+	enable_task_tracers = g_settings->getBool("enable_task_tracers");
+
+	entity_esp_color = readColor("entity_esp_color");
+	friend_esp_color = readColor("friend_esp_color");
+	enemy_esp_color = readColor("enemy_esp_color");
+	allied_esp_color = readColor("allied_esp_color");
+	staff_esp_color = readColor("staff_esp_color");
+
+	esp_player_draw_type = g_settings->getU32("esp.player.drawType");
+	esp_player_edge_opacity = g_settings->getU32("esp.player.edgeOpacity");
+	esp_player_face_opacity = g_settings->getU32("esp.player.faceOpacity");
+	esp_entity_draw_type = g_settings->getU32("esp.entity.drawType");
+	esp_entity_edge_opacity = g_settings->getU32("esp.entity.edgeOpacity");
+	esp_entity_face_opacity = g_settings->getU32("esp.entity.faceOpacity");
+	esp_node_draw_type = g_settings->getU32("esp.node.drawType");
+	esp_node_edge_opacity = g_settings->getU32("esp.node.edgeOpacity");
+	esp_node_face_opacity = g_settings->getU32("esp.node.faceOpacity");
+
+	float_above_parent = g_settings->getBool("float_above_parent");
+	fov_setting = g_settings->getBool("fov_setting");
+	fov_step = g_settings->getFloat("fov.step");
+	left_hand = g_settings->getBool("left_hand");
+	nobob = g_settings->getBool("nobob");
+
+	freecam = g_settings->getBool("freecam");
+	free_move = g_settings->getBool("free_move");
+	detached_camera = g_settings->getBool("detached_camera");
+	lua_control = g_settings->getBool("lua_control");
+	spider = g_settings->getBool("spider");
+	step = g_settings->getBool("step");
+	step_mult = g_settings->getFloat("step.mult");
+	scaffold = g_settings->getBool("scaffold");
+	airjump = g_settings->getBool("airjump");
+	autosneak = g_settings->getBool("autosneak");
+	bhop = g_settings->getBool("BHOP");
+	bhop_jump = g_settings->getBool("BHOP.jump");
+	bhop_sprint = g_settings->getBool("BHOP.sprint");
+	bhop_speed = g_settings->getBool("BHOP.speed");
+	jetpack = g_settings->getBool("jetpack");
+	no_slow = g_settings->getBool("no_slow");
+	entity_speed = g_settings->getBool("entity_speed");
+	antislip = g_settings->getBool("antislip");
+	movement_speed_fast = g_settings->getFloat("movement_speed_fast");
+
+	friends = readJson("friends");
+	staff = readJson("staff");
+	enemies = readJson("enemies");
+	allies = readJson("allies");
+}
+
+namespace {
+
+class SettingsSnapshotPublisher
+{
+public:
+	SettingsSnapshotPublisher()
+	{
+		publish();
+		for (auto &name : SettingsSnapshot_names)
+			g_settings->registerChangedCallback(name, &settingsChangedCallback, this);
+	}
+
+	~SettingsSnapshotPublisher()
+	{
+		if (g_settings)
+			g_settings->deregisterAllChangedCallbacks(this);
+	}
+
+	const std::shared_ptr<const SettingsSnapshot> &get()
+	{
+		// Each thread keeps its own reference to the current snapshot and
+		// only takes the lock after a new one was published
+		thread_local CachedSnapshot cached;
+		u32 generation = m_generation.load(std::memory_order_acquire);
+		if (cached.generation != generation) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			cached.snapshot = m_current;
+			cached.generation = m_generation.load(std::memory_order_relaxed);
+		}
+		return cached.snapshot;
+	}
+
+	void publish()
+	{
+		// Serialize publishers so that an older read can't replace a newer one
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto snapshot = std::make_shared<SettingsSnapshot>();
+		snapshot->readGlobalSettings();
+		// Threads that still hold the old snapshot keep it alive
+		m_current = std::move(snapshot);
+		m_generation.fetch_add(1, std::memory_order_release);
+	}
+
+private:
+	struct CachedSnapshot
+	{
+		// 0 is never published, so every thread loads the first snapshot
+		u32 generation = 0;
+		std::shared_ptr<const SettingsSnapshot> snapshot;
+	};
+
+	static void settingsChangedCallback(const std::string &name, void *data)
+	{
+		((SettingsSnapshotPublisher *)data)->publish();
+	}
+
+	std::atomic<u32> m_generation{0};
+	// Protected by m_mutex
+	std::shared_ptr<const SettingsSnapshot> m_current;
+	std::mutex m_mutex;
+};
+
+SettingsSnapshotPublisher &getPublisher()
+{
+	static SettingsSnapshotPublisher publisher;
+	return publisher;
+}
+
+}
+
+const std::shared_ptr<const SettingsSnapshot> &SettingsSnapshot::get()
+{
+	return getPublisher().get();
+}
+
+void SettingsSnapshot::refresh()
+{
+	getPublisher().publish();
+}
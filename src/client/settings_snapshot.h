@@ -0,0 +1,103 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <memory>
+#include <json/json.h>
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include <SColor.h>
+
+/*
+	Typed, immutable copy of the client settings read in per-frame code
+	(render passes, camera, local player physics) and by the mesh workers.
+
+	A new snapshot is built and published whenever one of the settings
+	changes. Reading it parses no strings and takes no lock, except for
+	the first read on each thread after a change, so hot paths should use
+	SettingsSnapshot::get() instead of querying g_settings. Copy the
+	returned pointer to keep using the same values across calls that may
+	read the settings again; an old snapshot is freed once nobody holds it
+	anymore. Worker threads should rather receive the few values they need
+	with their job.
+*/
+struct SettingsSnapshot
+{
+	// Rendering
+	bool fullbright = false;
+	bool enable_health_esp = false;
+	bool enable_health_esp_players_only = false;
+	// enable_health_esp.type is "Health Bar"
+	bool health_esp_bar = false;
+	bool enable_entity_esp = false;
+	bool enable_entity_tracers = false;
+	bool enable_player_esp = false;
+	bool enable_player_tracers = false;
+	bool enable_node_esp = false;
+	bool enable_node_tracers = false;
+	bool enable_combat_target_hud = false;
+	bool enable_combat_target_hud_target_highlight = false;
+	bool enable_task_nodes = false;
+	bool enable_task_tracers = false;
+
+	video::SColor entity_esp_color;
+	video::SColor friend_esp_color;
+	video::SColor enemy_esp_color;
+	video::SColor allied_esp_color;
+	video::SColor staff_esp_color;
+
+	u32 esp_player_draw_type = 0;
+	u32 esp_player_edge_opacity = 0;
+	u32 esp_player_face_opacity = 0;
+	u32 esp_entity_draw_type = 0;
+	u32 esp_entity_edge_opacity = 0;
+	u32 esp_entity_face_opacity = 0;
+	u32 esp_node_draw_type = 0;
+	u32 esp_node_edge_opacity = 0;
+	u32 esp_node_face_opacity = 0;
+
+	// Camera
+	bool float_above_parent = false;
+	bool fov_setting = false;
+	f32 fov_step = 0.0f;
+	bool left_hand = false;
+	bool nobob = false;
+
+	// Local player
+	bool freecam = false;
+	bool free_move = false;
+	bool detached_camera = false;
+	bool lua_control = false;
+	bool spider = false;
+	bool step = false;
+	f32 step_mult = 1.0f;
+	bool scaffold = false;
+	bool airjump = false;
+	bool autosneak = false;
+	bool bhop = false;
+	bool bhop_jump = false;
+	bool bhop_sprint = false;
+	bool bhop_speed = false;
+	bool jetpack = false;
+	bool no_slow = false;
+	bool entity_speed = false;
+	bool antislip = false;
+	f32 movement_speed_fast = 0.0f;
+
+	// Player lists, keyed by server address (null if unparseable)
+	Json::Value friends;
+	Json::Value staff;
+	Json::Value enemies;
+	Json::Value allies;
+
+	void readGlobalSettings();
+
+	// Returns the most recently published snapshot, as seen by this thread
+	static const std::shared_ptr<const SettingsSnapshot> &get();
+
+	// Publishes a new snapshot right away. Use this before acting on a
+	// settings change from another change callback, as the order in which
+	// callbacks run is not defined.
+	static void refresh();
+};
@@ -22,7 +22,9 @@
 #include "log.h"
 #include "gamedef.h"
 #include "client/tile.h"
+#include "client/shader_binary_cache.h"
 #include "config.h"
+#include "porting.h"
 
 #include <mt_opengl.h>
 
@@ -414,6 +416,9 @@ class ShaderSource : public IWritableShaderSource
 	// Global uniform setter factories
 	std::vector<std::unique_ptr<IShaderUniformSetterFactory>> m_uniform_factories;
 
+	// Compiled programs on disk, if enabled
+	std::unique_ptr<ShaderBinaryCache> m_binary_cache;
+
 	// Generate shader given the shader name.
 	ShaderInfo generateShader(const std::string &name,
 		const ShaderConstants &input_const, video::E_MATERIAL_TYPE base_mat);
@@ -443,6 +448,20 @@ ShaderSource::ShaderSource()
 	// Add global stuff
 	addShaderConstantSetter(new MainShaderConstantSetter());
 	addShaderUniformSetterFactory(new MainShaderUniformSetterFactory());
+
+	video::IVideoDriver *driver = RenderingEngine::get_video_driver();
+	if (g_settings->getBool("shader_binary_cache") &&
+			driver->getDriverType() != video::EDT_NULL) {
+		// Binaries are only valid for the driver that made them
+		std::string driver_id;
+		for (auto name : {GL.VENDOR, GL.RENDERER, GL.VERSION}) {
+			const char *str = reinterpret_cast<const char*>(GL.GetString(name));
+			driver_id.append(str ? str : "").push_back('\n');
+		}
+		m_binary_cache = std::make_unique<ShaderBinaryCache>(
+				porting::path_cache + DIR_DELIM + "shaders", driver_id);
+		driver->getGPUProgrammingServices()->setShaderBinaryCache(m_binary_cache.get());
+	}
 }
 
 ShaderSource::~ShaderSource()
@@ -452,6 +471,8 @@ ShaderSource::~ShaderSource()
 	// Delete materials
 	auto *gpu = RenderingEngine::get_video_driver()->getGPUProgrammingServices();
 	assert(gpu);
+	if (m_binary_cache)
+		gpu->setShaderBinaryCache(nullptr);
 	u32 n = 0;
 	for (ShaderInfo &i : m_shaderinfo_cache) {
 		if (!i.name.empty()) {
@@ -0,0 +1,85 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "shader_binary_cache.h"
+
+#include <sstream>
+#include "exceptions.h"
+#include "filesys.h"
+#include "log.h"
+#include "util/hashing.h"
+#include "util/hex.h"
+#include "util/serialize.h"
+
+// "LSBC", followed by the version
+static constexpr u32 CACHE_MAGIC = 0x4C534243;
+static constexpr u8 CACHE_VERSION = 1;
+
+ShaderBinaryCache::ShaderBinaryCache(const std::string &dir,
+		const std::string &driver_id) :
+	m_dir(dir),
+	m_driver_id(driver_id)
+{
+	if (!fs::CreateAllDirs(m_dir)) {
+		errorstream << "Could not create cache directory: "
+			<< m_dir << std::endl;
+	}
+}
+
+std::string ShaderBinaryCache::getPath(const std::string &source) const
+{
+	std::string key = m_driver_id;
+	key.push_back('\0');
+	key.append(source);
+	return m_dir + DIR_DELIM + hex_encode(hashing::sha1(key));
+}
+
+bool ShaderBinaryCache::loadProgram(const std::string &source, u32 &format,
+		std::string &binary)
+{
+	auto is = open_ifstream(getPath(source).c_str(), false);
+	if (!is.good())
+		return false;
+
+	try {
+		if (readU32(is) != CACHE_MAGIC || readU8(is) != CACHE_VERSION)
+			return false;
+		// The file name is a hash, so check what it was made from
+		if (deSerializeString16(is) != m_driver_id)
+			return false;
+		char source_hash[20];
+		is.read(source_hash, sizeof(source_hash));
+		if (is.gcount() != sizeof(source_hash) ||
+				std::string(source_hash, sizeof(source_hash)) != hashing::sha1(source))
+			return false;
+
+		format = readU32(is);
+		binary = deSerializeString32(is);
+	} catch (SerializationError &e) {
+		return false;
+	}
+
+	if (!is.good() || binary.empty()) {
+		binary.clear();
+		return false;
+	}
+	return true;
+}
+
+void ShaderBinaryCache::storeProgram(const std::string &source, u32 format,
+		const std::string &binary)
+{
+	if (binary.empty() || m_driver_id.size() > U16_MAX)
+		return;
+
+	std::ostringstream os(std::ios::binary);
+	writeU32(os, CACHE_MAGIC);
+	writeU8(os, CACHE_VERSION);
+	os << serializeString16(m_driver_id);
+	os << hashing::sha1(source);
+	writeU32(os, format);
+	os << serializeString32(binary);
+
+	if (!fs::safeWriteToFile(getPath(source), os.str()))
+		warningstream << "ShaderBinaryCache: failed to store a program" << std::endl;
+}
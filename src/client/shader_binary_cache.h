@@ -0,0 +1,36 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <string>
+#include <IShaderBinaryCache.h>
+#include "irrlichttypes.h"
+
+/*
+	Keeps linked shader programs on disk, so that they don't have to be
+	compiled again on the next start.
+
+	Entries are stored under the hash of the driver identity and the full
+	preprocessed shader source. The driver identity should change whenever
+	the driver does (vendor, renderer and version string), as binaries are
+	only valid for the driver that made them. Entries that don't match are
+	ignored, and a binary that the driver rejects is simply compiled again.
+*/
+class ShaderBinaryCache : public video::IShaderBinaryCache
+{
+public:
+	ShaderBinaryCache(const std::string &dir, const std::string &driver_id);
+
+	bool loadProgram(const std::string &source, u32 &format,
+			std::string &binary) override;
+
+	void storeProgram(const std::string &source, u32 format,
+			const std::string &binary) override;
+
+private:
+	std::string getPath(const std::string &source) const;
+
+	std::string m_dir;
+	std::string m_driver_id;
+};
@@ -4,6 +4,8 @@
 
 #include <cstring>
 #include <cmath>
+#include <iomanip>
+#include <sstream>
 #include "client/shadows/dynamicshadowsrender.h"
 #include "client/shadows/shadowsScreenQuad.h"
 #include "client/shadows/shadowsshadercallbacks.h"
@@ -13,6 +15,7 @@
 #include "client/shader.h"
 #include "client/client.h"
 #include "client/clientmap.h"
+#include "client/meshgen/compact_vertex.h"
 #include "profiler.h"
 #include "IGPUProgrammingServices.h"
 #include "IMaterialRenderer.h"
@@ -539,7 +542,7 @@ void ShadowRenderer::createShaders()
 		m_shadow_depth_cb = new ShadowDepthShaderCB();
 
 		depth_shader = gpu->addHighLevelShaderMaterial(
-				readShaderFile(depth_shader_vs).c_str(),
+				readShaderFile(depth_shader_vs, true).c_str(),
 				readShaderFile(depth_shader_fs).c_str(), nullptr,
 				m_shadow_depth_cb, video::EMT_ONETEXTURE_BLEND);
 
@@ -652,7 +655,7 @@ void ShadowRenderer::createShaders()
 		m_shadow_depth_trans_cb = new ShadowDepthShaderCB();
 
 		depth_shader_trans = gpu->addHighLevelShaderMaterial(
-				readShaderFile(depth_shader_vs).c_str(),
+				readShaderFile(depth_shader_vs, true).c_str(),
 				readShaderFile(depth_shader_fs).c_str(), nullptr,
 				m_shadow_depth_trans_cb);
 
@@ -673,11 +676,22 @@ void ShadowRenderer::createShaders()
 	}
 }
 
-std::string ShadowRenderer::readShaderFile(const std::string &path)
+std::string ShadowRenderer::readShaderFile(const std::string &path, bool map_mesh)
 {
 	std::string prefix;
 	if (m_shadow_map_colored)
 		prefix.append("#define COLORED_SHADOWS 1\n");
+	const CompactVertexFormat *compact_format = m_client->getCompactVertexFormat();
+	if (map_mesh && compact_format) {
+		// Same constants as the node shaders get, see NodeShaderConstantSetter
+		std::ostringstream os;
+		os << std::fixed << std::setprecision(8);
+		os << "#define COMPACT_VERTEX 1\n";
+		os << "#define COMPACT_POS_STEP " << compact_format->getPosStep() << "\n";
+		os << "#define COMPACT_POS_ORIGIN " << compact_format->getPosOrigin() << "\n";
+		os << "#define COMPACT_TCOORD_STEP " << compact_format->getTCoordStep() << "\n";
+		prefix.append(os.str());
+	}
 	prefix.append("#line 0\n");
 
 	std::string content;
@@ -143,7 +143,8 @@ class ShadowRenderer
 	// Shadow Shader stuff
 
 	void createShaders();
-	std::string readShaderFile(const std::string &path);
+	// `map_mesh` adds the constants needed to draw map block meshes
+	std::string readShaderFile(const std::string &path, bool map_mesh = false);
 
 	s32 depth_shader{-1};
 	s32 depth_shader_entities{-1};
@@ -0,0 +1,259 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "texturediskcache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <IImage.h>
+#include <IVideoDriver.h>
+#include "exceptions.h"
+#include "filesys.h"
+#include "imagesource.h"
+#include "log.h"
+#include "renderingengine.h"
+#include "threading/mutex_auto_lock.h"
+#include "util/hashing.h"
+#include "util/hex.h"
+#include "util/serialize.h"
+#include "util/thread.h"
+
+// "LTIC", followed by the version. Bump the version when the file layout or
+// the output of any texture modifier changes.
+static constexpr u32 CACHE_MAGIC = 0x4C544943;
+static constexpr u8 CACHE_VERSION = 1;
+
+// Entries that are not written yet are dropped beyond this, rather than
+// holding on to more memory
+static constexpr size_t MAX_PENDING_SIZE = 64 * 1024 * 1024;
+
+class TextureDiskCache::Writer : public UpdateThread
+{
+public:
+	Writer(TextureDiskCache *cache) : UpdateThread("TextureCache"), m_cache(cache) {}
+
+protected:
+	void doUpdate() override { m_cache->writePending(); }
+
+private:
+	TextureDiskCache *m_cache;
+};
+
+TextureDiskCache::TextureDiskCache(const std::string &dir,
+		const std::string &settings_key, u64 max_size) :
+	m_dir(dir),
+	m_settings_key(settings_key),
+	m_max_size(max_size)
+{
+	if (!fs::CreateAllDirs(m_dir)) {
+		errorstream << "Could not create cache directory: "
+			<< m_dir << std::endl;
+	}
+
+	m_writer = std::make_unique<Writer>(this);
+	m_writer->start();
+	// Check the size of what is left from earlier sessions
+	m_writer->deferUpdate();
+}
+
+TextureDiskCache::~TextureDiskCache()
+{
+	m_writer->stop();
+	m_writer->wait();
+	writePending();
+}
+
+bool TextureDiskCache::isCacheable(std::string_view name)
+{
+	// Plain source images are loaded along with the media anyway
+	return !name.empty() && (name[0] == '[' ||
+			name.find('^') != std::string_view::npos);
+}
+
+void TextureDiskCache::setSourceHash(const std::string &name,
+		const std::string &raw_hash)
+{
+	if (raw_hash.empty())
+		m_source_hashes.erase(name);
+	else
+		m_source_hashes[name] = raw_hash;
+}
+
+std::string TextureDiskCache::getPath(const std::string &name) const
+{
+	return m_dir + DIR_DELIM + hex_encode(hashing::sha1(name));
+}
+
+video::IImage *TextureDiskCache::load(const std::string &name,
+		std::set<std::string> &source_image_names)
+{
+	const std::string path = getPath(name);
+	auto is = open_ifstream(path.c_str(), false);
+	if (!is.good())
+		return nullptr;
+
+	std::set<std::string> sources;
+	u32 width, height;
+	try {
+		if (readU32(is) != CACHE_MAGIC || readU8(is) != CACHE_VERSION)
+			return nullptr;
+		if (deSerializeString16(is) != m_settings_key ||
+				deSerializeString32(is) != name)
+			return nullptr;
+
+		u16 count = readU16(is);
+		for (u16 i = 0; i < count; i++) {
+			std::string source = deSerializeString16(is);
+			auto it = m_source_hashes.find(source);
+			if (it == m_source_hashes.end() || deSerializeString16(is) != it->second)
+				return nullptr;
+			sources.insert(std::move(source));
+		}
+
+		width = readU32(is);
+		height = readU32(is);
+	} catch (SerializationError &e) {
+		return nullptr;
+	}
+
+	if (!is.good() || width == 0 || height == 0 ||
+			width > ImageSource::MAX_IMAGE_DIMENSION ||
+			height > ImageSource::MAX_IMAGE_DIMENSION)
+		return nullptr;
+
+	video::IVideoDriver *driver = RenderingEngine::get_video_driver();
+	video::IImage *img = driver->createImage(video::ECF_A8R8G8B8, {width, height});
+	std::streamsize size = img->getImageDataSizeInBytes();
+	is.read(reinterpret_cast<char *>(img->getData()), size);
+	if (is.gcount() != size) {
+		warningstream << "TextureDiskCache: truncated entry for \""
+			<< name << "\"" << std::endl;
+		img->drop();
+		return nullptr;
+	}
+
+	source_image_names.insert(sources.begin(), sources.end());
+
+	{
+		MutexAutoLock lock(m_mutex);
+		m_used.push_back(path);
+	}
+	m_writer->deferUpdate();
+	return img;
+}
+
+void TextureDiskCache::store(const std::string &name, video::IImage *img,
+		const std::set<std::string> &source_image_names)
+{
+	if (img->getColorFormat() != video::ECF_A8R8G8B8 ||
+			source_image_names.size() > U16_MAX)
+		return;
+
+	std::ostringstream os(std::ios::binary);
+	writeU32(os, CACHE_MAGIC);
+	writeU8(os, CACHE_VERSION);
+	os << serializeString16(m_settings_key);
+	os << serializeString32(name);
+
+	writeU16(os, source_image_names.size());
+	for (const std::string &source : source_image_names) {
+		auto it = m_source_hashes.find(source);
+		if (it == m_source_hashes.end())
+			return;
+		os << serializeString16(source);
+		os << serializeString16(it->second);
+	}
+
+	// Pixels are written in memory order, the cache is not meant to be
+	// moved between machines
+	core::dimension2d<u32> dim = img->getDimension();
+	writeU32(os, dim.Width);
+	writeU32(os, dim.Height);
+	os.write(reinterpret_cast<const char *>(img->getData()),
+			img->getImageDataSizeInBytes());
+
+	std::string data = os.str();
+	{
+		MutexAutoLock lock(m_mutex);
+		if (m_pending_size + data.size() > MAX_PENDING_SIZE)
+			return;
+		m_pending_size += data.size();
+		m_pending.push_back({getPath(name), std::move(data)});
+	}
+	m_writer->deferUpdate();
+}
+
+void TextureDiskCache::writePending()
+{
+	std::vector<PendingWrite> pending;
+	std::vector<std::string> used;
+	{
+		MutexAutoLock lock(m_mutex);
+		pending.swap(m_pending);
+		used.swap(m_used);
+		m_pending_size = 0;
+	}
+
+	for (const PendingWrite &it : pending) {
+		if (!fs::safeWriteToFile(it.path, it.data)) {
+			warningstream << "TextureDiskCache: failed to write \""
+				<< it.path << "\"" << std::endl;
+			continue;
+		}
+		// Replaced entries are counted twice until the next trim
+		m_size += it.data.size();
+	}
+
+	// The modification time tells trim() when an entry was last used
+	for (const std::string &path : used) {
+		std::error_code ec;
+		std::filesystem::last_write_time(path,
+				std::filesystem::file_time_type::clock::now(), ec);
+	}
+
+	if (!m_size_known || m_size > m_max_size)
+		trim();
+}
+
+void TextureDiskCache::trim()
+{
+	struct Entry
+	{
+		std::string path;
+		uint64_t size, mtime;
+	};
+	std::vector<Entry> entries;
+	u64 total = 0;
+	for (const fs::DirListNode &node : fs::GetDirListing(m_dir)) {
+		if (node.dir)
+			continue;
+		Entry entry;
+		entry.path = m_dir + DIR_DELIM + node.name;
+		if (!fs::GetFileInfo(entry.path, entry.size, entry.mtime))
+			continue;
+		total += entry.size;
+		entries.push_back(std::move(entry));
+	}
+	m_size = total;
+	m_size_known = true;
+	if (total <= m_max_size)
+		return;
+
+	// Make some room, so this does not run again after every write
+	const u64 target = m_max_size / 4 * 3;
+	std::sort(entries.begin(), entries.end(), [] (const Entry &a, const Entry &b) {
+		return a.mtime < b.mtime;
+	});
+	size_t removed = 0;
+	for (const Entry &entry : entries) {
+		if (m_size <= target)
+			break;
+		if (!fs::DeleteSingleFileOrEmptyDirectory(entry.path))
+			continue;
+		m_size -= entry.size;
+		removed++;
+	}
+	infostream << "TextureDiskCache: removed " << removed
+			<< " least recently used entries" << std::endl;
+}
@@ -0,0 +1,102 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "irrlichttypes.h"
+#include "util/basic_macros.h"
+
+namespace irr::video
+{
+	class IImage;
+}
+
+/*
+	Keeps generated texture images on disk, so that joining the same server
+	again does not need to compose them from the source images again.
+
+	An entry is stored under the hash of its texture string and records the
+	source images it was made from, along with their media SHA1. It is only
+	used while all of these hashes still match, so changed media is picked
+	up by itself. Images that use a source image without a known hash (e.g.
+	one from a texture pack) are not cached.
+
+	The pixels are stored uncompressed, so loading an entry is a single read
+	into the image buffer. Entries are written by a thread of their own.
+	Once the directory grows beyond its size limit, the entries that were
+	used least recently are deleted.
+*/
+class TextureDiskCache
+{
+public:
+	/*
+		`dir` is the cache directory to use. `settings_key` describes the
+		settings that affect image generation; entries made with other
+		settings are ignored. `max_size` is the size limit in bytes.
+	*/
+	TextureDiskCache(const std::string &dir, const std::string &settings_key,
+			u64 max_size);
+	// Writes what is still queued
+	~TextureDiskCache();
+
+	DISABLE_CLASS_COPY(TextureDiskCache);
+
+	// Whether it is worth caching the image for a texture string at all
+	static bool isCacheable(std::string_view name);
+
+	// Sets the raw SHA1 of a source image, or forgets it if empty.
+	// Must not be called while other threads use the cache.
+	void setSourceHash(const std::string &name, const std::string &raw_hash);
+
+	// Returns nullptr if there is no valid entry. The returned image
+	// should be dropped. Can be called from any thread.
+	video::IImage *load(const std::string &name,
+			std::set<std::string> &source_image_names);
+
+	// Queues the image to be written. Does nothing if the image can't be
+	// cached. Can be called from any thread.
+	void store(const std::string &name, video::IImage *img,
+			const std::set<std::string> &source_image_names);
+
+private:
+	class Writer;
+
+	struct PendingWrite
+	{
+		std::string path;
+		std::string data;
+	};
+
+	std::string getPath(const std::string &name) const;
+
+	// Writes the queued entries, runs on the writer thread
+	void writePending();
+	// Deletes the least recently used entries if the cache is too large
+	void trim();
+
+	std::string m_dir;
+	std::string m_settings_key;
+	// Raw SHA1 of source images by name
+	std::unordered_map<std::string, std::string> m_source_hashes;
+
+	std::unique_ptr<Writer> m_writer;
+
+	std::mutex m_mutex;
+	std::vector<PendingWrite> m_pending;
+	// Total size of the data in m_pending
+	size_t m_pending_size = 0;
+	// Paths of entries that were loaded since the last write
+	std::vector<std::string> m_used;
+
+	// Only accessed by the writer thread
+	u64 m_max_size;
+	// Size of the cache directory as far as known
+	u64 m_size = 0;
+	bool m_size_known = false;
+};
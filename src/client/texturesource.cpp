@@ -4,13 +4,20 @@
 
 #include "texturesource.h"
 
+#include <memory>
+#include <unordered_set>
 #include <IVideoDriver.h>
+#include "filesys.h"
 #include "guiscalingfilter.h"
 #include "imagefilters.h"
 #include "imagesource.h"
+#include "porting.h"
 #include "renderingengine.h"
 #include "settings.h"
+#include "texturediskcache.h"
 #include "texturepaths.h"
+#include "threading/thread.h"
+#include "threading/thread_pool.h"
 #include "util/thread.h"
 
 
@@ -122,7 +129,8 @@ class TextureSource final : public IWritableTextureSource
 
 	// Insert a source image into the cache without touching the filesystem.
 	// Shall be called from the main thread.
-	void insertSourceImage(const std::string &name, video::IImage *img);
+	void insertSourceImage(const std::string &name, video::IImage *img,
+			const std::string &raw_hash);
 
 	// Rebuild images and textures from the current set of source images
 	// Shall be called from the main thread.
@@ -132,7 +140,19 @@ class TextureSource final : public IWritableTextureSource
 
 	void setImageCaching(bool enabled);
 
+	void prefetchImages(const std::vector<std::string> &names, bool for_mesh);
+
 private:
+	// Name of the texture that getTextureForMesh uses for `name`
+	std::string getMeshTextureName(const std::string &name) const;
+
+	// Generates an image, or loads it from the disk cache while image
+	// caching is enabled.
+	// Can be called from any thread while no source images are inserted.
+	// Caller needs to drop the returned image
+	video::IImage *generateImage(const std::string &name,
+		std::set<std::string> &source_image_names);
+
 	// Gets or generates an image for a texture string
 	// Caller needs to drop the returned image
 	video::IImage *getOrGenerateImage(const std::string &name,
@@ -151,6 +171,9 @@ class TextureSource final : public IWritableTextureSource
 	// (main thread use only)
 	std::unordered_map<std::string, ImageInfo> m_image_cache;
 
+	// Keeps generated images across sessions (null if disabled)
+	std::unique_ptr<TextureDiskCache> m_disk_cache;
+
 	// Rebuild images and textures from the current set of source images
 	// Shall be called from the main thread.
 	// You ARE expected to be holding m_textureinfo_cache_mutex
@@ -205,6 +228,13 @@ TextureSource::TextureSource()
 			g_settings->getBool("trilinear_filter") ||
 			g_settings->getBool("bilinear_filter") ||
 			g_settings->getBool("anisotropic_filter");
+
+	if (g_settings->getBool("texture_disk_cache")) {
+		m_disk_cache = std::make_unique<TextureDiskCache>(
+				porting::path_cache + DIR_DELIM + "textures",
+				ImageSource::getSettingsKey(),
+				(u64)g_settings->getU32("texture_disk_cache_size") * 1024 * 1024);
+	}
 }
 
 TextureSource::~TextureSource()
@@ -242,7 +272,7 @@ video::IImage *TextureSource::getOrGenerateImage(const std::string &name,
 	}
 
 	std::set<std::string> tmp;
-	auto *img = m_imagesource.generateImage(name, tmp);
+	auto *img = generateImage(name, tmp);
 	if (img && m_image_cache_enabled) {
 		img->grab();
 		m_image_cache[name] = {img, tmp};
@@ -251,6 +281,24 @@ video::IImage *TextureSource::getOrGenerateImage(const std::string &name,
 	return img;
 }
 
+video::IImage *TextureSource::generateImage(const std::string &name,
+		std::set<std::string> &source_image_names)
+{
+	// Only images generated while loading the media are worth keeping,
+	// not the ones made at runtime (e.g. for HUD elements or entities)
+	bool cacheable = m_disk_cache && m_image_cache_enabled &&
+			TextureDiskCache::isCacheable(name);
+	if (cacheable) {
+		if (auto *img = m_disk_cache->load(name, source_image_names))
+			return img;
+	}
+
+	auto *img = m_imagesource.generateImage(name, source_image_names);
+	if (img && cacheable)
+		m_disk_cache->store(name, img, source_image_names);
+	return img;
+}
+
 u32 TextureSource::getTextureId(const std::string &name)
 {
 	{ // See if texture already exists
@@ -378,12 +426,17 @@ video::ITexture* TextureSource::getTexture(const std::string &name, u32 *id)
 	return getTexture(actual_id);
 }
 
-video::ITexture* TextureSource::getTextureForMesh(const std::string &name, u32 *id)
+std::string TextureSource::getMeshTextureName(const std::string &name) const
 {
 	// Avoid duplicating texture if it won't actually change
 	if (mesh_filter_needed && !name.empty())
-		return getTexture(name + "^[applyfiltersformesh", id);
-	return getTexture(name, id);
+		return name + "^[applyfiltersformesh";
+	return name;
+}
+
+video::ITexture* TextureSource::getTextureForMesh(const std::string &name, u32 *id)
+{
+	return getTexture(getMeshTextureName(name), id);
 }
 
 Palette* TextureSource::getPalette(const std::string &name)
@@ -454,12 +507,17 @@ void TextureSource::processQueue()
 	}
 }
 
-void TextureSource::insertSourceImage(const std::string &name, video::IImage *img)
+void TextureSource::insertSourceImage(const std::string &name, video::IImage *img,
+		const std::string &raw_hash)
 {
 	sanity_check(std::this_thread::get_id() == m_main_thread);
 
-	m_imagesource.insertSourceImage(name, img, true);
+	bool inserted = m_imagesource.insertSourceImage(name, img, true);
 	m_source_image_existence.set(name, true);
+	if (m_disk_cache) {
+		// A local replacement has no known hash
+		m_disk_cache->setSourceHash(name, inserted ? raw_hash : "");
+	}
 
 	// now we need to check for any textures that need updating
 	MutexAutoLock lock(m_textureinfo_cache_mutex);
@@ -570,6 +628,7 @@ video::SColor TextureSource::getTextureAverageColor(const std::string &name)
 void TextureSource::setImageCaching(bool enabled)
 {
 	m_image_cache_enabled = enabled;
+	m_imagesource.setIntermediateCaching(enabled);
 	if (!enabled) {
 		for (const auto &it : m_image_cache) {
 			assert(it.second.image);
@@ -578,3 +637,50 @@ void TextureSource::setImageCaching(bool enabled)
 		m_image_cache.clear();
 	}
 }
+
+void TextureSource::prefetchImages(const std::vector<std::string> &names,
+		bool for_mesh)
+{
+	sanity_check(std::this_thread::get_id() == m_main_thread);
+
+	if (!m_image_cache_enabled)
+		return;
+
+	// Skip duplicates and whatever was generated already
+	std::vector<std::string> todo;
+	{
+		std::unordered_set<std::string> seen;
+		MutexAutoLock lock(m_textureinfo_cache_mutex);
+		for (const std::string &it : names) {
+			std::string name = for_mesh ? getMeshTextureName(it) : it;
+			if (name.empty() || m_name_to_id.count(name) ||
+					m_image_cache.count(name) || !seen.insert(name).second)
+				continue;
+			todo.push_back(std::move(name));
+		}
+	}
+	if (todo.empty())
+		return;
+
+	// The calling thread does its share of the work
+	unsigned int threads = MYMIN(8, Thread::getNumberOfProcessors());
+	ThreadPool pool(threads > 0 ? threads - 1 : 0, "ImageGen");
+
+	std::vector<ImageInfo> images(todo.size());
+	pool.run(todo.size(), [&] (size_t i) {
+		try {
+			images[i].image = generateImage(todo[i], images[i].sourceImages);
+		} catch (std::exception &e) {
+			// Leave it to the main thread, which will report the error
+			images[i].image = nullptr;
+		}
+	});
+
+	for (size_t i = 0; i < todo.size(); i++) {
+		if (images[i].image)
+			m_image_cache[todo[i]] = std::move(images[i]);
+	}
+
+	verbosestream << "TextureSource: generated " << todo.size()
+			<< " images on " << pool.getConcurrency() << " threads" << std::endl;
+}
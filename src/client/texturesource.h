@@ -80,6 +80,16 @@ class ITextureSource : public ISimpleTextureSource
 	 * @note Disabling caching will flush the cache.
 	 */
 	virtual void setImageCaching(bool enabled) {};
+
+	/**
+	 * Generates the images of the given texture strings in parallel and
+	 * keeps them in the image cache, so that getting the textures later
+	 * only needs to upload them. Does nothing unless caching is enabled.
+	 * Must be called from the main thread.
+	 * @param for_mesh Prepare the images for getTextureForMesh
+	 */
+	virtual void prefetchImages(const std::vector<std::string> &names,
+			bool for_mesh) {};
 };
 
 class IWritableTextureSource : public ITextureSource
@@ -94,8 +104,11 @@ class IWritableTextureSource : public ITextureSource
 	/**
 	 * @brief Inserts a source image. Must be called from the main thread.
 	 * Takes ownership of @p img
+	 * @param raw_hash SHA1 of the media file, if known. Textures made from
+	 * it can then be kept in the on-disk cache.
 	 */
-	virtual void insertSourceImage(const std::string &name, video::IImage *img)=0;
+	virtual void insertSourceImage(const std::string &name, video::IImage *img,
+			const std::string &raw_hash = "")=0;
 
 	/**
 	 * Rebuilds all textures (in case-source images have changed)
@@ -143,6 +143,17 @@ bool IsFile(const std::string &path)
 			!(attr & FILE_ATTRIBUTE_DIRECTORY));
 }
 
+bool GetFileInfo(const std::string &path, uint64_t &size, uint64_t &mtime)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &data))
+		return false;
+	size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	mtime = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) |
+			data.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
 bool IsExecutable(const std::string &path)
 {
 	DWORD type;
@@ -358,6 +369,21 @@ bool IsFile(const std::string &path)
 	return ((statbuf.st_mode & S_IFDIR) != S_IFDIR);
 }
 
+bool GetFileInfo(const std::string &path, uint64_t &size, uint64_t &mtime)
+{
+	struct stat statbuf{};
+	if (stat(path.c_str(), &statbuf))
+		return false;
+	size = statbuf.st_size;
+	// In nanoseconds, so that rewriting a file within a second is noticed
+#ifdef __APPLE__
+	mtime = (uint64_t)statbuf.st_mtimespec.tv_sec * 1000000000 + statbuf.st_mtimespec.tv_nsec;
+#else
+	mtime = (uint64_t)statbuf.st_mtim.tv_sec * 1000000000 + statbuf.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
 bool IsExecutable(const std::string &path)
 {
 	return access(path.c_str(), X_OK) == 0;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "config.h"
+#include <cstdint>
 #include <set>
 #include <string>
 #include <string_view>
@@ -52,6 +53,10 @@ bool CreateDir(const std::string &path);
 
 [[nodiscard]] bool IsFile(const std::string &path);
 
+// Gets the size and the last modification time (in a platform specific
+// unit) of a file. Returns false if it can't be accessed.
+[[nodiscard]] bool GetFileInfo(const std::string &path, uint64_t &size, uint64_t &mtime);
+
 [[nodiscard]] inline bool IsDirDelimiter(char c)
 {
 	return c == '/' || c == DIR_DELIM_CHAR;
@@ -40,9 +40,10 @@ extern const u8 *light_decode_table;
 
 // 0 <= light <= LIGHT_SUN
 // 0 <= return value <= 255
-inline u8 decode_light(u8 light)
+// With `fullbright`, every light level decodes as sunlight.
+inline u8 decode_light(u8 light, bool fullbright)
 {
-	if (g_settings->getBool("fullbright"))
+	if (fullbright)
 		light = 255;
 	// assert(light <= LIGHT_SUN);
 	if (light > LIGHT_SUN)
@@ -50,6 +51,12 @@ inline u8 decode_light(u8 light)
 	return light_decode_table[light];
 }
 
+// Same as above, but reads the fullbright setting
+inline u8 decode_light(u8 light)
+{
+	return decode_light(light, g_settings->getBool("fullbright"));
+}
+
 // 0.0 <= light <= 1.0
 // 0.0 <= return value <= 1.0
 float decode_light_f(float light_f);
@@ -298,7 +298,8 @@ class Map /*: public NodeContainer*/
 
 	bool determineAdditionalOcclusionCheck(v3s16 pos_camera,
 		const core::aabbox3d<s16> &block_bounds, v3s16 &to_check);
-	bool isOccluded(v3s16 pos_camera, v3s16 pos_target,
+	// Can be replaced by child class with a faster node lookup
+	virtual bool isOccluded(v3s16 pos_camera, v3s16 pos_target,
 		float step, float stepfac, float start_offset, float end_offset,
 		u32 needed_count);
 };
@@ -4,6 +4,7 @@
 
 #include "mapblock.h"
 
+#include <algorithm>
 #include <sstream>
 #include "map.h"
 #include "light.h"
@@ -23,6 +24,7 @@
 #include "util/string.h"
 #include "util/serialize.h"
 #include "util/basic_macros.h"
+#include "util/stream.h"
 
 // Like a std::unordered_map<content_t, content_t>, but faster.
 //
@@ -225,8 +227,24 @@ void MapBlock::copyFrom(const VoxelManipulator &src)
 	// Copy from VoxelManipulator to data
 	src.copyTo(data, data_area, v3s16(0,0,0),
 			getPosRelative(), data_size);
+	invalidateNodeSnapshot();
 }
 
+#if CHECK_CLIENT_BUILD()
+std::shared_ptr<const MapNode[]> MapBlock::getNodeSnapshot()
+{
+	if (auto snapshot = m_node_snapshot.lock())
+		return snapshot;
+
+	// Not std::make_shared, so the nodes are freed with the last owner
+	// and not only when the block goes away
+	std::shared_ptr<MapNode[]> copy(new MapNode[nodecount]);
+	memcpy(copy.get(), data, nodecount * sizeof(MapNode));
+	m_node_snapshot = copy;
+	return copy;
+}
+#endif
+
 void MapBlock::actuallyUpdateIsAir()
 {
 	// Running this function un-expires m_is_air
@@ -347,9 +365,26 @@ void MapBlock::serialize(std::ostream &os_compressed, u8 version, bool disk, int
 	if (!ser_ver_supported_write(version))
 		throw VersionMismatchException("ERROR: MapBlock format not supported");
 
-	std::ostringstream os_raw(std::ios_base::binary);
-	std::ostream &os = version >= 29 ? os_raw : os_compressed;
+	if (version >= 29) {
+		std::ostringstream os_raw(std::ios_base::binary);
+		serializeData(os_raw, version, disk, compression_level);
+		// now compress the whole thing
+		compress(os_raw.str(), os_compressed, version, compression_level);
+	} else {
+		serializeData(os_compressed, version, disk, compression_level);
+	}
+}
 
+void MapBlock::serializeUncompressed(std::ostream &os, u8 version, bool disk)
+{
+	if (!ser_ver_supported_write(version) || version < 29)
+		throw VersionMismatchException("ERROR: MapBlock format not supported");
+
+	serializeData(os, version, disk, -1);
+}
+
+void MapBlock::serializeData(std::ostream &os, u8 version, bool disk, int compression_level)
+{
 	// First byte
 	u8 flags = 0;
 	if(is_underground)
@@ -413,7 +448,7 @@ void MapBlock::serialize(std::ostream &os_compressed, u8 version, bool disk, int
 	if (version >= 29) {
 		m_node_metadata.serialize(os, version, disk);
 	} else {
-		// use os_raw from above to avoid allocating another stream object
+		std::ostringstream os_raw(std::ios_base::binary);
 		m_node_metadata.serialize(os_raw, version, disk);
 		// prior to 29 node data was compressed individually
 		compress(os_raw.str(), os, version, compression_level);
@@ -444,11 +479,6 @@ void MapBlock::serialize(std::ostream &os_compressed, u8 version, bool disk, int
 			m_node_timers.serialize(os, version);
 		}
 	}
-
-	if (version >= 29) {
-		// now compress the whole thing
-		compress(os_raw.str(), os_compressed, version, compression_level);
-	}
 }
 
 void MapBlock::serializeNetworkSpecific(std::ostream &os)
@@ -463,6 +493,8 @@ void MapBlock::deSerialize(std::istream &in_compressed, u8 version, bool disk)
 
 	TRACESTREAM(<<"MapBlock::deSerialize "<<getPos()<<std::endl);
 
+	invalidateNodeSnapshot();
+
 	m_is_air_expired = true;
 
 	if(version <= 21)
@@ -471,11 +503,47 @@ void MapBlock::deSerialize(std::istream &in_compressed, u8 version, bool disk)
 		return;
 	}
 
-	// Decompress the whole block (version >= 29)
-	std::stringstream in_raw(std::ios_base::binary | std::ios_base::in | std::ios_base::out);
-	if (version >= 29)
+	if (version >= 29) {
+		// Decompress the whole block
+		std::stringstream in_raw(std::ios_base::binary | std::ios_base::in | std::ios_base::out);
 		decompress(in_compressed, in_raw, version);
-	std::istream &is = version >= 29 ? in_raw : in_compressed;
+		deSerializeData(in_raw, version, disk);
+	} else {
+		deSerializeData(in_compressed, version, disk);
+	}
+}
+
+size_t MapBlock::deSerialize(std::string_view data, u8 version, bool disk)
+{
+	if (version < 29) {
+		StringViewStream is(data);
+		deSerialize(is, version, disk);
+		return data.size() - is.remaining().size();
+	}
+
+	if (!ser_ver_supported_read(version))
+		throw VersionMismatchException("ERROR: MapBlock format not supported");
+
+	TRACESTREAM(<<"MapBlock::deSerialize "<<getPos()<<std::endl);
+
+	invalidateNodeSnapshot();
+
+	m_is_air_expired = true;
+
+	// Decompress the whole block straight from the given memory
+	std::string raw;
+	raw.reserve(nodecount * MapNode::serializedLength(version));
+	size_t consumed = decompressZstd(data, raw);
+
+	StringViewStream is(raw);
+	deSerializeData(is, version, disk);
+	return consumed;
+}
+
+void MapBlock::deSerializeData(std::istream &is, u8 version, bool disk)
+{
+	// Only needed by old versions that compress parts of the block separately
+	std::stringstream in_raw(std::ios_base::binary | std::ios_base::in | std::ios_base::out);
 
 	u8 flags = readU8(is);
 	is_underground = (flags & 0x01) != 0;
@@ -615,6 +683,20 @@ void MapBlock::deSerializeNetworkSpecific(std::istream &is)
 	}
 }
 
+void MapBlock::takeDeserializedData(MapBlock &other)
+{
+	invalidateNodeSnapshot();
+
+	std::copy_n(other.data, nodecount, data);
+	m_node_metadata.swap(other.m_node_metadata);
+
+	is_underground = other.is_underground;
+	m_lighting_complete = other.m_lighting_complete;
+	m_generated = other.m_generated;
+	m_is_air = other.m_is_air;
+	m_is_air_expired = other.m_is_air_expired;
+}
+
 bool MapBlock::storeActiveObject(u16 id)
 {
 	if (m_static_objects.storeActiveObject(id)) {
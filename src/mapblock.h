@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <memory>
+#include <string_view>
 #include <vector>
 #include "irr_v3d.h"
 #include "mapnode.h"
@@ -20,6 +22,7 @@ class Map;
 class NodeMetadataList;
 class IGameDef;
 class MapBlockMesh;
+struct BlockOpacity;
 class VoxelManipulator;
 
 #define BLOCK_TIMESTAMP_UNDEFINED 0xffffffff
@@ -77,10 +80,18 @@ class MapBlock
 	{
 		for (u32 i = 0; i < nodecount; i++)
 			data[i] = MapNode(CONTENT_IGNORE);
+		invalidateNodeSnapshot();
 		raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_REALLOCATE);
 	}
 
+	// The returned pointer may be used to modify the nodes
 	MapNode* getData()
+	{
+		invalidateNodeSnapshot();
+		return data;
+	}
+
+	const MapNode* getData() const
 	{
 		return data;
 	}
@@ -256,6 +267,7 @@ class MapBlock
 			throw InvalidPositionException();
 
 		data[z * zstride + y * ystride + x] = n;
+		invalidateNodeSnapshot();
 		raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_SET_NODE);
 	}
 
@@ -281,6 +293,7 @@ class MapBlock
 	inline void setNodeNoCheck(s16 x, s16 y, s16 z, MapNode n)
 	{
 		data[z * zstride + y * ystride + x] = n;
+		invalidateNodeSnapshot();
 		raiseModified(MOD_STATE_WRITE_NEEDED, MOD_REASON_SET_NODE);
 	}
 
@@ -416,13 +429,26 @@ class MapBlock
 	// Set disk to true for on-disk format, false for over-the-network format
 	// Precondition: version >= SER_FMT_VER_LOWEST_WRITE
 	void serialize(std::ostream &result, u8 version, bool disk, int compression_level);
+	// Same as serialize(), but skips compressing the result. Compressing the
+	// output with compress() yields the same data as serialize(), which
+	// allows deferring the expensive part to another thread.
+	// Precondition: version >= 29
+	void serializeUncompressed(std::ostream &result, u8 version, bool disk);
 	// If disk == true: In addition to doing other things, will add
 	// unknown blocks from id-name mapping to wndef
 	void deSerialize(std::istream &is, u8 version, bool disk);
+	// Same as above, reading from memory without copying it first.
+	// Returns the number of bytes that belonged to the block.
+	size_t deSerialize(std::string_view data, u8 version, bool disk);
 
 	void serializeNetworkSpecific(std::ostream &os);
 	void deSerializeNetworkSpecific(std::istream &is);
 
+	// Takes over what deSerialize() read from the network into another
+	// block, e.g. one that was decoded on a different thread.
+	// `other` is left with unspecified node data.
+	void takeDeserializedData(MapBlock &other);
+
 	bool storeActiveObject(u16 id);
 	// clearObject and return removed objects count
 	u32 clearObjects();
@@ -438,6 +464,20 @@ class MapBlock
 	*/
 
 	void deSerialize_pre22(std::istream &is, u8 version, bool disk);
+	// Everything after the version checks, from decompressed data if the
+	// version compresses the whole block
+	void deSerializeData(std::istream &is, u8 version, bool disk);
+
+	void invalidateNodeSnapshot()
+	{
+#if CHECK_CLIENT_BUILD()
+		m_node_snapshot.reset();
+#endif
+	}
+
+	// Writes everything serialize() does, minus the final compression step
+	// of version >= 29
+	void serializeData(std::ostream &os, u8 version, bool disk, int compression_level);
 
 	/*
 	 * PLEASE NOTE: When adding something here be mindful of position and size
@@ -452,6 +492,29 @@ class MapBlock
 
 	// marks the sides which are opaque: 00+Z-Z+Y-Y+X-X
 	u8 solid_sides = 0;
+
+	// sorted content IDs the mesh was built from, see get_mesh_contents()
+	// empty if unknown
+	std::vector<content_t> mesh_contents;
+
+	// light-blocking nodes as of the last mesh update, used for occlusion
+	// culling. null if the block was not meshed yet.
+	std::shared_ptr<const BlockOpacity> opacity;
+
+	/*
+		Returns an immutable copy of the node data that may be read from any
+		thread, e.g. by the mesh workers. The copy is shared by everyone who
+		requests it while it is in use and the nodes are not modified, so the
+		meshes that border this block usually cost one copy in total.
+		The block does not keep the copy alive by itself.
+		Must be called from the thread that modifies the block.
+	*/
+	std::shared_ptr<const MapNode[]> getNodeSnapshot();
+
+private:
+	std::weak_ptr<const MapNode[]> m_node_snapshot;
+
+public:
 #endif
 
 private:
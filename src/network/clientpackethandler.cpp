@@ -10,6 +10,8 @@
 #include "client/camera.h"
 #include "client/content_cao.h"
 #include "client/mesh_generator_thread.h"
+#include "client/block_decoder.h"
+#include "client/local_map_save_thread.h"
 #include "chatmessage.h"
 #include "client/clientmedia.h"
 #include "log.h"
@@ -28,6 +30,7 @@
 #include "network/networkpacket.h"
 #include "script/scripting_client.h"
 #include "util/serialize.h"
+#include "util/stream.h"
 #include "util/srp.h"
 #include "util/hashing.h"
 #include "tileanimation.h"
@@ -253,7 +256,7 @@ void Client::handleCommand_NodemetaChanged(NetworkPacket *pkt)
 	if (pkt->getSize() < 1)
 		return;
 
-	std::istringstream is(pkt->readLongString(), std::ios::binary);
+	StringViewStream is(pkt->readLongStringView());
 	std::stringstream sstr(std::ios::binary | std::ios::in | std::ios::out);
 	decompressZlib(is, sstr);
 
@@ -283,42 +286,14 @@ void Client::handleCommand_BlockData(NetworkPacket* pkt)
 	v3s16 p;
 	*pkt >> p;
 
-	std::string datastring(pkt->getRemainingString(), pkt->getRemainingBytes());
-	std::istringstream istr(datastring, std::ios_base::binary);
+	if (blockpos_over_max_limit(p))
+		throw InvalidPositionException("TOCLIENT_BLOCKDATA: pos over max mapgen limit");
 
-	MapSector *sector;
-	MapBlock *block;
-
-	v2s16 p2d(p.X, p.Z);
-	sector = m_env.getMap().emergeSector(p2d);
-
-	assert(sector->getPos() == p2d);
-
-	block = sector->getBlockNoCreateNoEx(p.Y);
-	if (block) {
-		/*
-			Update an existing block
-		*/
-		block->deSerialize(istr, m_server_ser_ver, false);
-		block->deSerializeNetworkSpecific(istr);
-	}
-	else {
-		/*
-			Create a new block
-		*/
-		block = sector->createBlankBlock(p.Y);
-		block->deSerialize(istr, m_server_ser_ver, false);
-		block->deSerializeNetworkSpecific(istr);
-	}
-
-	if (m_localdb) {
-		ServerMap::saveBlock(block, m_localdb);
-	}
-
-	/*
-		Add it to mesh update queue and set it to be acknowledged after update.
-	*/
-	addUpdateMeshTaskWithEdge(p, true);
+	// Decompressing and parsing happens on the decoder threads, the block
+	// is put into the map by applyDecodedBlocks()
+	// The packet is reused after this, so the payload has to be copied once
+	m_block_decoder->push(p, std::string(pkt->getRemainingStringView()),
+			m_server_ser_ver);
 }
 
 void Client::handleCommand_Inventory(NetworkPacket* pkt)
@@ -326,8 +301,7 @@ void Client::handleCommand_Inventory(NetworkPacket* pkt)
 	if (pkt->getSize() < 1)
 		return;
 
-	std::string datastring(pkt->getString(0), pkt->getSize());
-	std::istringstream is(datastring, std::ios_base::binary);
+	StringViewStream is(pkt->getStringView(0));
 
 	LocalPlayer *player = m_env.getLocalPlayer();
 	assert(player != NULL);
@@ -453,8 +427,7 @@ void Client::handleCommand_ActiveObjectMessages(NetworkPacket* pkt)
 			string message
 		}
 	*/
-	std::string datastring(pkt->getString(0), pkt->getSize());
-	std::istringstream is(datastring, std::ios_base::binary);
+	StringViewStream is(pkt->getStringView(0));
 
 	try {
 		while (is.good()) {
@@ -634,10 +607,10 @@ void Client::handleCommand_AnnounceMedia(NetworkPacket* pkt)
 		// compressed table of media names
 		std::vector<std::string> names;
 		{
-			std::istringstream iss(pkt->readLongString(), std::ios::binary);
-			std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
-			decompressZstd(iss, ss);
-			names = deserializeString16Array(ss);
+			std::string raw;
+			decompressZstd(pkt->readLongStringView(), raw);
+			StringViewStream is(raw);
+			names = deserializeString16Array(is);
 		}
 
 		// raw hash for each media file
@@ -703,13 +676,10 @@ void Client::handleCommand_Media(NetworkPacket* pkt)
 		std::string name, data;
 
 		*pkt >> name;
-		data = pkt->readLongString();
-		if (m_proto_ver >= 48) {
-			std::istringstream iss(data, std::ios::binary);
-			std::ostringstream oss(std::ios::binary);
-			decompressZstd(iss, oss);
-			data = oss.str();
-		}
+		if (m_proto_ver >= 48)
+			decompressZstd(pkt->readLongStringView(), data);
+		else
+			data = pkt->readLongString();
 
 		bool ok = false;
 		if (init_phase) {
@@ -742,15 +712,19 @@ void Client::handleCommand_NodeDef(NetworkPacket* pkt)
 	sanity_check(!m_mesh_update_manager->isRunning());
 
 	// Decompress node definitions
-	std::istringstream tmp_is(pkt->readLongString(), std::ios::binary);
-	std::stringstream tmp_os(std::ios::binary | std::ios::in | std::ios::out);
-	if (m_proto_ver >= 48)
-		decompressZstd(tmp_is, tmp_os);
-	else
+	std::string_view compressed = pkt->readLongStringView();
+	std::string defs;
+	if (m_proto_ver >= 48) {
+		decompressZstd(compressed, defs);
+	} else {
+		StringViewStream tmp_is(compressed);
+		std::ostringstream tmp_os(std::ios::binary);
 		decompressZlib(tmp_is, tmp_os);
+		defs = tmp_os.str();
+	}
 
 	// Deserialize node definitions
-	m_nodedef->deSerialize(tmp_os, m_proto_ver);
+	m_nodedef->deSerialize(defs, m_proto_ver);
 	m_nodedef_received = true;
 }
 
@@ -764,15 +738,20 @@ void Client::handleCommand_ItemDef(NetworkPacket* pkt)
 	sanity_check(!m_mesh_update_manager->isRunning());
 
 	// Decompress item definitions
-	std::istringstream tmp_is(pkt->readLongString(), std::ios::binary);
-	std::stringstream tmp_os(std::ios::binary | std::ios::in | std::ios::out);
-	if (m_proto_ver >= 48)
-		decompressZstd(tmp_is, tmp_os);
-	else
+	std::string_view compressed = pkt->readLongStringView();
+	std::string defs;
+	if (m_proto_ver >= 48) {
+		decompressZstd(compressed, defs);
+	} else {
+		StringViewStream tmp_is(compressed);
+		std::ostringstream tmp_os(std::ios::binary);
 		decompressZlib(tmp_is, tmp_os);
+		defs = tmp_os.str();
+	}
 
-	// Deserialize node definitions
-	m_itemdef->deSerialize(tmp_os, m_proto_ver);
+	// Deserialize item definitions
+	StringViewStream defs_is(defs);
+	m_itemdef->deSerialize(defs_is, m_proto_ver);
 	m_itemdef_received = true;
 }
 
@@ -939,8 +918,7 @@ void Client::handleCommand_DetachedInventory(NetworkPacket* pkt)
 	// this used to be the length of the following string, ignore it
 	pkt->skip(2);
 
-	std::string contents(pkt->getRemainingString(), pkt->getRemainingBytes());
-	std::istringstream is(contents, std::ios::binary);
+	StringViewStream is(pkt->getRemainingStringView());
 	inv->deSerialize(is);
 }
 
@@ -965,8 +943,7 @@ void Client::handleCommand_SpawnParticle(NetworkPacket* pkt)
 	if (g_settings->getBool("norender.particles")) {
 		return;
 	}
-	std::string datastring(pkt->getString(0), pkt->getSize());
-	std::istringstream is(datastring, std::ios_base::binary);
+	StringViewStream is(pkt->getStringView(0));
 
 	ParticleParameters p;
 	p.deSerialize(is, m_proto_ver);
@@ -983,8 +960,7 @@ void Client::handleCommand_AddParticleSpawner(NetworkPacket* pkt)
 	if (g_settings->getBool("norender.particles")) {
 		return;
 	}
-	std::string datastring(pkt->getString(0), pkt->getSize());
-	std::istringstream is(datastring, std::ios_base::binary);
+	StringViewStream is(pkt->getStringView(0));
 
 	ParticleSpawnerParameters p;
 	u32 server_id;
@@ -1297,8 +1273,7 @@ void Client::handleCommand_HudSetSky(NetworkPacket* pkt)
 	if (m_proto_ver < 39) {
 		// Handle Protocol 38 and below servers with old set_sky,
 		// ensuring the classic look is kept.
-		std::string datastring(pkt->getString(0), pkt->getSize());
-		std::istringstream is(datastring, std::ios_base::binary);
+		StringViewStream is(pkt->getStringView(0));
 
 		SkyboxParams skybox;
 		skybox.bgcolor = video::SColor(readARGB8(is));
@@ -1648,7 +1623,7 @@ void Client::handleCommand_MediaPush(NetworkPacket *pkt)
 		}
 
 		// Actually load media
-		loadMedia(filedata, filename, true);
+		loadMedia(filedata, filename, true, raw_hash);
 
 		// Cache file for the next time when this client joins the same server
 		if (cached)
@@ -184,77 +184,51 @@ void ReliablePacketBuffer::print()
 	MutexAutoLock listlock(m_list_mutex);
 	LOG(dout_con<<"Dump of ReliablePacketBuffer:" << std::endl);
 	unsigned int index = 0;
-	for (BufferedPacketPtr &packet : m_list) {
-		LOG(dout_con<<index<< ":" << packet->getSeqnum() << std::endl);
+	m_packets.forEach([&] (u16 seqnum, BufferedPacketPtr &) {
+		LOG(dout_con<<index<< ":" << seqnum << std::endl);
 		index++;
-	}
+	});
 }
 
 bool ReliablePacketBuffer::empty()
 {
 	MutexAutoLock listlock(m_list_mutex);
-	return m_list.empty();
+	return m_packets.empty();
 }
 
 u32 ReliablePacketBuffer::size()
 {
 	MutexAutoLock listlock(m_list_mutex);
-	return m_list.size();
-}
-
-ReliablePacketBuffer::FindResult ReliablePacketBuffer::findPacketNoLock(u16 seqnum)
-{
-	for (auto it = m_list.begin(); it != m_list.end(); ++it) {
-		if ((*it)->getSeqnum() == seqnum)
-			return it;
-	}
-	return m_list.end();
+	return m_packets.size();
 }
 
 bool ReliablePacketBuffer::getFirstSeqnum(u16& result)
 {
 	MutexAutoLock listlock(m_list_mutex);
-	if (m_list.empty())
+	if (m_packets.empty())
 		return false;
-	result = m_list.front()->getSeqnum();
+	result = m_packets.first();
 	return true;
 }
 
 BufferedPacketPtr ReliablePacketBuffer::popFirst()
 {
 	MutexAutoLock listlock(m_list_mutex);
-	if (m_list.empty())
+	if (m_packets.empty())
 		throw NotFoundException("Buffer is empty");
 
-	BufferedPacketPtr p(m_list.front());
-	m_list.pop_front();
-
-	if (m_list.empty()) {
-		m_oldest_non_answered_ack = 0;
-	} else {
-		m_oldest_non_answered_ack = m_list.front()->getSeqnum();
-	}
-	return p;
+	return m_packets.take(m_packets.first());
 }
 
 BufferedPacketPtr ReliablePacketBuffer::popSeqnum(u16 seqnum)
 {
 	MutexAutoLock listlock(m_list_mutex);
-	auto r = findPacketNoLock(seqnum);
-	if (r == m_list.end()) {
+	BufferedPacketPtr p = m_packets.take(seqnum);
+	if (!p) {
 		LOG(dout_con<<"Sequence number: " << seqnum
 				<< " not found in reliable buffer"<<std::endl);
 		throw NotFoundException("seqnum not found in buffer");
 	}
-
-	BufferedPacketPtr p(*r);
-	m_list.erase(r);
-
-	if (m_list.empty()) {
-		m_oldest_non_answered_ack = 0;
-	} else {
-		m_oldest_non_answered_ack = m_list.front()->getSeqnum();
-	}
 	return p;
 }
 
@@ -287,105 +261,72 @@ void ReliablePacketBuffer::insert(BufferedPacketPtr &p_ptr, u16 next_expected)
 		return;
 	}
 
-	sanity_check(m_list.size() <= SEQNUM_MAX); // FIXME: Handle the error?
-
-	// Find the right place for the packet and insert it there
-	// If list is empty, just add it
-	if (m_list.empty()) {
-		m_list.push_back(p_ptr);
-		m_oldest_non_answered_ack = seqnum;
-		// Done.
+	// The packets must stay in a range where their order is well-defined
+	if (m_packets.spanWith(seqnum) > SeqnumRing<BufferedPacketPtr>::MAX_SPAN) {
+		errorstream << "ReliablePacketBuffer::insert(): seqnum is too far "
+			"from buffered packets" << std::endl;
 		return;
 	}
 
-	// Otherwise find the right place
-	auto it = m_list.begin();
-	// Find the first packet in the list which has a higher seqnum
-	u16 s = (*it)->getSeqnum();
-
-	/* case seqnum is smaller then next_expected seqnum */
-	/* this is true e.g. on wrap around */
-	if (seqnum < next_expected) {
-		while(((s < seqnum) || (s >= next_expected)) && (it != m_list.end())) {
-			++it;
-			if (it != m_list.end())
-				s = (*it)->getSeqnum();
-		}
-	}
-	/* non wrap around case (at least for incoming and next_expected */
-	else
-	{
-		while(((s < seqnum) && (s >= next_expected)) && (it != m_list.end())) {
-			++it;
-			if (it != m_list.end())
-				s = (*it)->getSeqnum();
-		}
+	BufferedPacketPtr *existing = m_packets.get(seqnum);
+	if (!existing) {
+		m_packets.set(seqnum, p_ptr);
+		return;
 	}
 
-	if (s == seqnum) {
-		/* nothing to do this seems to be a resent packet */
-		/* for paranoia reason data should be compared */
-		auto &i = *it;
-		if (
-			(i->getSeqnum() != seqnum) ||
-			(i->size() != p.size()) ||
-			(i->address != p.address)
-			)
-		{
-			/* if this happens your maximum transfer window may be to big */
-			char buf[200];
-			snprintf(buf, sizeof(buf),
-					"Duplicated seqnum %d non matching packet detected:\n",
-					seqnum);
-			warningstream << buf;
-			snprintf(buf, sizeof(buf),
-					"Old: seqnum: %05d size: %04zu, address: %s\n",
-					i->getSeqnum(), i->size(),
-					i->address.serializeString().c_str());
-			warningstream << buf;
-			snprintf(buf, sizeof(buf),
-					"New: seqnum: %05d size: %04zu, address: %s\n",
-					p.getSeqnum(), p.size(),
-					p.address.serializeString().c_str());
-			warningstream << buf << std::flush;
-			throw IncomingDataCorruption("duplicated packet isn't same as original one");
-		}
-	}
-	/* insert or push back */
-	else if (it != m_list.end()) {
-		m_list.insert(it, p_ptr);
-	} else {
-		m_list.push_back(p_ptr);
+	/* nothing to do this seems to be a resent packet */
+	/* for paranoia reason data should be compared */
+	auto &i = *existing;
+	if (
+		(i->size() != p.size()) ||
+		(i->address != p.address)
+		)
+	{
+		/* if this happens your maximum transfer window may be to big */
+		char buf[200];
+		snprintf(buf, sizeof(buf),
+				"Duplicated seqnum %d non matching packet detected:\n",
+				seqnum);
+		warningstream << buf;
+		snprintf(buf, sizeof(buf),
+				"Old: seqnum: %05d size: %04zu, address: %s\n",
+				i->getSeqnum(), i->size(),
+				i->address.serializeString().c_str());
+		warningstream << buf;
+		snprintf(buf, sizeof(buf),
+				"New: seqnum: %05d size: %04zu, address: %s\n",
+				p.getSeqnum(), p.size(),
+				p.address.serializeString().c_str());
+		warningstream << buf << std::flush;
+		throw IncomingDataCorruption("duplicated packet isn't same as original one");
 	}
-
-	/* update last packet number */
-	m_oldest_non_answered_ack = m_list.front()->getSeqnum();
 }
 
 void ReliablePacketBuffer::fixPeerId(session_t new_id)
 {
 	MutexAutoLock listlock(m_list_mutex);
-	for (auto &packet : m_list)
+	m_packets.forEach([&] (u16, BufferedPacketPtr &packet) {
 		packet->setSenderPeerId(new_id);
+	});
 }
 
 void ReliablePacketBuffer::incrementTimeouts(float dtime)
 {
 	MutexAutoLock listlock(m_list_mutex);
-	for (auto &packet : m_list) {
+	m_packets.forEach([&] (u16, BufferedPacketPtr &packet) {
 		packet->time += dtime;
 		packet->totaltime += dtime;
-	}
+	});
 }
 
 u32 ReliablePacketBuffer::getTimedOuts(float timeout)
 {
 	MutexAutoLock listlock(m_list_mutex);
 	u32 count = 0;
-	for (auto &packet : m_list) {
+	m_packets.forEach([&] (u16, BufferedPacketPtr &packet) {
 		if (packet->totaltime >= timeout)
 			count++;
-	}
+	});
 	return count;
 }
 
@@ -394,7 +335,13 @@ std::vector<ConstSharedPtr<BufferedPacket>>
 {
 	MutexAutoLock listlock(m_list_mutex);
 	std::vector<ConstSharedPtr<BufferedPacket>> timed_outs;
-	for (auto &packet : m_list) {
+	const u16 first = m_packets.first();
+	for (u32 i = 0; i < m_packets.span(); i++) {
+		BufferedPacketPtr *found = m_packets.get(first + i);
+		if (!found)
+			continue;
+		BufferedPacket *packet = found->get();
+
 		// resend time scales exponentially with each cycle
 		const float pkt_timeout = timeout * powf(RESEND_SCALE_BASE, packet->resend_count);
 
@@ -405,7 +352,7 @@ std::vector<ConstSharedPtr<BufferedPacket>>
 		packet->time = 0.0f;
 		packet->resend_count++;
 
-		timed_outs.emplace_back(packet);
+		timed_outs.emplace_back(*found);
 
 		if (timed_outs.size() >= max_packets)
 			break;
@@ -459,14 +406,6 @@ SharedBuffer<u8> IncomingSplitPacket::reassemble()
 	IncomingSplitBuffer
 */
 
-IncomingSplitBuffer::~IncomingSplitBuffer()
-{
-	MutexAutoLock listlock(m_map_mutex);
-	for (auto &i : m_buf) {
-		delete i.second;
-	}
-}
-
 SharedBuffer<u8> IncomingSplitBuffer::insert(BufferedPacketPtr &p_ptr, bool reliable)
 {
 	MutexAutoLock listlock(m_map_mutex);
@@ -495,11 +434,16 @@ SharedBuffer<u8> IncomingSplitBuffer::insert(BufferedPacketPtr &p_ptr, bool reli
 
 	// Add if doesn't exist
 	IncomingSplitPacket *sp;
-	if (m_buf.find(seqnum) == m_buf.end()) {
-		sp = new IncomingSplitPacket(chunk_count, reliable);
-		m_buf[seqnum] = sp;
+	if (auto *found = m_buf.get(seqnum)) {
+		sp = found->get();
 	} else {
-		sp = m_buf[seqnum];
+		// Packets that are half the seqnum space behind are long gone
+		while (m_buf.spanWith(seqnum) > decltype(m_buf)::MAX_SPAN) {
+			LOG(dout_con<<"NOTE: Removing stale split packet"<<std::endl);
+			m_buf.take(m_buf.first());
+		}
+		sp = new IncomingSplitPacket(chunk_count, reliable);
+		m_buf.set(seqnum, std::unique_ptr<IncomingSplitPacket>(sp));
 	}
 
 	if (chunk_count != sp->chunk_count) {
@@ -528,8 +472,7 @@ SharedBuffer<u8> IncomingSplitBuffer::insert(BufferedPacketPtr &p_ptr, bool reli
 	SharedBuffer<u8> fulldata = sp->reassemble();
 
 	// Remove sp from buffer
-	m_buf.erase(seqnum);
-	delete sp;
+	m_buf.take(seqnum);
 
 	return fulldata;
 }
@@ -538,22 +481,17 @@ void IncomingSplitBuffer::removeUnreliableTimedOuts(float dtime, float timeout)
 {
 	MutexAutoLock listlock(m_map_mutex);
 	std::vector<u16> remove_queue;
-	{
-		for (const auto &i : m_buf) {
-			IncomingSplitPacket *p = i.second;
-			// Reliable ones are not removed by timeout
-			if (p->reliable)
-				continue;
-			p->time += dtime;
-			if (p->time >= timeout)
-				remove_queue.push_back(i.first);
-		}
-	}
+	m_buf.forEach([&] (u16 seqnum, std::unique_ptr<IncomingSplitPacket> &p) {
+		// Reliable ones are not removed by timeout
+		if (p->reliable)
+			return;
+		p->time += dtime;
+		if (p->time >= timeout)
+			remove_queue.push_back(seqnum);
+	});
 	for (u16 j : remove_queue) {
 		LOG(dout_con<<"NOTE: Removing timed out unreliable split packet"<<std::endl);
-		auto it = m_buf.find(j);
-		delete it->second;
-		m_buf.erase(it);
+		m_buf.take(j);
 	}
 }
 
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "network/mtp/impl.h"
+#include <algorithm>
 
 // Constant that differentiates the protocol from random data and other protocols
 #define PROTOCOL_ID 0x4f457403
@@ -252,7 +253,131 @@ struct IncomingSplitPacket
 };
 
 /*
-	A buffer which stores reliable packets and sorts them internally
+	Items keyed by sequence number, kept in a ring where seqnum s lives in
+	slot s % capacity. All items lie in the range of seqnums starting at
+	first(), which never spans more than half of the seqnum space, so the
+	order is unambiguous and lookups, inserts and removals touch one slot.
+	T has to be a pointer type that is null for empty slots.
+*/
+template <typename T>
+class SeqnumRing
+{
+public:
+	// Largest range for which the order of seqnums is well-defined
+	static constexpr u32 MAX_SPAN = (SEQNUM_MAX + 1) / 2;
+
+	bool empty() const { return m_count == 0; }
+	u32 size() const { return m_count; }
+	// Seqnum of the first item, only meaningful if not empty
+	u16 first() const { return m_first; }
+	// Number of seqnums from the first to the last item
+	u32 span() const { return m_span; }
+
+	// Span the range would have after adding seqnum
+	u32 spanWith(u16 seqnum) const
+	{
+		if (m_count == 0)
+			return 1;
+		u16 after = (u16)(seqnum - m_first);
+		if (after < MAX_SPAN)
+			return std::max<u32>(m_span, after + 1);
+		return m_span + (u16)(m_first - seqnum);
+	}
+
+	// Returns nullptr if there is no item for seqnum
+	T *get(u16 seqnum)
+	{
+		if ((u16)(seqnum - m_first) >= m_span)
+			return nullptr;
+		T &item = slot(seqnum);
+		return item ? &item : nullptr;
+	}
+
+	// There must be no item for seqnum yet and spanWith(seqnum) <= MAX_SPAN
+	void set(u16 seqnum, T item)
+	{
+		const u32 span = spanWith(seqnum);
+		sanity_check(span <= MAX_SPAN);
+		if (span > m_slots.size())
+			grow(span);
+		if (m_count == 0 || (u16)(seqnum - m_first) >= MAX_SPAN)
+			m_first = seqnum;
+		m_span = span;
+
+		T &slot_item = slot(seqnum);
+		sanity_check(!slot_item);
+		slot_item = std::move(item);
+		m_count++;
+	}
+
+	// Removes and returns the item for seqnum, null if there is none
+	T take(u16 seqnum)
+	{
+		T *found = get(seqnum);
+		if (!found)
+			return T();
+		T item = std::move(*found);
+		*found = T();
+		m_count--;
+
+		if (m_count == 0) {
+			m_span = 0;
+			// Don't hold on to the memory of an unusually large range
+			if (m_slots.size() > KEEP_SLOTS)
+				m_slots = std::vector<T>();
+		} else if (seqnum == m_first) {
+			do {
+				m_first++;
+				m_span--;
+			} while (!slot(m_first));
+		} else {
+			while (!slot(m_first + m_span - 1))
+				m_span--;
+		}
+		return item;
+	}
+
+	// Calls f(seqnum, item) for all items, in order
+	template <typename F>
+	void forEach(F &&f)
+	{
+		for (u32 i = 0; i < m_span; i++) {
+			const u16 seqnum = m_first + i;
+			T &item = slot(seqnum);
+			if (item)
+				f(seqnum, item);
+		}
+	}
+
+private:
+	// Enough for the largest window used for sending
+	static constexpr u32 KEEP_SLOTS = 2048;
+
+	T &slot(u16 seqnum) { return m_slots[seqnum & (m_slots.size() - 1)]; }
+
+	void grow(u32 span)
+	{
+		u32 capacity = std::max<u32>(m_slots.size(), 16);
+		while (capacity < span)
+			capacity *= 2;
+
+		std::vector<T> slots(capacity);
+		for (u32 i = 0; i < m_span; i++) {
+			const u16 seqnum = m_first + i;
+			slots[seqnum & (capacity - 1)] = std::move(slot(seqnum));
+		}
+		m_slots = std::move(slots);
+	}
+
+	// Size is zero or a power of two
+	std::vector<T> m_slots;
+	u16 m_first = 0;
+	u32 m_span = 0;
+	u32 m_count = 0;
+};
+
+/*
+	A buffer which stores reliable packets by seqnum, in order
 	for fast access to the smallest one.
 */
 
@@ -278,13 +403,7 @@ class ReliablePacketBuffer
 
 
 private:
-	typedef std::list<BufferedPacketPtr>::iterator FindResult;
-
-	FindResult findPacketNoLock(u16 seqnum);
-
-	std::list<BufferedPacketPtr> m_list;
-
-	u16 m_oldest_non_answered_ack;
+	SeqnumRing<BufferedPacketPtr> m_packets;
 
 	std::mutex m_list_mutex;
 };
@@ -296,8 +415,6 @@ class ReliablePacketBuffer
 class IncomingSplitBuffer
 {
 public:
-	~IncomingSplitBuffer();
-
 	/*
 		Returns a reference counted buffer of length != 0 when a full split
 		packet is constructed. If not, returns one of length 0.
@@ -307,8 +424,7 @@ class IncomingSplitBuffer
 	void removeUnreliableTimedOuts(float dtime, float timeout);
 
 private:
-	// Key is seqnum
-	std::map<u16, IncomingSplitPacket*> m_buf;
+	SeqnumRing<std::unique_ptr<IncomingSplitPacket>> m_buf;
 
 	std::mutex m_map_mutex;
 };
@@ -30,6 +30,9 @@ namespace con
 
 #define MAX_NEW_PEERS_PER_SEC 30
 
+// Datagrams that are received or sent together
+#define DATAGRAM_BATCH_SIZE 32
+
 static inline session_t readPeerId(const u8 *packetdata)
 {
 	return readU16(&packetdata[4]);
@@ -52,6 +55,8 @@ ConnectionSendThread::ConnectionSendThread(unsigned int max_packet_size,
 	m_timeout(timeout),
 	m_max_data_packets_per_iteration(g_settings->getU16(MPPI_SETTING))
 {
+	m_send_batch.resize(DATAGRAM_BATCH_SIZE);
+
 	auto &mppi = m_max_data_packets_per_iteration;
 	mppi = MYMAX(mppi, 1);
 
@@ -123,6 +128,9 @@ void *ConnectionSendThread::run()
 		/* send queued packets */
 		sendPackets(dtime, calculate_quota());
 
+		/* put everything on the wire before sleeping */
+		flushSendBatch();
+
 		END_DEBUG_EXCEPTION_HANDLER
 	}
 
@@ -299,16 +307,31 @@ void ConnectionSendThread::resendReliable(Channel &channel, const BufferedPacket
 void ConnectionSendThread::rawSend(const BufferedPacket *p)
 {
 	assert(p);
-	try {
-		m_connection->m_udpSocket.Send(p->address, p->data, p->size());
-		//LOG(dout_con << m_connection->getDesc()
-		//	<< " rawSend: " << p->size()
-		//	<< " bytes sent" << std::endl);
-	} catch (SendFailedException &e) {
+	UDPDatagram &datagram = m_send_batch[m_send_batch_size++];
+	datagram.address = p->address;
+	datagram.data.assign(p->data, p->data + p->size());
+	datagram.size = p->size();
+
+	if (m_send_batch_size == m_send_batch.size())
+		flushSendBatch();
+}
+
+void ConnectionSendThread::flushSendBatch()
+{
+	if (m_send_batch_size == 0)
+		return;
+
+	int failed = m_connection->m_udpSocket.SendMany(m_send_batch.data(),
+			m_send_batch_size);
+	if (failed > 0) {
 		LOG(derr_con << m_connection->getDesc()
-			<< "SendFailedException: " << e.what() << " to "
-			<< p->address.serializeString() << std::endl);
+			<< "Failed to send " << failed << " of "
+			<< m_send_batch_size << " packets" << std::endl);
 	}
+	//LOG(dout_con << m_connection->getDesc()
+	//	<< " flushSendBatch: " << m_send_batch_size
+	//	<< " packets sent" << std::endl);
+	m_send_batch_size = 0;
 }
 
 void ConnectionSendThread::sendAsPacketReliable(BufferedPacketPtr &p, Channel *channel)
@@ -844,7 +867,9 @@ void *ConnectionReceiveThread::run()
 	// theoretical reliable upper boundary of a udp packet for all IPv6 enabled
 	// infrastructure
 	const unsigned int packet_maxsize = 1500;
-	SharedBuffer<u8> packetdata(packet_maxsize);
+	std::vector<UDPDatagram> datagrams(DATAGRAM_BATCH_SIZE);
+	for (UDPDatagram &datagram : datagrams)
+		datagram.data.resize(packet_maxsize);
 
 	bool packet_queued = true;
 
@@ -866,7 +891,7 @@ void *ConnectionReceiveThread::run()
 #endif
 
 		/* receive packets */
-		receive(packetdata, packet_queued);
+		receive(datagrams, packet_queued);
 
 #ifdef DEBUG_CONNECTION_KBPS
 		debug_print_timer += dtime;
@@ -926,35 +951,61 @@ void *ConnectionReceiveThread::run()
 }
 
 // Receive packets from the network and buffers and create ConnectionEvents
-void ConnectionReceiveThread::receive(SharedBuffer<u8> &packetdata,
+void ConnectionReceiveThread::receive(std::vector<UDPDatagram> &datagrams,
 		bool &packet_queued)
 {
-	try {
-		// First, see if there any buffered packets we can process now
+	// First, see if there any buffered packets we can process now
+	if (packet_queued) {
+		receiveBuffered();
+		packet_queued = false;
+	}
+
+	// Wait for incoming data, and take all that is there at once
+	int count = m_connection->m_udpSocket.ReceiveMany(datagrams.data(),
+		datagrams.size());
+	for (int i = 0; i < count; i++) {
+		// Packets that became ready because of the previous datagram
+		// go first, as if each datagram had been received on its own
 		if (packet_queued) {
-			session_t peer_id;
-			SharedBuffer<u8> resultdata;
-			while (true) {
-				try {
-					if (!getFromBuffers(peer_id, resultdata))
-						break;
-
-					m_connection->putEvent(ConnectionEvent::dataReceived(peer_id, resultdata));
-				}
-				catch (ProcessedSilentlyException &e) {
-					/* try reading again */
-				}
-			}
+			receiveBuffered();
 			packet_queued = false;
 		}
 
-		// Call Receive() to wait for incoming data
-		Address sender;
-		s32 received_size = m_connection->m_udpSocket.Receive(sender,
-			*packetdata, packetdata.getSize());
-		if (received_size < 0)
-			return;
+		/* Every time we receive a packet it can happen that a previously
+		 * buffered packet is now ready to process. */
+		if (receiveDatagram(datagrams[i]))
+			packet_queued = true;
+	}
+}
+
+void ConnectionReceiveThread::receiveBuffered()
+{
+	try {
+		session_t peer_id;
+		SharedBuffer<u8> resultdata;
+		while (true) {
+			try {
+				if (!getFromBuffers(peer_id, resultdata))
+					break;
+
+				m_connection->putEvent(ConnectionEvent::dataReceived(peer_id, resultdata));
+			}
+			catch (ProcessedSilentlyException &e) {
+				/* try reading again */
+			}
+		}
+	}
+	catch (InvalidIncomingDataException &e) {
+	}
+}
 
+bool ConnectionReceiveThread::receiveDatagram(const UDPDatagram &datagram)
+{
+	const Address &sender = datagram.address;
+	const u8 *packetdata = datagram.data.data();
+	const s32 received_size = datagram.size;
+
+	try {
 		if ((received_size < BASE_HEADER_SIZE) ||
 				(readU32(&packetdata[0]) != m_connection->GetProtocolID())) {
 			LOG(derr_con << m_connection->getDesc()
@@ -963,16 +1014,16 @@ void ConnectionReceiveThread::receive(SharedBuffer<u8> &packetdata,
 				<< ", protocol: "
 				<< ((received_size >= 4) ? readU32(&packetdata[0]) : -1)
 				<< std::endl);
-			return;
+			return false;
 		}
 
-		session_t peer_id = readPeerId(*packetdata);
-		u8 channelnum = readChannel(*packetdata);
+		session_t peer_id = readPeerId(packetdata);
+		u8 channelnum = readChannel(packetdata);
 
 		if (channelnum >= CHANNEL_COUNT) {
 			LOG(derr_con << m_connection->getDesc()
 				<< "Receive(): Invalid channel " << (int)channelnum << std::endl);
-			return;
+			return false;
 		}
 
 		const bool knew_peer_id = peer_id != PEER_ID_INEXISTENT;
@@ -1012,7 +1063,7 @@ void ConnectionReceiveThread::receive(SharedBuffer<u8> &packetdata,
 			LOG(dout_con << m_connection->getDesc()
 				<< " got packet from unknown peer_id: "
 				<< peer_id << " Ignoring." << std::endl);
-			return;
+			return false;
 		}
 
 		// Validate peer address
@@ -1021,7 +1072,7 @@ void ConnectionReceiveThread::receive(SharedBuffer<u8> &packetdata,
 			LOG(derr_con << m_connection->getDesc()
 				<< " Peer " << peer_id << " sending from different address."
 				" Ignoring." << std::endl);
-			return;
+			return false;
 		}
 
 		if (knew_peer_id) {
@@ -1034,7 +1085,7 @@ void ConnectionReceiveThread::receive(SharedBuffer<u8> &packetdata,
 			LOG(derr_con << m_connection->getDesc()
 				<< " Peer " << peer_id << " sending without peer id?!"
 				" Ignoring." << std::endl);
-			return;
+			return false;
 		}
 
 		auto *udpPeer = dynamic_cast<UDPPeer *>(&peer);
@@ -1042,7 +1093,7 @@ void ConnectionReceiveThread::receive(SharedBuffer<u8> &packetdata,
 			LOG(derr_con << m_connection->getDesc()
 				<< "Receive(): peer_id=" << peer_id << " isn't an UDPPeer?!"
 				" Ignoring." << std::endl);
-			return;
+			return false;
 		}
 		Channel *channel = &udpPeer->channels[channelnum];
 
@@ -1070,15 +1121,13 @@ void ConnectionReceiveThread::receive(SharedBuffer<u8> &packetdata,
 		catch (ProcessedSilentlyException &e) {
 		}
 		catch (ProcessedQueued &e) {
-			// we set it to true anyway (see below)
+			// receive() sets packet_queued anyway
 		}
-
-		/* Every time we receive a packet it can happen that a previously
-		 * buffered packet is now ready to process. */
-		packet_queued = true;
 	}
 	catch (InvalidIncomingDataException &e) {
+		return false;
 	}
+	return true;
 }
 
 bool ConnectionReceiveThread::getFromBuffers(session_t &peer_id, SharedBuffer<u8> &dst)
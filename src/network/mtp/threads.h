@@ -12,6 +12,7 @@
 #include <cassert>
 #include "threading/thread.h"
 #include "network/mtp/internal.h"
+#include "network/socket.h"
 
 namespace con
 {
@@ -60,7 +61,9 @@ class ConnectionSendThread : public Thread
 private:
 	void runTimeouts(float dtime, u32 peer_packet_quota);
 	void resendReliable(Channel &channel, const BufferedPacket *k, float resend_timeout);
+	// Queues the packet, it is sent by the next flushSendBatch()
 	void rawSend(const BufferedPacket *p);
+	void flushSendBatch();
 	bool rawSendAsPacket(session_t peer_id, u8 channelnum,
 			const SharedBuffer<u8> &data, bool reliable);
 
@@ -93,6 +96,11 @@ class ConnectionSendThread : public Thread
 
 	unsigned int m_iteration_packets_avaialble;
 	unsigned int m_max_data_packets_per_iteration;
+
+	// Outgoing datagrams collected by rawSend(), the first
+	// m_send_batch_size of them are waiting to be sent
+	std::vector<UDPDatagram> m_send_batch;
+	size_t m_send_batch_size = 0;
 	unsigned int m_max_packets_requeued = 256;
 };
 
@@ -110,7 +118,11 @@ class ConnectionReceiveThread : public Thread
 	}
 
 private:
-	void receive(SharedBuffer<u8> &packetdata, bool &packet_queued);
+	void receive(std::vector<UDPDatagram> &datagrams, bool &packet_queued);
+	// Puts out the buffered packets that can be processed now
+	void receiveBuffered();
+	// Returns true if the datagram was handed to a channel
+	bool receiveDatagram(const UDPDatagram &datagram);
 
 	// Returns next data from a buffer if possible
 	// If found, returns true; if not, false.
@@ -52,6 +52,14 @@ const char* NetworkPacket::getString(u32 from_offset) const
 	return reinterpret_cast<const char*>(&m_data[from_offset]);
 }
 
+std::string_view NetworkPacket::getStringView(u32 from_offset) const
+{
+	checkReadOffset(from_offset, 0);
+
+	return std::string_view(reinterpret_cast<const char*>(m_data.data()) + from_offset,
+			m_datasize - from_offset);
+}
+
 void NetworkPacket::skip(u32 count)
 {
 	checkReadOffset(m_read_offset, count);
@@ -204,6 +212,11 @@ NetworkPacket& NetworkPacket::operator<<(std::wstring_view src)
 }
 
 std::string NetworkPacket::readLongString()
+{
+	return std::string(readLongStringView());
+}
+
+std::string_view NetworkPacket::readLongStringView()
 {
 	checkReadOffset(m_read_offset, 4);
 	u32 strLen = readU32(&m_data[m_read_offset]);
@@ -219,10 +232,7 @@ std::string NetworkPacket::readLongString()
 
 	checkReadOffset(m_read_offset, strLen);
 
-	std::string dst;
-
-	dst.reserve(strLen);
-	dst.append((char*)&m_data[m_read_offset], strLen);
+	std::string_view dst(reinterpret_cast<const char*>(&m_data[m_read_offset]), strLen);
 
 	m_read_offset += strLen;
 
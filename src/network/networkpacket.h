@@ -43,6 +43,13 @@ class NetworkPacket
 	const char *getString(u32 from_offset) const;
 	const char *getRemainingString() const { return getString(m_read_offset); }
 
+	// Non-owning views of the buffer data, valid until the packet is changed
+	std::string_view getStringView(u32 from_offset) const;
+	std::string_view getRemainingStringView() const
+	{
+		return getStringView(m_read_offset);
+	}
+
 	// Perform length check and skip ahead by `count` bytes.
 	void skip(u32 count);
 
@@ -72,6 +79,8 @@ class NetworkPacket
 	NetworkPacket &operator<<(std::wstring_view src);
 
 	std::string readLongString();
+	// Same as readLongString(), but points into the packet instead of copying
+	std::string_view readLongStringView();
 
 	NetworkPacket &operator>>(char &dst);
 	NetworkPacket &operator<<(char src);
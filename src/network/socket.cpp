@@ -35,6 +35,13 @@ typedef int socklen_t;
 #define SOCKET_ERR_STR(e) strerror(e)
 #endif
 
+#ifdef __linux__
+// recvmmsg() and sendmmsg() are available
+#define HAVE_MMSG 1
+// Maximum number of datagrams per recvmmsg()/sendmmsg() call
+static constexpr int MMSG_BATCH_MAX = 64;
+#endif
+
 static bool g_sockets_initialized = false;
 
 // Initialize sockets
@@ -165,6 +172,35 @@ void UDPSocket::Bind(Address addr)
 	}
 }
 
+static socklen_t toSockaddr(const Address &address, struct sockaddr_storage &out)
+{
+	memset(&out, 0, sizeof(out));
+	if (address.getFamily() == AF_INET6) {
+		auto *addr6 = reinterpret_cast<struct sockaddr_in6 *>(&out);
+		addr6->sin6_family = AF_INET6;
+		addr6->sin6_addr = address.getAddress6();
+		addr6->sin6_port = htons(address.getPort());
+		return sizeof(struct sockaddr_in6);
+	}
+	auto *addr4 = reinterpret_cast<struct sockaddr_in *>(&out);
+	addr4->sin_family = AF_INET;
+	addr4->sin_addr = address.getAddress();
+	addr4->sin_port = htons(address.getPort());
+	return sizeof(struct sockaddr_in);
+}
+
+static Address fromSockaddr(const struct sockaddr_storage &in)
+{
+	if (in.ss_family == AF_INET6) {
+		auto *addr6 = reinterpret_cast<const struct sockaddr_in6 *>(&in);
+		const auto *bytes = reinterpret_cast<const IPv6AddressBytes *>
+			(addr6->sin6_addr.s6_addr);
+		return Address(bytes, ntohs(addr6->sin6_port));
+	}
+	auto *addr4 = reinterpret_cast<const struct sockaddr_in *>(&in);
+	return Address(ntohl(addr4->sin_addr.s_addr), ntohs(addr4->sin_port));
+}
+
 void UDPSocket::Send(const Address &destination, const void *data, int size)
 {
 	bool dumping_packet = false; // for INTERNET_SIMULATOR
@@ -182,24 +218,10 @@ void UDPSocket::Send(const Address &destination, const void *data, int size)
 	if (destination.getFamily() != m_addr_family)
 		throw SendFailedException("Address family mismatch");
 
-	int sent;
-	if (m_addr_family == AF_INET6) {
-		struct sockaddr_in6 address = {};
-		address.sin6_family = AF_INET6;
-		address.sin6_addr = destination.getAddress6();
-		address.sin6_port = htons(destination.getPort());
-
-		sent = sendto(m_handle, (const char *)data, size, 0,
-				(struct sockaddr *)&address, sizeof(struct sockaddr_in6));
-	} else {
-		struct sockaddr_in address = {};
-		address.sin_family = AF_INET;
-		address.sin_addr = destination.getAddress();
-		address.sin_port = htons(destination.getPort());
-
-		sent = sendto(m_handle, (const char *)data, size, 0,
-				(struct sockaddr *)&address, sizeof(struct sockaddr_in));
-	}
+	struct sockaddr_storage address;
+	socklen_t address_len = toSockaddr(destination, address);
+	int sent = sendto(m_handle, (const char *)data, size, 0,
+			(struct sockaddr *)&address, address_len);
 
 	if (sent != size)
 		throw SendFailedException("Failed to send packet");
@@ -214,41 +236,120 @@ int UDPSocket::Receive(Address &sender, void *data, int size)
 
 	size = MYMAX(size, 0);
 
-	int received;
-	if (m_addr_family == AF_INET6) {
-		struct sockaddr_in6 address;
-		memset(&address, 0, sizeof(address));
-		socklen_t address_len = sizeof(address);
+	struct sockaddr_storage address;
+	socklen_t address_len = sizeof(address);
+	int received = recvfrom(m_handle, (char *)data, size, 0,
+			(struct sockaddr *)&address, &address_len);
 
-		received = recvfrom(m_handle, (char *)data, size, 0,
-				(struct sockaddr *)&address, &address_len);
-
-		if (received < 0)
-			return -1;
+	if (received < 0)
+		return -1;
 
-		u16 address_port = ntohs(address.sin6_port);
-		const auto *bytes = reinterpret_cast<IPv6AddressBytes*>
-			(address.sin6_addr.s6_addr);
-		sender = Address(bytes, address_port);
-	} else {
-		struct sockaddr_in address;
-		memset(&address, 0, sizeof(address));
+	sender = fromSockaddr(address);
+	return received;
+}
 
-		socklen_t address_len = sizeof(address);
+int UDPSocket::ReceiveMany(UDPDatagram *datagrams, int count)
+{
+	if (count <= 0)
+		return 0;
 
-		received = recvfrom(m_handle, (char *)data, size, 0,
-				(struct sockaddr *)&address, &address_len);
+#ifdef HAVE_MMSG
+	// Return on timeout
+	assert(m_timeout_ms >= 0);
+	if (!WaitData(m_timeout_ms))
+		return 0;
+
+	count = MYMIN(count, MMSG_BATCH_MAX);
+	struct mmsghdr msgs[MMSG_BATCH_MAX];
+	struct iovec iovecs[MMSG_BATCH_MAX];
+	struct sockaddr_storage addresses[MMSG_BATCH_MAX];
+	memset(msgs, 0, sizeof(msgs[0]) * count);
+	for (int i = 0; i < count; i++) {
+		iovecs[i].iov_base = datagrams[i].data.data();
+		iovecs[i].iov_len = datagrams[i].data.size();
+		msgs[i].msg_hdr.msg_name = &addresses[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
 
-		if (received < 0)
-			return -1;
+	// Only take what is there already, WaitData() did the waiting
+	int received = recvmmsg(m_handle, msgs, count, MSG_DONTWAIT, nullptr);
+	if (received < 0)
+		return 0;
 
-		u32 address_ip = ntohl(address.sin_addr.s_addr);
-		u16 address_port = ntohs(address.sin_port);
+	for (int i = 0; i < received; i++) {
+		datagrams[i].address = fromSockaddr(addresses[i]);
+		datagrams[i].size = msgs[i].msg_len;
+	}
+	return received;
+#else
+	UDPDatagram &datagram = datagrams[0];
+	int received = Receive(datagram.address, datagram.data.data(),
+			datagram.data.size());
+	if (received < 0)
+		return 0;
+	datagram.size = received;
+	return 1;
+#endif
+}
 
-		sender = Address(address_ip, address_port);
+int UDPSocket::SendMany(const UDPDatagram *datagrams, int count)
+{
+	int failed = 0;
+
+#ifdef HAVE_MMSG
+	if (!INTERNET_SIMULATOR) {
+		struct mmsghdr msgs[MMSG_BATCH_MAX];
+		struct iovec iovecs[MMSG_BATCH_MAX];
+		struct sockaddr_storage addresses[MMSG_BATCH_MAX];
+
+		int next = 0;
+		while (next < count) {
+			// Collect the next datagrams that can be sent at all
+			int n = 0;
+			for (; next < count && n < MMSG_BATCH_MAX; next++) {
+				const UDPDatagram &datagram = datagrams[next];
+				if (datagram.address.getFamily() != m_addr_family) {
+					failed++;
+					continue;
+				}
+				memset(&msgs[n], 0, sizeof(msgs[n]));
+				iovecs[n].iov_base = const_cast<u8 *>(datagram.data.data());
+				iovecs[n].iov_len = datagram.size;
+				msgs[n].msg_hdr.msg_name = &addresses[n];
+				msgs[n].msg_hdr.msg_namelen = toSockaddr(datagram.address, addresses[n]);
+				msgs[n].msg_hdr.msg_iov = &iovecs[n];
+				msgs[n].msg_hdr.msg_iovlen = 1;
+				n++;
+			}
+
+			// sendmmsg() stops at the first datagram that fails
+			int sent = 0;
+			while (sent < n) {
+				int ret = sendmmsg(m_handle, msgs + sent, n - sent, 0);
+				if (ret > 0) {
+					sent += ret;
+				} else {
+					if (ret < 0 && LAST_SOCKET_ERR() == EINTR)
+						continue;
+					failed++;
+					sent++;
+				}
+			}
+		}
+		return failed;
 	}
+#endif
 
-	return received;
+	for (int i = 0; i < count; i++) {
+		try {
+			Send(datagrams[i].address, datagrams[i].data.data(), datagrams[i].size);
+		} catch (SendFailedException &e) {
+			failed++;
+		}
+	}
+	return failed;
 }
 
 void UDPSocket::setTimeoutMs(int timeout_ms)
@@ -6,6 +6,7 @@
 
 #include <ostream>
 #include <cstring>
+#include <vector>
 #include "address.h"
 #include "irrlichttypes.h"
 #include "networkexceptions.h"
@@ -13,6 +14,16 @@
 void sockets_init();
 void sockets_cleanup();
 
+// A datagram for UDPSocket::ReceiveMany() and UDPSocket::SendMany()
+struct UDPDatagram
+{
+	Address address;
+	// When receiving, the size of this is the maximum datagram size
+	std::vector<u8> data;
+	// Bytes of `data` that are used
+	size_t size = 0;
+};
+
 class UDPSocket
 {
 public:
@@ -26,6 +37,16 @@ class UDPSocket
 	void Send(const Address &destination, const void *data, int size);
 	// Returns -1 if there is no data
 	int Receive(Address &sender, void *data, int size);
+
+	/*
+		These handle several datagrams with a single system call where that
+		is supported (recvmmsg/sendmmsg on Linux).
+	*/
+	// Waits like Receive(), then receives as many datagrams as are
+	// available and fit. Returns how many were received.
+	int ReceiveMany(UDPDatagram *datagrams, int count);
+	// Returns the number of datagrams that could not be sent
+	int SendMany(const UDPDatagram *datagrams, int count);
 	void setTimeoutMs(int timeout_ms);
 	// Returns true if there is data, false if timeout occurred
 	bool WaitData(int timeout_ms);
@@ -22,6 +22,7 @@
 #include "nameidmapping.h"
 #include "util/numeric.h"
 #include "util/serialize.h"
+#include "util/stream.h"
 #include "util/string.h"
 #include "exceptions.h"
 #include "debug.h"
@@ -769,6 +770,28 @@ static void fillTileAttribs(ITextureSource *tsrc, TileLayer *layer,
 	}
 }
 
+void ContentFeatures::collectTextureNames(const TextureSettings &tsettings,
+		std::vector<std::string> &names) const
+{
+	// Keep in sync with the tile selection in updateTextures
+	bool noalpha = drawtype == NDT_ALLFACES_OPTIONAL &&
+		tsettings.leaves_style == LEAVES_OPAQUE;
+	bool simple = drawtype == NDT_ALLFACES_OPTIONAL &&
+		tsettings.leaves_style == LEAVES_SIMPLE;
+	for (u32 j = 0; j < 6; j++) {
+		std::string name = tiledef[j].name.empty() ?
+			"no_texture.png" : tiledef[j].name;
+		if (simple && !tiledef_special[j].name.empty())
+			name = tiledef_special[j].name;
+		if (noalpha)
+			name += "^[noalpha";
+		names.push_back(std::move(name));
+		names.push_back(tiledef_overlay[j].name);
+	}
+	for (u32 j = 0; j < CF_SPECIAL_COUNT; j++)
+		names.push_back(tiledef_special[j].name);
+}
+
 static bool isWorldAligned(AlignStyle style, WorldAlignMode mode, NodeDrawType drawtype)
 {
 	if (style == ALIGN_STYLE_WORLD)
@@ -1508,6 +1531,13 @@ void NodeDefManager::updateTextures(IGameDef *gamedef, void *progress_callback_a
 
 	tsrc->setImageCaching(true);
 
+	// Generate the tile images up front so that the work is spread across
+	// threads, instead of happening one by one when the tiles are filled in
+	std::vector<std::string> names;
+	for (const ContentFeatures &f : m_content_features)
+		f.collectTextureNames(tsettings, names);
+	tsrc->prefetchImages(names, true);
+
 	u32 size = m_content_features.size();
 	for (u32 i = 0; i < size; i++) {
 		ContentFeatures *f = &(m_content_features[i]);
@@ -1555,14 +1585,41 @@ void NodeDefManager::deSerialize(std::istream &is, u16 protocol_version)
 		throw SerializationError("unsupported NodeDefinitionManager version");
 
 	u16 count = readU16(is);
-	std::istringstream is2(deSerializeString32(is), std::ios::binary);
+	std::string defs = deSerializeString32(is);
+	deSerializeDefs(defs, count, protocol_version);
+}
+
+void NodeDefManager::deSerialize(std::string_view data, u16 protocol_version)
+{
+	clear();
+
+	StringViewStream is(data);
+	if (readU8(is) < 1)
+		throw SerializationError("unsupported NodeDefinitionManager version");
+
+	u16 count = readU16(is);
+	u32 size = readU32(is);
+	std::string_view defs = is.remaining();
+	if (defs.size() < size)
+		throw SerializationError("NodeDefManager::deSerialize: data ended too early");
+	deSerializeDefs(defs.substr(0, size), count, protocol_version);
+}
+
+void NodeDefManager::deSerializeDefs(std::string_view defs, u16 count,
+		u16 protocol_version)
+{
+	StringViewStream is(defs);
 	ContentFeatures f;
 	for (u16 n = 0; n < count; n++) {
-		u16 i = readU16(is2);
-
-		// Read it from the string wrapper
-		std::string wrapper = deSerializeString16(is2);
-		std::istringstream wrapper_is(wrapper, std::ios::binary);
+		u16 i = readU16(is);
+
+		// Read it from the string wrapper, in place
+		u16 size = readU16(is);
+		std::string_view wrapper = is.remaining().substr(0, size);
+		if (wrapper.size() < size)
+			throw SerializationError("NodeDefManager::deSerialize: data ended too early");
+		is.ignore(size);
+		StringViewStream wrapper_is(wrapper);
 		f.deSerialize(wrapper_is, protocol_version);
 
 		// Check error conditions
@@ -6,6 +6,7 @@
 
 #include "irrlichttypes_bloated.h"
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <memory> // shared_ptr
 #include <map>
@@ -510,6 +511,10 @@ struct ContentFeatures
 #if CHECK_CLIENT_BUILD()
 	void updateTextures(ITextureSource *tsrc, IShaderSource *shdsrc,
 		scene::IMeshManipulator *meshmanip, Client *client, const TextureSettings &tsettings);
+
+	// Appends the names of the textures that updateTextures will use
+	void collectTextureNames(const TextureSettings &tsettings,
+		std::vector<std::string> &names) const;
 #endif
 
 private:
@@ -703,6 +708,13 @@ class NodeDefManager {
 	 */
 	void deSerialize(std::istream &is, u16 protocol_version);
 
+	/*!
+	 * Same as above, but parses the serialized data in place.
+	 * @param data serialized NodeDefManager
+	 * @param protocol_version Active network protocol version
+	 */
+	void deSerialize(std::string_view data, u16 protocol_version);
+
 	/*!
 	 * Used to indicate that node registration has finished.
 	 * @param completed tells whether registration is complete
@@ -738,6 +750,14 @@ class NodeDefManager {
 	 */
 	void clear();
 
+	/*!
+	 * Reads the node definitions that deSerialize() found.
+	 * @param defs the wrapped definitions
+	 * @param count number of definitions in `defs`
+	 * @param protocol_version Active network protocol version
+	 */
+	void deSerializeDefs(std::string_view defs, u16 count, u16 protocol_version);
+
 	/*!
 	 * Allocates a new content ID, and returns it.
 	 * @return the allocated ID or \ref CONTENT_IGNORE if could not allocate
@@ -6,6 +6,7 @@
 
 #include <unordered_set>
 #include <map>
+#include <utility>
 #include "metadata.h"
 
 /*
@@ -86,6 +87,13 @@ class NodeMetadataList
 	// Deletes all
 	void clear();
 
+	// Exchanges the contents with another list
+	void swap(NodeMetadataList &other)
+	{
+		std::swap(m_is_metadata_owner, other.m_is_metadata_owner);
+		m_data.swap(other.m_data);
+	}
+
 	size_t size() const { return m_data.size(); }
 
 	NodeMetadataMap::const_iterator begin()
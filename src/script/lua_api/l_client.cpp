@@ -3,6 +3,7 @@
 // Copyright (C) 2013 celeron55, Perttu Ahola <celeron55@gmail.com>
 // Copyright (C) 2017 nerzhul, Loic Blot <loic.blot@unix-experience.fr>
 
+#include <algorithm>
 #include <iostream>
 
 #include "l_client.h"
@@ -20,6 +21,7 @@
 #include "lua_api/l_nodemeta.h"
 #include "gui/mainmenumanager.h"
 #include "map.h"
+#include "mapblock.h"
 #include "util/string.h"
 #include "nodedef.h"
 #include "l_clientobject.h"
@@ -177,80 +179,97 @@ int ModApiClient::l_get_node_or_nil(lua_State *L)
 	return 1;
 }
 
-int iterator_func(lua_State *L) {
-    std::vector<std::pair<v3s16, MapNode>> *nodes = reinterpret_cast<std::vector<std::pair<v3s16, MapNode>> *>(lua_touserdata(L, lua_upvalueindex(2)));
-
-    // Get the current index from the upvalue
-    int i = luaL_checkinteger(L, lua_upvalueindex(1));
-    if (i >= static_cast<int>(nodes->size())){
-        // If we've passed the end, return nil to signal end of iteration
-        return 0;
-    } else {
-        // Otherwise, increment the upvalue for the next call...
-        lua_pushinteger(L, i + 1);
-        lua_replace(L, lua_upvalueindex(1));
-
-        // ...and return the node at the current index
-        push_v3s16(L, (*nodes)[i].first);
-        pushnode(L, (*nodes)[i].second);
-        return 2;  // number of returned values
-    }
-}
-
 /*
 returns an iterator:
-for pos, node in minetest.all_loaded_nodes() do
+for pos, node in core.all_loaded_nodes() do
 	-- process node at pos
 end
 */
 // all_loaded_nodes()
-int ModApiClient::l_all_loaded_nodes(lua_State *L){
-    if (checkCSMRestrictionFlag(CSM_RF_LOOKUP_NODES)) {
-        return 0;
-    }
+int ModApiClient::l_all_loaded_nodes(lua_State *L)
+{
+	if (checkCSMRestrictionFlag(CSM_RF_LOOKUP_NODES))
+		return 0;
+
+	std::vector<v3s16> blocks;
+	getClient(L)->getEnv().getMap().listAllLoadedBlocks(blocks);
+
+	LuaNodeIterator::create(L, new LuaNodeIterator(std::move(blocks)));
+	return 1;
+}
+
+// find_loaded_nodes(nodenames, [pos1, pos2])
+// nodenames: node name, group or content ID, or a list of them
+int ModApiClient::l_find_loaded_nodes(lua_State *L)
+{
+	if (checkCSMRestrictionFlag(CSM_RF_LOOKUP_NODES))
+		return 0;
+
+	Client *client = getClient(L);
+	const NodeDefManager *ndef = client->ndef();
 
-    Client *client = getClient(L);
-    std::vector<std::pair<v3s16, MapNode>> *nodes = new std::vector<std::pair<v3s16, MapNode>>(client->getAllLoadedNodes());
+	ContentFilter filter;
+	std::vector<content_t> ids;
+	auto collect = [&] (int idx) {
+		if (lua_type(L, idx) == LUA_TNUMBER) {
+			filter.insert(lua_tointeger(L, idx));
+		} else {
+			ids.clear();
+			ndef->getIds(luaL_checkstring(L, idx), ids);
+			for (content_t c : ids)
+				filter.insert(c);
+		}
+	};
+	if (lua_istable(L, 1)) {
+		lua_pushnil(L);
+		while (lua_next(L, 1) != 0) {
+			// key at index -2 and value at index -1
+			collect(lua_gettop(L));
+			lua_pop(L, 1);
+		}
+	} else {
+		collect(1);
+	}
 
-    // We'll store the current index in the first upvalue of the iterator
-    lua_pushinteger(L, 0);
+	std::vector<v3s16> blocks;
+	client->getEnv().getMap().listAllLoadedBlocks(blocks);
 
-    lua_pushlightuserdata(L, nodes);
+	std::optional<VoxelArea> area;
+	if (!lua_isnoneornil(L, 2)) {
+		v3s16 minp = read_v3s16(L, 2);
+		v3s16 maxp = read_v3s16(L, 3);
+		sortBoxVerticies(minp, maxp);
+		area = VoxelArea(minp, maxp);
 
-    // This is the iterator function
-    lua_pushcclosure(L, iterator_func, 2);  // 2 upvalues (the index and nodes)
+		VoxelArea block_area(getNodeBlockPos(minp), getNodeBlockPos(maxp));
+		blocks.erase(std::remove_if(blocks.begin(), blocks.end(),
+			[&] (v3s16 bp) { return !block_area.contains(bp); }), blocks.end());
+	}
 
-    return 1;  // return the iterator function
+	auto *o = new LuaNodeIterator(std::move(blocks));
+	o->m_filter = std::move(filter);
+	o->m_area = area;
+	LuaNodeIterator::create(L, o);
+	return 1;
 }
 
 /*
 returns an iterator:
-for pos, node in minetest.nodes_at_block_pos(block_pos) do
+for pos, node in core.nodes_at_block_pos(block_pos) do
 	-- process node at pos
 end
 */
-// nodes_at_block_pos(pos)
-int ModApiClient::l_nodes_at_block_pos(lua_State *L){
-    if (checkCSMRestrictionFlag(CSM_RF_LOOKUP_NODES)) {
-        return 0;
-    }
-
-    v3s16 pos = read_v3s16(L, 1);
-    Client *client = getClient(L);
-    std::vector<std::pair<v3s16, MapNode>> *nodes = new std::vector<std::pair<v3s16, MapNode>>(client->getNodesAtBlockPos(pos));
-
-    // We'll store the current index in the first upvalue of the iterator
-    lua_pushinteger(L, 0);
-
-    lua_pushlightuserdata(L, nodes);
-
-    // This is the iterator function
-    lua_pushcclosure(L, iterator_func, 2);  // 2 upvalues (the index and nodes)
+// nodes_at_block_pos(blockpos)
+int ModApiClient::l_nodes_at_block_pos(lua_State *L)
+{
+	if (checkCSMRestrictionFlag(CSM_RF_LOOKUP_NODES))
+		return 0;
 
-    return 1;  // return the iterator function
+	v3s16 blockpos = read_v3s16(L, 1);
+	LuaNodeIterator::create(L, new LuaNodeIterator({blockpos}));
+	return 1;
 }
 
-
 // get_langauge()
 int ModApiClient::l_get_language(lua_State *L)
 {
@@ -1104,6 +1123,7 @@ void ModApiClient::Initialize(lua_State *L, int top)
 	API_FCT(get_all_objects);
 	API_FCT(make_screenshot);
 	API_FCT(all_loaded_nodes);
+	API_FCT(find_loaded_nodes);
 	API_FCT(nodes_at_block_pos);
 	API_FCT(can_attack);
 	API_FCT(get_server_url);
@@ -1121,3 +1141,73 @@ void ModApiClient::Initialize(lua_State *L, int top)
 	API_FCT(find_path);
 	API_FCT(load_media);
 }
+
+/*
+	LuaNodeIterator
+*/
+
+// next() -> pos, node
+int LuaNodeIterator::l_next(lua_State *L)
+{
+	LuaNodeIterator *o = checkObject<LuaNodeIterator>(L, 1);
+	Map &map = getClient(L)->getEnv().getMap();
+
+	for (; o->m_block_i < o->m_blocks.size(); o->m_block_i++, o->m_node_i = 0) {
+		const v3s16 blockpos = o->m_blocks[o->m_block_i];
+		const MapBlock *block = map.getBlockNoCreateNoEx(blockpos);
+		if (!block)
+			continue;
+
+		const MapNode *data = block->getData();
+		const v3s16 base = blockpos * MAP_BLOCKSIZE;
+		while (o->m_node_i < MapBlock::nodecount) {
+			const u32 i = o->m_node_i++;
+			const MapNode &n = data[i];
+			if (o->m_filter && !o->m_filter->contains(n.getContent()))
+				continue;
+
+			v3s16 p = base + v3s16(i % MAP_BLOCKSIZE,
+				(i / MapBlock::ystride) % MAP_BLOCKSIZE, i / MapBlock::zstride);
+			if (o->m_area && !o->m_area->contains(p))
+				continue;
+
+			push_v3s16(L, p);
+			pushnode(L, n);
+			return 2;
+		}
+	}
+
+	// Exhausted
+	return 0;
+}
+
+int LuaNodeIterator::gc_object(lua_State *L)
+{
+	LuaNodeIterator *o = *(LuaNodeIterator **)(lua_touserdata(L, 1));
+	delete o;
+	return 0;
+}
+
+void LuaNodeIterator::create(lua_State *L, LuaNodeIterator *o)
+{
+	*(void **)(lua_newuserdata(L, sizeof(void *))) = o;
+	luaL_getmetatable(L, className);
+	lua_setmetatable(L, -2);
+}
+
+void LuaNodeIterator::Register(lua_State *L)
+{
+	static const luaL_Reg metamethods[] = {
+		{"__call", l_next},
+		{"__gc", gc_object},
+		{0, 0}
+	};
+	registerClass<LuaNodeIterator>(L, methods, metamethods);
+}
+
+const char LuaNodeIterator::className[] = "NodeIterator";
+const luaL_Reg LuaNodeIterator::methods[] =
+{
+	luamethod(LuaNodeIterator, next),
+	{ 0, 0 }
+};
@@ -8,6 +8,9 @@
 #include "lua_api/l_base.h"
 #include "itemdef.h"
 #include "tool.h"
+#include "voxel.h"
+#include "client/meshgen/content_filter.h"
+#include <optional>
 
 class ModApiClient : public ModApiBase
 {
@@ -120,7 +123,10 @@ class ModApiClient : public ModApiBase
 	// all_loaded_nodes()
 	static int l_all_loaded_nodes(lua_State *L);
 
-	// nodes_at(pos)
+	// find_loaded_nodes(nodenames, [pos1, pos2])
+	static int l_find_loaded_nodes(lua_State *L);
+
+	// nodes_at_block_pos(blockpos)
 	static int l_nodes_at_block_pos(lua_State *L);
 
 	// file_write(path, content)
@@ -163,3 +169,42 @@ class ModApiClient : public ModApiBase
 public:
 	static void Initialize(lua_State *L, int top);
 };
+
+/*
+	Cursor over the nodes of loaded map blocks. Only the list of block
+	positions is captured on creation; node data is read straight from
+	each MapBlock as the cursor advances, so blocks unloaded in the
+	meantime are skipped.
+*/
+class LuaNodeIterator : public ModApiBase
+{
+private:
+	static const luaL_Reg methods[];
+
+	std::vector<v3s16> m_blocks;
+	size_t m_block_i = 0;
+	u32 m_node_i = 0;
+
+	// Only nodes contained in the filter are returned, if set
+	std::optional<ContentFilter> m_filter;
+	// Only nodes inside of this area are returned, if set
+	std::optional<VoxelArea> m_area;
+
+	// garbage collector
+	static int gc_object(lua_State *L);
+
+	// next() -> pos, node
+	static int l_next(lua_State *L);
+
+public:
+	LuaNodeIterator(std::vector<v3s16> &&blocks) : m_blocks(std::move(blocks)) {}
+
+	//! Pushes the iterator on top of the stack and takes ownership of it.
+	static void create(lua_State *L, LuaNodeIterator *o);
+
+	static void Register(lua_State *L);
+
+	static const char className[];
+
+	friend class ModApiClient;
+};
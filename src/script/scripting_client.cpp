@@ -69,6 +69,7 @@ void ClientScripting::InitializeModApi(lua_State *L, int top)
 	ClientObjectRef::Register(L);
 	ClientSoundHandle::Register(L);
 	LuaInventoryAction::Register(L);
+	LuaNodeIterator::Register(L);
 
 	ModApiClient::Initialize(L, top);
 	ModApiUtil::InitializeClient(L, top);
@@ -8,6 +8,7 @@
 
 #include <zlib.h>
 #include <zstd.h>
+#include <algorithm>
 #include <memory>
 
 /* report a zlib or i/o error */
@@ -272,6 +273,45 @@ void decompressZstd(std::istream &is, std::ostream &os)
 	}
 }
 
+size_t decompressZstd(std::string_view data, std::string &out)
+{
+	thread_local std::unique_ptr<ZSTD_DStream, ZSTD_Deleter> stream(ZSTD_createDStream());
+
+	ZSTD_initDStream(stream.get());
+
+	const size_t bufsize = 16384;
+	// decompress straight into the string, growing it as needed
+	size_t out_pos = out.size();
+
+	ZSTD_inBuffer input = { data.data(), data.size(), 0 };
+	size_t ret;
+	do
+	{
+		if (out.size() - out_pos < bufsize) {
+			// use up reserved space first, then grow exponentially
+			out.resize(std::max(out.capacity(), out_pos + std::max(bufsize, out_pos)));
+		}
+
+		ZSTD_outBuffer output = { &out[0], out.size(), out_pos };
+		ret = ZSTD_decompressStream(stream.get(), &output, &input);
+		if (ZSTD_isError(ret)) {
+			out.resize(out_pos);
+			dstream << ZSTD_getErrorName(ret) << std::endl;
+			throw SerializationError("decompressZstd: failed");
+		}
+		// Output space left over means zstd is waiting for more input
+		bool stalled = output.pos < output.size && input.pos == input.size;
+		out_pos = output.pos;
+		if (ret != 0 && stalled) {
+			out.resize(out_pos);
+			throw SerializationError("decompressZstd: data ended too early");
+		}
+	} while (ret != 0);
+
+	out.resize(out_pos);
+	return input.pos;
+}
+
 void compress(const u8 *data, u32 size, std::ostream &os, u8 version, int level)
 {
 	if(version >= 29)
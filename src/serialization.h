@@ -7,6 +7,7 @@
 #include "irrlichttypes.h"
 #include "exceptions.h"
 #include <iostream>
+#include <string>
 #include <string_view>
 
 /*
@@ -91,6 +92,9 @@ inline void compressZstd(std::string_view data, std::ostream &os, int level = 0)
 	compressZstd(reinterpret_cast<const u8*>(data.data()), data.size(), os, level);
 }
 void decompressZstd(std::istream &is, std::ostream &os);
+// Decompresses one frame from memory, appending to `out`.
+// Returns the number of bytes of `data` that belonged to the frame.
+size_t decompressZstd(std::string_view data, std::string &out);
 
 // These choose between zstd, zlib and a self-made one according to version
 void compress(const u8 *data, u32 size, std::ostream &os, u8 version, int level = -1);
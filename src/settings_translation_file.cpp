@@ -302,6 +302,8 @@ fake_function() {
 	gettext("Connects glass if supported by node.");
 	gettext("Smooth lighting");
 	gettext("Enable smooth lighting with simple ambient occlusion.");
+	gettext("Merge node faces");
+	gettext("Merge adjacent faces of full nodes that look the same into larger quads.\nThis greatly reduces the number of vertices of flat terrain.\nWith smooth lighting, only faces that are lit evenly are merged.");
 	gettext("Tradeoffs for performance");
 	gettext("Enables tradeoffs that reduce CPU load or increase rendering performance\nat the expense of minor visual glitches that do not impact game playability.");
 	gettext("Waving Nodes");
@@ -986,6 +988,8 @@ fake_function() {
 	gettext("Enables debug and error-checking in the OpenGL driver.");
 	gettext("Shader path");
 	gettext("Path to shader directory. If no path is defined, default location will be used.");
+	gettext("Cache compiled shaders");
+	gettext("Keep compiled shaders on disk, so that they don't need to be compiled\nagain on the next start. Has no effect if the driver doesn't support it.");
 	gettext("Video driver");
 	gettext("The rendering back-end.\nNote: A restart is required after changing this!\nOpenGL is the default for desktop, and OGLES2 for Android.");
 	gettext("Transparency Sorting Distance");
@@ -1000,6 +1004,8 @@ fake_function() {
 	gettext("Number of threads to use for mesh generation.\nValue of 0 (default) will let Luanti autodetect the number of available threads.");
 	gettext("Minimum vertex count for mesh buffers");
 	gettext("All mesh buffers with less than this number of vertices will be merged\nduring map rendering. This improves rendering performance.");
+	gettext("Compact map block meshes");
+	gettext("Store map block meshes with 16-bit positions and texture coordinates.\nThis almost halves the memory and bandwidth used by map meshes.\nHas no effect if \"client_mesh_chunk\" is larger than 7.");
 	gettext("Minimap scan height");
 	gettext("True = 256\nFalse = 128\nUsable to make minimap smoother on slower machines.");
 	gettext("World-aligned textures mode");
@@ -1008,6 +1014,10 @@ fake_function() {
 	gettext("World-aligned textures may be scaled to span several nodes. However,\nthe server may not send the scale you want, especially if you use\na specially-designed texture pack; with this option, the client tries\nto determine the scale automatically based on the texture size.\nSee also texture_min_size.\nWarning: This option is EXPERIMENTAL!");
 	gettext("Base texture size");
 	gettext("When using bilinear/trilinear filtering, low-resolution textures\ncan be blurred, so this option automatically upscales them to preserve\ncrisp pixels. This defines the minimum texture size for the upscaled textures;\nhigher values look sharper, but require more memory.\nThis setting is ONLY applied if any of the mentioned filters are enabled.\nThis is also used as the base node texture size for world-aligned\ntexture autoscaling.");
+	gettext("Cache generated textures");
+	gettext("Keep textures that are composed from several images on disk, so that\njoining the same server again does not need to generate them again.\nUses some disk space in the cache directory.");
+	gettext("Generated texture cache size");
+	gettext("Size limit of the generated texture cache, in MiB.\nThe textures that were used least recently are removed beyond it.");
 	gettext("Client Mesh Chunksize");
 	gettext("Side length of a cube of map blocks that the client will consider together\nwhen generating meshes.\nLarger values increase the utilization of the GPU by reducing the number of\ndraw calls, benefiting especially high-end GPUs.\nSystems with a low-end GPU (or no GPU) would benefit from smaller values.");
 	gettext("Color depth for post-processing texture");
@@ -1180,6 +1190,8 @@ fake_function() {
 	gettext("Compression level to use when saving mapblocks to disk.\n-1 - use default compression level\n0 - least compression, fastest\n9 - best compression, slowest");
 	gettext("Connect to external media server");
 	gettext("Enable usage of remote media server (if provided by server).\nRemote servers offer a significantly faster way to download media (e.g. textures)\nwhen connecting to the server.");
+	gettext("Trust media cache index");
+	gettext("Remember size and modification time of media cache files whose checksum\nwas verified, and skip checking them again while these stay the same.\nMakes rejoining servers with a lot of media faster.");
 	gettext("Serverlist file");
 	gettext("File in client/serverlist/ that contains your favorite servers displayed in the\nMultiplayer Tab.");
 	gettext("Gamepads");
@@ -0,0 +1,93 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "thread_pool.h"
+#include "threading/thread.h"
+
+class ThreadPool::Worker : public Thread
+{
+public:
+	Worker(ThreadPool *pool, const std::string &name) :
+		Thread(name), m_pool(pool)
+	{}
+
+private:
+	void *run() override
+	{
+		m_pool->workerLoop();
+		return nullptr;
+	}
+
+	ThreadPool *m_pool;
+};
+
+ThreadPool::ThreadPool(unsigned int num_workers, const std::string &name)
+{
+	for (unsigned int i = 0; i < num_workers; i++) {
+		m_workers.push_back(std::make_unique<Worker>(this, name));
+		m_workers.back()->start();
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_job_cv.notify_all();
+	for (auto &worker : m_workers)
+		worker->wait();
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)> &f)
+{
+	if (m_workers.empty() || count <= 1) {
+		for (size_t i = 0; i < count; i++)
+			f(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job = &f;
+		m_count = count;
+		m_next.store(0, std::memory_order_relaxed);
+		m_busy = m_workers.size();
+		m_job_id++;
+	}
+	m_job_cv.notify_all();
+
+	process(f);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done_cv.wait(lock, [this] { return m_busy == 0; });
+	m_job = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+	u32 last_job_id = 0;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_job_cv.wait(lock, [&] { return m_stop || m_job_id != last_job_id; });
+		if (m_stop)
+			return;
+		last_job_id = m_job_id;
+		const auto *job = m_job;
+
+		lock.unlock();
+		process(*job);
+		lock.lock();
+
+		if (--m_busy == 0)
+			m_done_cv.notify_one();
+	}
+}
+
+void ThreadPool::process(const std::function<void(size_t)> &f)
+{
+	size_t i;
+	while ((i = m_next.fetch_add(1, std::memory_order_relaxed)) < m_count)
+		f(i);
+}
@@ -0,0 +1,65 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "irrlichttypes.h"
+#include "util/basic_macros.h"
+
+class Thread;
+
+/*
+	A fixed set of worker threads that run the iterations of a loop in
+	parallel, for splitting up work that the main thread has to wait for
+	anyway (e.g. building the draw list).
+
+	The calling thread takes part in the work, so a pool without workers
+	simply runs the loop in place.
+*/
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned int num_workers, const std::string &name);
+	~ThreadPool();
+
+	DISABLE_CLASS_COPY(ThreadPool);
+
+	// Number of threads that can run a job, including the calling thread
+	size_t getConcurrency() const { return m_workers.size() + 1; }
+
+	/*
+		Calls f(i) once for each i in [0, count) and returns when all calls
+		have finished. Calls happen concurrently and in no particular order.
+		f must not throw. Only one thread may call this at a time.
+	*/
+	void run(size_t count, const std::function<void(size_t)> &f);
+
+private:
+	class Worker;
+
+	void workerLoop();
+	void process(const std::function<void(size_t)> &f);
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+
+	std::mutex m_mutex;
+	std::condition_variable m_job_cv;
+	std::condition_variable m_done_cv;
+	// Current job, guarded by m_mutex
+	const std::function<void(size_t)> *m_job = nullptr;
+	// Incremented for each job so that workers don't run one twice
+	u32 m_job_id = 0;
+	// Workers that did not finish the current job yet
+	size_t m_busy = 0;
+	bool m_stop = false;
+
+	size_t m_count = 0;
+	std::atomic<size_t> m_next {0};
+};
@@ -0,0 +1,101 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "test.h"
+
+#include <sstream>
+#include "client/block_decoder.h"
+#include "mapblock.h"
+#include "serialization.h"
+
+class TestBlockDecoder : public TestBase
+{
+public:
+	TestBlockDecoder() { TestManager::registerTestModule(this); }
+	const char *getName() override { return "TestBlockDecoder"; }
+
+	void runTests(IGameDef *gamedef) override;
+
+	void testInline(IGameDef *gamedef);
+	void testThreaded(IGameDef *gamedef);
+	void testInvalid(IGameDef *gamedef);
+};
+
+static TestBlockDecoder g_test_instance;
+
+void TestBlockDecoder::runTests(IGameDef *gamedef)
+{
+	TEST(testInline, gamedef);
+	TEST(testThreaded, gamedef);
+	TEST(testInvalid, gamedef);
+}
+
+// Block payload as sent in TOCLIENT_BLOCKDATA, filled with `content`
+static std::string make_payload(IGameDef *gamedef, content_t content)
+{
+	MapBlock block({}, gamedef);
+	for (u32 i = 0; i < MapBlock::nodecount; i++)
+		block.getData()[i] = MapNode(content);
+
+	std::ostringstream os(std::ios_base::binary);
+	block.serialize(os, SER_FMT_VER_HIGHEST_WRITE, false, -1);
+	block.serializeNetworkSpecific(os);
+	return os.str();
+}
+
+void TestBlockDecoder::testInline(IGameDef *gamedef)
+{
+	// Not started, so this decodes in place
+	BlockDecoder decoder(gamedef, 2);
+	decoder.push(v3s16(1, 2, 3), make_payload(gamedef, CONTENT_AIR),
+			SER_FMT_VER_HIGHEST_WRITE);
+	UASSERTEQ(size_t, decoder.size(), 1);
+
+	DecodedBlock result;
+	UASSERT(decoder.pop(result, false));
+	UASSERT(result.pos == v3s16(1, 2, 3));
+	UASSERT(result.block);
+	UASSERT(result.block->getPos() == v3s16(1, 2, 3));
+	UASSERTEQ(content_t, result.block->getNodeNoCheck(0, 0, 0).getContent(), CONTENT_AIR);
+	UASSERT(!decoder.pop(result, false));
+}
+
+void TestBlockDecoder::testThreaded(IGameDef *gamedef)
+{
+	BlockDecoder decoder(gamedef, 3);
+	decoder.start();
+
+	// Results come out in queue order, even for the same position
+	const std::string air = make_payload(gamedef, CONTENT_AIR);
+	const std::string ignore = make_payload(gamedef, CONTENT_IGNORE);
+	for (s16 i = 0; i < 20; i++) {
+		std::string data = i % 2 ? air : ignore;
+		decoder.push(v3s16(0, i / 2, 0), std::move(data), SER_FMT_VER_HIGHEST_WRITE);
+	}
+
+	DecodedBlock result;
+	for (s16 i = 0; i < 20; i++) {
+		UASSERT(decoder.pop(result, true));
+		UASSERT(result.block);
+		UASSERT(result.pos == v3s16(0, i / 2, 0));
+		UASSERTEQ(content_t, result.block->getNodeNoCheck(5, 5, 5).getContent(),
+				i % 2 ? CONTENT_AIR : CONTENT_IGNORE);
+	}
+	UASSERTEQ(size_t, decoder.size(), 0);
+	UASSERT(!decoder.pop(result, true));
+}
+
+void TestBlockDecoder::testInvalid(IGameDef *gamedef)
+{
+	BlockDecoder decoder(gamedef, 1);
+	decoder.start();
+
+	std::string data = make_payload(gamedef, CONTENT_AIR);
+	data.resize(data.size() / 2);
+	decoder.push(v3s16(), std::move(data), SER_FMT_VER_HIGHEST_WRITE);
+
+	DecodedBlock result;
+	UASSERT(decoder.pop(result, true));
+	UASSERT(!result.block);
+	UASSERT(!result.error.empty());
+}
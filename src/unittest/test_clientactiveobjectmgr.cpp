@@ -47,6 +47,7 @@ class TestClientActiveObjectMgr : public TestBase
 	void runTests(IGameDef *gamedef);
 
 	void testGetActiveSelectableObjects();
+	void testGetActiveObjects();
 };
 
 static TestClientActiveObjectMgr g_test_instance;
@@ -54,6 +55,7 @@ static TestClientActiveObjectMgr g_test_instance;
 void TestClientActiveObjectMgr::runTests(IGameDef *gamedef)
 {
 	TEST(testGetActiveSelectableObjects)
+	TEST(testGetActiveObjects)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -146,6 +148,8 @@ void TestClientActiveObjectMgr::testGetActiveSelectableObjects()
 
 	float x = 12, y = 3, z = 6;
 	obj->position = {x, y, z};
+	// Picks up the new position
+	caomgr.step(0.0f, [] (ClientActiveObject *) {});
 
 	assert_obj_selected({0, 0, 0}, {x-1, y-1, z-1});
 	assert_obj_selected({0, 0, 0}, {2*(x-1), 2*(y-1), 2*(z-1)});
@@ -171,3 +175,49 @@ void TestClientActiveObjectMgr::testGetActiveSelectableObjects()
 
 	caomgr.clear();
 }
+
+void TestClientActiveObjectMgr::testGetActiveObjects()
+{
+	client::ActiveObjectMgr caomgr;
+	std::vector<TestSelectableClientActiveObject *> objs;
+	for (int i = 0; i < 10; i++) {
+		auto obj_u = std::make_unique<TestSelectableClientActiveObject>(
+				aabb3f{v3f{-1, -1, -1}, v3f{1, 1, 1}});
+		obj_u->position = v3f(i * 10.0f, 0, 0);
+		objs.push_back(obj_u.get());
+		UASSERT(caomgr.registerObject(std::move(obj_u)));
+	}
+
+	auto in_radius = [&] (v3f pos, f32 radius) {
+		std::vector<DistanceSortedActiveObject> result;
+		caomgr.getActiveObjects(pos, radius, result);
+		std::vector<ClientActiveObject *> ret;
+		for (auto &it : result)
+			ret.push_back(it.obj);
+		return ret;
+	};
+	auto in_area = [&] (v3f min, v3f max) {
+		std::vector<ClientActiveObject *> result;
+		caomgr.getActiveObjectsInArea(aabb3f(min, max), result);
+		return result;
+	};
+	// Results are ordered by ID, i.e. by registration order here
+	using List = std::vector<ClientActiveObject *>;
+
+	UASSERT((in_radius({0, 0, 0}, 15) == List{objs[0], objs[1]}));
+	UASSERT((in_radius({45, 5, 0}, 7.1f) == List{objs[4], objs[5]}));
+	UASSERT((in_area({35, -1, -1}, {60, 1, 1}) == List{objs[4], objs[5], objs[6]}));
+
+	// Moved objects are found at their new position after a step
+	objs[0]->position = v3f(200, 0, 0);
+	objs[9]->position = v3f(-5, 0, 0);
+	caomgr.step(0.0f, [] (ClientActiveObject *) {});
+	UASSERT((in_radius({0, 0, 0}, 15) == List{objs[1], objs[9]}));
+	UASSERT((in_area({150, -1, -1}, {250, 1, 1}) == List{objs[0]}));
+
+	// Removed objects are gone from the index
+	caomgr.removeObject(objs[1]->getId());
+	UASSERT((in_radius({0, 0, 0}, 15) == List{objs[9]}));
+
+	caomgr.clear();
+}
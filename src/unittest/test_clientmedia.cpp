@@ -0,0 +1,131 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "test.h"
+
+#include "client/clientmedia.h"
+#include "filesys.h"
+#include "util/serialize.h"
+
+class TestClientMedia : public TestBase
+{
+public:
+	TestClientMedia() { TestManager::registerTestModule(this); }
+	const char *getName() override { return "TestClientMedia"; }
+
+	void runTests(IGameDef *gamedef) override;
+
+	void testIndexRoundTrip();
+	void testIndexMismatch();
+	void testIndexForget();
+	void testIndexInvalid();
+
+private:
+	std::string m_path;
+};
+
+static TestClientMedia g_test_instance;
+
+static const std::string SHA1_A(20, 'a');
+static const std::string SHA1_B(20, 'b');
+
+void TestClientMedia::runTests(IGameDef *gamedef)
+{
+	m_path = getTestTempFile();
+
+	TEST(testIndexRoundTrip);
+	TEST(testIndexMismatch);
+	TEST(testIndexForget);
+	TEST(testIndexInvalid);
+
+	fs::DeleteSingleFileOrEmptyDirectory(m_path);
+}
+
+void TestClientMedia::testIndexRoundTrip()
+{
+	fs::DeleteSingleFileOrEmptyDirectory(m_path);
+	MediaCacheIndex index(m_path);
+	UASSERT(!index.load());
+	UASSERT(!index.isVerified(SHA1_A, 5, 100));
+
+	index.setVerified(SHA1_A, 5, 100);
+	index.setVerified(SHA1_B, 1ULL << 40, 1700000000123456789ULL);
+	UASSERT(index.save());
+
+	MediaCacheIndex loaded(m_path);
+	UASSERT(loaded.load());
+	UASSERT(loaded.isVerified(SHA1_A, 5, 100));
+	UASSERT(loaded.isVerified(SHA1_B, 1ULL << 40, 1700000000123456789ULL));
+}
+
+void TestClientMedia::testIndexMismatch()
+{
+	MediaCacheIndex index(m_path);
+	index.setVerified(SHA1_A, 5, 100);
+
+	// Any change of the file means it has to be hashed again
+	UASSERT(!index.isVerified(SHA1_A, 6, 100));
+	UASSERT(!index.isVerified(SHA1_A, 5, 101));
+	UASSERT(!index.isVerified(SHA1_B, 5, 100));
+
+	index.setVerified(SHA1_A, 6, 101);
+	UASSERT(index.isVerified(SHA1_A, 6, 101));
+	UASSERT(!index.isVerified(SHA1_A, 5, 100));
+}
+
+void TestClientMedia::testIndexForget()
+{
+	{
+		MediaCacheIndex index(m_path);
+		index.setVerified(SHA1_A, 5, 100);
+		index.setVerified(SHA1_B, 7, 200);
+		UASSERT(index.save());
+	}
+
+	MediaCacheIndex index(m_path);
+	UASSERT(index.load());
+	index.forget(SHA1_A);
+	UASSERT(!index.isVerified(SHA1_A, 5, 100));
+	UASSERT(index.save());
+
+	MediaCacheIndex loaded(m_path);
+	UASSERT(loaded.load());
+	UASSERT(!loaded.isVerified(SHA1_A, 5, 100));
+	UASSERT(loaded.isVerified(SHA1_B, 7, 200));
+}
+
+void TestClientMedia::testIndexInvalid()
+{
+	{
+		MediaCacheIndex index(m_path);
+		index.setVerified(SHA1_A, 5, 100);
+		UASSERT(index.save());
+	}
+	std::string data;
+	UASSERT(fs::ReadFile(m_path, data));
+
+	// Truncated
+	UASSERT(fs::safeWriteToFile(m_path, data.substr(0, data.size() - 1)));
+	MediaCacheIndex truncated(m_path);
+	UASSERT(!truncated.load());
+	UASSERT(!truncated.isVerified(SHA1_A, 5, 100));
+
+	// Wrong signature
+	std::string broken = data;
+	broken[0] ^= 0xff;
+	UASSERT(fs::safeWriteToFile(m_path, broken));
+	UASSERT(!MediaCacheIndex(m_path).load());
+
+	// Other version, e.g. with modification times in other units
+	std::string other = data;
+	writeU16((u8 *)&other[4], readU16((const u8 *)&other[4]) - 1);
+	UASSERT(fs::safeWriteToFile(m_path, other));
+	MediaCacheIndex old_version(m_path);
+	UASSERT(!old_version.load());
+	UASSERT(!old_version.isVerified(SHA1_A, 5, 100));
+
+	UASSERT(fs::safeWriteToFile(m_path, data));
+	MediaCacheIndex index(m_path);
+	UASSERT(index.load());
+	UASSERT(index.isVerified(SHA1_A, 5, 100));
+}
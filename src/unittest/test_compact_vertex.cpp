@@ -0,0 +1,119 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "test.h"
+
+#include "client/meshgen/compact_vertex.h"
+
+class TestCompactVertex : public TestBase
+{
+public:
+	TestCompactVertex() { TestManager::registerTestModule(this); }
+	const char *getName() override { return "TestCompactVertex"; }
+
+	void runTests(IGameDef *gamedef) override;
+
+	void testSupports();
+	void testRoundTrip();
+	void testLargeTCoords();
+	void testClamping();
+	void testTranslationSteps();
+};
+
+static TestCompactVertex g_test_instance;
+
+void TestCompactVertex::runTests(IGameDef *gamedef)
+{
+	TEST(testSupports);
+	TEST(testRoundTrip);
+	TEST(testLargeTCoords);
+	TEST(testClamping);
+	TEST(testTranslationSteps);
+}
+
+void TestCompactVertex::testSupports()
+{
+	UASSERT(CompactVertexFormat::supports(MeshGrid{1}));
+	UASSERT(CompactVertexFormat::supports(MeshGrid{7}));
+	// Texture coordinates would get too coarse
+	UASSERT(!CompactVertexFormat::supports(MeshGrid{8}));
+	UASSERT(!CompactVertexFormat::supports(MeshGrid{16}));
+}
+
+void TestCompactVertex::testRoundTrip()
+{
+	for (u16 cell_size : {1, 4}) {
+		CompactVertexFormat format(MeshGrid{cell_size});
+		const f32 extent = cell_size * MAP_BLOCKSIZE * BS;
+
+		// Node corners and the cell boundaries are exact
+		for (f32 pos : {-0.5f * BS, 0.0f, 2.5f * BS, extent - 0.5f * BS}) {
+			video::S3DVertex v(v3f(pos, pos, extent - BS - pos), v3f(0, 1, 0),
+					video::SColor(0x80ff4020), v2f(0.25f, 1.0f));
+			video::S3DVertex out = format.unpack(format.pack(v));
+			UASSERT(out.Pos == v.Pos);
+			UASSERT(out.Normal == v.Normal);
+			UASSERT(out.Color == v.Color);
+			UASSERT(out.TCoords == v.TCoords);
+		}
+
+		// Anything else is off by at most half a step
+		video::S3DVertex v(v3f(1.234f, 56.789f, -3.21f), v3f(0.6f, -0.8f, 0),
+				video::SColor(0xffffffff), v2f(0.3f, 0.7f));
+		video::S3DVertex out = format.unpack(format.pack(v));
+		UASSERT(out.Pos.getDistanceFrom(v.Pos) <= format.getPosStep());
+		UASSERT(out.Normal.getDistanceFrom(v.Normal) <= 0.02f);
+		UASSERT(out.TCoords.getDistanceFrom(v.TCoords) <= format.getTCoordStep());
+	}
+}
+
+void TestCompactVertex::testLargeTCoords()
+{
+	// Full precision for single blocks
+	UASSERT(CompactVertexFormat(MeshGrid{1}).getTCoordStep() == 1.0f / 1024);
+
+	for (u16 cell_size : {1, 2, 3, 7}) {
+		CompactVertexFormat format(MeshGrid{cell_size});
+		UASSERT(format.getTCoordStep() <= 1.0f / CompactVertexFormat::MIN_TCOORD_STEPS);
+
+		// Cuboid faces at the far end of the cell, see generateCuboidTextureCoords()
+		const f32 far = cell_size * MAP_BLOCKSIZE + 1.5f;
+		for (v2f tcoords : {v2f(far, 1 - far), v2f(1 - far, far), v2f(far - 0.25f, -0.75f)}) {
+			video::S3DVertex v(v3f(), v3f(0, 1, 0), video::SColor(), tcoords);
+			UASSERT(format.unpack(format.pack(v)).TCoords == tcoords);
+		}
+	}
+}
+
+void TestCompactVertex::testClamping()
+{
+	CompactVertexFormat format(MeshGrid{1});
+
+	video::S3DVertex v(v3f(1e6f, -1e6f, 0), v3f(), video::SColor(), v2f(1e6f, -1e6f));
+	video::S3DVertexCompact packed = format.pack(v);
+	UASSERTEQ(s16, packed.Pos[0], S16_MAX);
+	UASSERTEQ(s16, packed.Pos[1], -S16_MAX);
+	UASSERTEQ(s16, packed.TCoords[0], S16_MAX);
+	UASSERTEQ(s16, packed.TCoords[1], -S16_MAX);
+}
+
+void TestCompactVertex::testTranslationSteps()
+{
+	CompactVertexFormat format(MeshGrid{2});
+	const f32 block = MAP_BLOCKSIZE * BS;
+
+	v3s32 steps;
+	UASSERT(format.getTranslationSteps(v3f(block, -block, 0), steps));
+	const s32 block_steps = MAP_BLOCKSIZE * CompactVertexFormat::POS_STEPS_PER_NODE;
+	UASSERT(steps == v3s32(block_steps, -block_steps, 0));
+
+	// A translated vertex ends up where the translation says
+	video::S3DVertex v(v3f(3 * BS, 7 * BS, 0), v3f(), video::SColor(), v2f());
+	video::S3DVertexCompact packed = format.pack(v);
+	for (int i = 0; i < 3; i++)
+		packed.Pos[i] += steps[i];
+	UASSERT(format.unpack(packed).Pos == v.Pos + v3f(block, -block, 0));
+
+	// Too far away to share a buffer
+	UASSERT(!format.getTranslationSteps(v3f(8 * block, 0, 0), steps));
+}
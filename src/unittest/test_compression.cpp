@@ -10,6 +10,7 @@
 #include "serialization.h"
 #include "nodedef.h"
 #include "noise.h"
+#include "util/stream.h"
 
 class TestCompression : public TestBase {
 public:
@@ -22,6 +23,7 @@ class TestCompression : public TestBase {
 	void testZlibCompression();
 	void testZlibLargeData();
 	void testZstdLargeData();
+	void testZstdFromMemory();
 	void testZlibLimit();
 	void _testZlibLimit(u32 size, u32 limit);
 };
@@ -34,6 +36,7 @@ void TestCompression::runTests(IGameDef *gamedef)
 	TEST(testZlibCompression);
 	TEST(testZlibLargeData);
 	TEST(testZstdLargeData);
+	TEST(testZstdFromMemory);
 	TEST(testZlibLimit);
 }
 
@@ -196,6 +199,38 @@ void TestCompression::testZstdLargeData()
 	}
 }
 
+void TestCompression::testZstdFromMemory()
+{
+	std::string data_in(100000, '\0');
+	PseudoRandom pseudorandom(1234);
+	for (char &c : data_in)
+		c = pseudorandom.range('a', 'd');
+
+	std::ostringstream os_compressed(std::ios::binary);
+	compressZstd(data_in, os_compressed);
+	std::string compressed = os_compressed.str();
+	const size_t frame_size = compressed.size();
+	compressed.append("trailing");
+
+	// Appends to the output and leaves the trailing data alone
+	std::string out = "prefix";
+	UASSERTEQ(size_t, decompressZstd(compressed, out), frame_size);
+	UASSERT(out == "prefix" + data_in);
+
+	StringViewStream is(compressed);
+	is.ignore(frame_size);
+	UASSERT(is.remaining() == "trailing");
+	std::string trailing;
+	is >> trailing;
+	UASSERT(trailing == "trailing");
+
+	// Cut off data
+	std::string_view cut(compressed.data(), frame_size / 2);
+	out.clear();
+	EXCEPTION_CHECK(SerializationError, decompressZstd(cut, out));
+	EXCEPTION_CHECK(SerializationError, decompressZstd(std::string_view(), out));
+}
+
 void TestCompression::testZlibLimit()
 {
 	// edge cases
@@ -26,7 +26,10 @@ class TestConnection : public TestBase {
 	void runTests(IGameDef *gamedef);
 
 	void testNetworkPacketSerialize();
+	void testNetworkPacketViews();
 	void testHelpers();
+	void testReliablePacketBuffer();
+	void testIncomingSplitBuffer();
 	void testConnectSendReceive();
 };
 
@@ -35,7 +38,10 @@ static TestConnection g_test_instance;
 void TestConnection::runTests(IGameDef *gamedef)
 {
 	TEST(testNetworkPacketSerialize);
+	TEST(testNetworkPacketViews);
 	TEST(testHelpers);
+	TEST(testReliablePacketBuffer);
+	TEST(testIncomingSplitBuffer);
 	TEST(testConnectSendReceive);
 }
 
@@ -99,6 +105,35 @@ void TestConnection::testNetworkPacketSerialize()
 	}
 }
 
+void TestConnection::testNetworkPacketViews()
+{
+	NetworkPacket pkt(123, 0);
+	pkt.putLongString("hello");
+	pkt << (u16)42;
+	pkt.putLongString("");
+	pkt.putRawString("rest");
+
+	NetworkPacket rx;
+	auto buf = pkt.oldForgePacket();
+	rx.putRawPacket(&buf[0], buf.getSize(), 0);
+
+	std::string_view s = rx.readLongStringView();
+	UASSERT(s == "hello");
+	// Points into the packet instead of a copy
+	UASSERT(s.data() == rx.getString(4));
+
+	u16 n;
+	rx >> n;
+	UASSERTEQ(u16, n, 42);
+	UASSERT(rx.readLongStringView().empty());
+	UASSERT(rx.getRemainingStringView() == "rest");
+	UASSERT(rx.getStringView(rx.getSize()).empty());
+
+	rx.skip(4);
+	EXCEPTION_CHECK(PacketError, rx.readLongStringView());
+	EXCEPTION_CHECK(PacketError, rx.getStringView(rx.getSize() + 1));
+}
+
 void TestConnection::testHelpers()
 {
 	// Some constants for testing
@@ -143,6 +178,119 @@ void TestConnection::testHelpers()
 }
 
 
+static con::BufferedPacketPtr make_reliable(u16 seqnum, u8 value = 0)
+{
+	SharedBuffer<u8> data(1);
+	data[0] = value;
+	return con::makePacket(Address(127,0,0,1, 10),
+			con::makeReliablePacket(data, seqnum), 0x12345678, 123, 0);
+}
+
+void TestConnection::testReliablePacketBuffer()
+{
+	con::ReliablePacketBuffer buf;
+	u16 seqnum;
+	UASSERT(buf.empty());
+	UASSERT(!buf.getFirstSeqnum(seqnum));
+	EXCEPTION_CHECK(con::NotFoundException, buf.popFirst());
+
+	// Out of order, across the wraparound of the seqnum
+	const u16 next_expected = 65530;
+	for (u16 s : {3, 65533, 65535, 0, 65531, 200}) {
+		auto p = make_reliable(s);
+		buf.insert(p, next_expected);
+	}
+	UASSERTEQ(u32, buf.size(), 6);
+	UASSERT(buf.getFirstSeqnum(seqnum));
+	UASSERTEQ(u16, seqnum, 65531);
+
+	// Resent duplicates are ignored, different ones are rejected
+	auto dup = make_reliable(0);
+	buf.insert(dup, next_expected);
+	UASSERTEQ(u32, buf.size(), 6);
+	auto bad = con::makePacket(Address(127,0,0,1, 11), con::makeReliablePacket(
+			SharedBuffer<u8>(1), 0), 0x12345678, 123, 0);
+	EXCEPTION_CHECK(con::IncomingDataCorruption, buf.insert(bad, next_expected));
+
+	// Outside of the window or the next expected one
+	auto outside = make_reliable(next_expected - 1);
+	buf.insert(outside, next_expected);
+	auto expected = make_reliable(next_expected);
+	buf.insert(expected, next_expected);
+	UASSERTEQ(u32, buf.size(), 6);
+
+	UASSERTEQ(u16, buf.popSeqnum(3)->getSeqnum(), 3);
+	EXCEPTION_CHECK(con::NotFoundException, buf.popSeqnum(3));
+	UASSERTEQ(u16, buf.popSeqnum(65531)->getSeqnum(), 65531);
+	UASSERT(buf.getFirstSeqnum(seqnum));
+	UASSERTEQ(u16, seqnum, 65533);
+
+	// Resends are handed out in order
+	buf.incrementTimeouts(1.0f);
+	UASSERTEQ(u32, buf.getTimedOuts(1.0f), 4);
+	auto resend = buf.getResend(0.5f, 3);
+	UASSERTEQ(size_t, resend.size(), 3);
+	UASSERTEQ(u16, resend[0]->getSeqnum(), 65533);
+	UASSERTEQ(u16, resend[1]->getSeqnum(), 65535);
+	UASSERTEQ(u16, resend[2]->getSeqnum(), 0);
+	UASSERTEQ(size_t, buf.getResend(0.5f, 3).size(), 1);
+
+	for (u16 s : {65533, 65535, 0, 200})
+		UASSERTEQ(u16, buf.popFirst()->getSeqnum(), s);
+	UASSERT(buf.empty());
+
+	// A long run of packets, popped while more are inserted
+	u16 next = 65000;
+	for (u32 i = 0; i < 3000; i++) {
+		auto p = make_reliable(65001 + i);
+		buf.insert(p, next);
+		if (i % 3 == 2) {
+			UASSERTEQ(u16, buf.popFirst()->getSeqnum(), (u16)(next + 1));
+			next++;
+		}
+	}
+	UASSERTEQ(u32, buf.size(), 2000);
+	UASSERT(buf.getFirstSeqnum(seqnum));
+	UASSERTEQ(u16, seqnum, (u16)(next + 1));
+}
+
+void TestConnection::testIncomingSplitBuffer()
+{
+	SharedBuffer<u8> data(1000);
+	for (u32 i = 0; i < data.getSize(); i++)
+		data[i] = i % 251;
+
+	u16 split_seqnum = 65535;
+	std::list<SharedBuffer<u8>> chunks;
+	con::makeAutoSplitPacket(data, 300, split_seqnum, &chunks);
+	con::makeAutoSplitPacket(data, 300, split_seqnum, &chunks);
+	UASSERTEQ(u16, split_seqnum, 1);
+	UASSERTEQ(size_t, chunks.size(), 8);
+
+	// Chunks of both packets interleaved, with the first one repeated
+	std::vector<con::BufferedPacketPtr> packets;
+	for (auto &chunk : chunks)
+		packets.push_back(con::makePacket(Address(127,0,0,1, 10), chunk,
+				0x12345678, 123, 0));
+	con::IncomingSplitBuffer buf;
+	for (u32 i : {0, 4, 1, 0, 5, 6, 2}) {
+		UASSERTEQ(u32, buf.insert(packets[i], true).getSize(), 0);
+	}
+
+	SharedBuffer<u8> full = buf.insert(packets[3], true);
+	UASSERT(full.getSize() == data.getSize());
+	UASSERT(memcmp(*full, *data, data.getSize()) == 0);
+	full = buf.insert(packets[7], true);
+	UASSERT(full.getSize() == data.getSize());
+	UASSERT(memcmp(*full, *data, data.getSize()) == 0);
+
+	// Unreliable ones time out
+	buf.insert(packets[0], false);
+	buf.removeUnreliableTimedOuts(2.0f, 1.0f);
+	for (u32 i = 1; i < 4; i++)
+		UASSERTEQ(u32, buf.insert(packets[i], false).getSize(), 0);
+}
+
 void TestConnection::testConnectSendReceive()
 {
 
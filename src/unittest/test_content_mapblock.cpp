@@ -146,6 +146,9 @@ class TestMapblockMeshGenerator : public TestBase {
 	void testSurroundedNode();
 	void testInterliquidSame();
 	void testInterliquidDifferent();
+	void testXrayNeighbor();
+	void testBlockOpacity();
+	void testGreedyMerge();
 };
 
 static TestMapblockMeshGenerator g_test_instance;
@@ -157,6 +160,9 @@ void TestMapblockMeshGenerator::runTests(IGameDef *gamedef)
 	TEST(testSurroundedNode);
 	TEST(testInterliquidSame);
 	TEST(testInterliquidDifferent);
+	TEST(testXrayNeighbor);
+	TEST(testBlockOpacity);
+	TEST(testGreedyMerge);
 }
 
 namespace quad {
@@ -180,8 +186,7 @@ void TestMapblockMeshGenerator::testSimpleNode()
 
 	MeshCollector col{{}};
 	MapblockMeshGenerator mg{&data, &col};
-	std::set<content_t> xraySet;
-	mg.generate(xraySet);
+	mg.generate();
 	UASSERTEQ(std::size_t, col.prebuffers[0].size(), 1);
 	UASSERTEQ(std::size_t, col.prebuffers[1].size(), 0);
 
@@ -203,8 +208,7 @@ void TestMapblockMeshGenerator::testSurroundedNode()
 
 	MeshCollector col{{}};
 	MapblockMeshGenerator mg{&data, &col};
-	std::set<content_t> xraySet;
-	mg.generate(xraySet);
+	mg.generate();
 	UASSERTEQ(std::size_t, col.prebuffers[0].size(), 1);
 	UASSERTEQ(std::size_t, col.prebuffers[1].size(), 0);
 
@@ -225,8 +229,7 @@ void TestMapblockMeshGenerator::testInterliquidSame()
 
 	MeshCollector col{{}};
 	MapblockMeshGenerator mg{&data, &col};
-	std::set<content_t> xraySet;
-	mg.generate(xraySet);
+	mg.generate();
 	UASSERTEQ(std::size_t, col.prebuffers[0].size(), 1);
 	UASSERTEQ(std::size_t, col.prebuffers[1].size(), 0);
 
@@ -248,8 +251,7 @@ void TestMapblockMeshGenerator::testInterliquidDifferent()
 
 	MeshCollector col{{}};
 	MapblockMeshGenerator mg{&data, &col};
-	std::set<content_t> xraySet;
-	mg.generate(xraySet);
+	mg.generate();
 	UASSERTEQ(std::size_t, col.prebuffers[0].size(), 1);
 	UASSERTEQ(std::size_t, col.prebuffers[1].size(), 0);
 
@@ -258,4 +260,118 @@ void TestMapblockMeshGenerator::testInterliquidDifferent()
 	UASSERT(checkMeshEqual(buf.vertices, buf.indices, {quad::xn, quad::xp, quad::yn, quad::yp, quad::zn, quad::zp}));
 }
 
+void TestMapblockMeshGenerator::testXrayNeighbor()
+{
+	MockGameDef gamedef;
+	content_t stone = gamedef.addSimpleNode("stone", 42);
+	content_t wood = gamedef.addSimpleNode("wood", 13);
+	gamedef.finalize();
+
+	MeshMakeData data = gamedef.makeSingleNodeMMD();
+	data.m_vmanip.setNode({0, 0, 0}, {stone, 0, 0});
+	data.m_vmanip.setNode({1, 0, 0}, {wood, 0, 0});
+
+	ContentFilter xray;
+	xray.insert(wood);
+	UASSERT(xray.contains(wood));
+	UASSERT(!xray.contains(stone));
+
+	MeshCollector col{{}};
+	MapblockMeshGenerator mg{&data, &col};
+	mg.generate(xray);
+	UASSERTEQ(std::size_t, col.prebuffers[0].size(), 1);
+	UASSERTEQ(std::size_t, col.prebuffers[1].size(), 0);
+
+	auto &&buf = col.prebuffers[0][0];
+	UASSERTEQ(u32, buf.layer.texture_id, 42);
+	UASSERT(checkMeshEqual(buf.vertices, buf.indices, {quad::xn, quad::xp, quad::yn, quad::yp, quad::zn, quad::zp}));
+}
+
+void TestMapblockMeshGenerator::testBlockOpacity()
+{
+	MockGameDef gamedef;
+	content_t stone = gamedef.addSimpleNode("stone", 42);
+	gamedef.finalize();
+
+	MeshMakeData data{gamedef.ndef(), MAP_BLOCKSIZE, MeshGrid{1}};
+	data.m_blockpos = {0, 0, 0};
+	v3s16 p;
+	for (p.Z = 0; p.Z < MAP_BLOCKSIZE; p.Z++)
+	for (p.Y = 0; p.Y < MAP_BLOCKSIZE; p.Y++)
+	for (p.X = 0; p.X < MAP_BLOCKSIZE; p.X++)
+		data.m_vmanip.setNode(p, {CONTENT_AIR, 0, 0});
+
+	auto opacity = get_block_opacity(&data);
+	UASSERTEQ(std::size_t, opacity.size(), 1);
+	UASSERT(opacity[0].first == v3s16(0, 0, 0));
+	UASSERT(opacity[0].second->empty);
+	UASSERT(!opacity[0].second->isOpaque({3, 4, 5}));
+
+	data.m_vmanip.setNode({3, 4, 5}, {stone, 0, 0});
+	opacity = get_block_opacity(&data);
+	UASSERT(!opacity[0].second->empty && !opacity[0].second->full);
+	UASSERT(opacity[0].second->isOpaque({3, 4, 5}));
+	UASSERT(!opacity[0].second->isOpaque({4, 4, 5}));
+	UASSERT(!opacity[0].second->isOpaque({3, 5, 4}));
+
+	for (p.Z = 0; p.Z < MAP_BLOCKSIZE; p.Z++)
+	for (p.Y = 0; p.Y < MAP_BLOCKSIZE; p.Y++)
+	for (p.X = 0; p.X < MAP_BLOCKSIZE; p.X++)
+		data.m_vmanip.setNode(p, {stone, 0, 0});
+	opacity = get_block_opacity(&data);
+	UASSERT(opacity[0].second->full);
+	UASSERT(opacity[0].second->isOpaque({0, 15, 0}));
+}
+
+void TestMapblockMeshGenerator::testGreedyMerge()
+{
+	MockGameDef gamedef;
+	content_t stone = gamedef.addSimpleNode("stone", 42);
+	gamedef.finalize();
+
+	MeshMakeData data{gamedef.ndef(), 2, MeshGrid{1}};
+	data.m_blockpos = {0, 0, 0};
+	data.m_greedy_meshing = true;
+	for (s16 x = -1; x <= 2; x++)
+	for (s16 y = -1; y <= 2; y++)
+	for (s16 z = -1; z <= 2; z++)
+		data.m_vmanip.setNode({x, y, z}, {CONTENT_AIR, 0, 0});
+	data.m_vmanip.setNode({0, 0, 0}, {stone, 0, 0});
+	data.m_vmanip.setNode({1, 0, 0}, {stone, 0, 0});
+
+	auto top_vertices = [] (const PreMeshBuffer &buf) {
+		return std::count_if(buf.vertices.begin(), buf.vertices.end(),
+				[] (const video::S3DVertex &v) { return v.Normal == v3f(0, 1, 0); });
+	};
+
+	{
+		// Flat lighting: top, bottom, front and back become one quad each
+		MeshCollector col{{}};
+		MapblockMeshGenerator mg{&data, &col};
+		mg.generate();
+		UASSERTEQ(std::size_t, col.prebuffers[0].size(), 1);
+		auto &&buf = col.prebuffers[0][0];
+		UASSERTEQ(std::size_t, buf.vertices.size(), 6 * 4);
+		UASSERTEQ(std::size_t, buf.indices.size(), 6 * 6);
+		UASSERTEQ(long, top_vertices(buf), 4);
+		for (auto &v : buf.vertices) {
+			UASSERT(v.Pos.X >= -0.5f * BS && v.Pos.X <= 1.5f * BS);
+			// the texture repeats once per node
+			if (v.Normal == v3f(0, 1, 0))
+				UASSERT(v.TCoords.X == (v.Pos.X < 0 ? 0.0f : 2.0f));
+		}
+	}
+
+	{
+		// Smooth lighting that differs across the top faces keeps them apart
+		data.m_smooth_lighting = true;
+		data.m_vmanip.setNode({1, 1, 0}, {CONTENT_AIR, 0xFF, 0});
+		MeshCollector col{{}};
+		MapblockMeshGenerator mg{&data, &col};
+		mg.generate();
+		UASSERTEQ(std::size_t, col.prebuffers[0].size(), 1);
+		UASSERTEQ(long, top_vertices(col.prebuffers[0][0]), 8);
+	}
+}
+
 }
@@ -27,6 +27,7 @@ class TestFileSys : public TestBase
 	void testAbsolutePath();
 	void testSafeWriteToFile();
 	void testCopyFileContents();
+	void testGetFileInfo();
 	void testNonExist();
 	void testRecursiveDelete();
 };
@@ -43,6 +44,7 @@ void TestFileSys::runTests(IGameDef *gamedef)
 	TEST(testAbsolutePath);
 	TEST(testSafeWriteToFile);
 	TEST(testCopyFileContents);
+	TEST(testGetFileInfo);
 	TEST(testNonExist);
 	TEST(testRecursiveDelete);
 }
@@ -344,6 +346,21 @@ void TestFileSys::testCopyFileContents()
 	UASSERTEQ(auto, contents_actual, test_data);
 }
 
+void TestFileSys::testGetFileInfo()
+{
+	const std::string path = getTestTempFile();
+	UASSERT(fs::safeWriteToFile(path, "hello"));
+
+	uint64_t size, mtime;
+	UASSERT(fs::GetFileInfo(path, size, mtime));
+	UASSERTEQ(uint64_t, size, 5);
+	UASSERT(mtime != 0);
+
+	UASSERT(fs::safeWriteToFile(path, "hello world"));
+	UASSERT(fs::GetFileInfo(path, size, mtime));
+	UASSERTEQ(uint64_t, size, 11);
+}
+
 void TestFileSys::testNonExist()
 {
 	const auto path = getTestTempFile();
@@ -353,6 +370,9 @@ void TestFileSys::testNonExist()
 	UASSERT(!fs::IsDir(path));
 	UASSERT(!fs::IsExecutable(path));
 
+	uint64_t size, mtime;
+	UASSERT(!fs::GetFileInfo(path, size, mtime));
+
 	std::string s;
 	UASSERT(!fs::ReadFile(path, s));
 	UASSERT(s.empty());
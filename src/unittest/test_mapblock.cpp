@@ -26,6 +26,8 @@ class TestMapBlock : public TestBase
 
 	void testSave29(IGameDef *gamedef);
 
+	void testSaveUncompressed(IGameDef *gamedef);
+
 	void testLoad29(IGameDef *gamedef);
 
 	// Tests loading a MapBlock from Minetest-c55 0.3
@@ -33,6 +35,10 @@ class TestMapBlock : public TestBase
 
 	// Tests loading a non-standard MapBlock
 	void testLoadNonStd(IGameDef *gamedef);
+
+#if CHECK_CLIENT_BUILD()
+	void testNodeSnapshot(IGameDef *gamedef);
+#endif
 };
 
 static TestMapBlock g_test_instance;
@@ -42,9 +48,13 @@ void TestMapBlock::runTests(IGameDef *gamedef)
 	TEST(testSaveLoad, gamedef, SER_FMT_VER_HIGHEST_WRITE);
 	TEST(testSaveLoadLowest, gamedef);
 	TEST(testSave29, gamedef);
+	TEST(testSaveUncompressed, gamedef);
 	TEST(testLoad29, gamedef);
 	TEST(testLoad20, gamedef);
 	TEST(testLoadNonStd, gamedef);
+#if CHECK_CLIENT_BUILD()
+	TEST(testNodeSnapshot, gamedef);
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -187,6 +197,28 @@ static const u8 coded_mapblock29[] = {
 	26,106
 };
 
+void TestMapBlock::testSaveUncompressed(IGameDef *gamedef)
+{
+	const u8 version = SER_FMT_VER_HIGHEST_WRITE;
+	MapBlock block({}, gamedef);
+	for (size_t i = 0; i < MapBlock::nodecount; ++i)
+		block.getData()[i] = MapNode(CONTENT_AIR);
+	block.setNode({1, 2, 3}, MapNode(t_CONTENT_STONE));
+
+	std::ostringstream os_full(std::ios_base::binary);
+	block.serialize(os_full, version, true, -1);
+
+	// Compressing the uncompressed form must yield identical data
+	std::ostringstream os_raw(std::ios_base::binary);
+	block.serializeUncompressed(os_raw, version, true);
+	std::ostringstream os_compressed(std::ios_base::binary);
+	compress(os_raw.str(), os_compressed, version, -1);
+	UASSERT(os_compressed.str() == os_full.str());
+
+	EXCEPTION_CHECK(VersionMismatchException,
+		block.serializeUncompressed(os_raw, 28, true));
+}
+
 void TestMapBlock::testLoad29(IGameDef *gamedef)
 {
 	UASSERT(MAP_BLOCKSIZE == 16);
@@ -356,3 +388,34 @@ void TestMapBlock::testLoadNonStd(IGameDef *gamedef)
 	for (s16 i = 0; i < 16; i++)
 		UASSERTEQ(int, block.getNodeNoEx({i, 1, 0}).param2, data_lo[i]);
 }
+
+#if CHECK_CLIENT_BUILD()
+void TestMapBlock::testNodeSnapshot(IGameDef *gamedef)
+{
+	MapBlock block({}, gamedef);
+	for (size_t i = 0; i < MapBlock::nodecount; ++i)
+		block.getData()[i] = MapNode(CONTENT_AIR);
+
+	// Shared while someone holds it
+	auto snapshot = block.getNodeSnapshot();
+	UASSERT(block.getNodeSnapshot() == snapshot);
+	UASSERTEQ(int, snapshot[0].getContent(), CONTENT_AIR);
+
+	// Reading the nodes keeps it
+	const MapBlock &const_block = block;
+	UASSERTEQ(int, const_block.getData()[0].getContent(), CONTENT_AIR);
+	UASSERT(block.getNodeSnapshot() == snapshot);
+
+	// Modifying them doesn't touch the old one
+	block.setNode({0, 0, 0}, MapNode(t_CONTENT_STONE));
+	auto modified = block.getNodeSnapshot();
+	UASSERT(modified != snapshot);
+	UASSERTEQ(int, snapshot[0].getContent(), CONTENT_AIR);
+	UASSERTEQ(int, modified[0].getContent(), t_CONTENT_STONE);
+
+	// The block doesn't keep it alive
+	std::weak_ptr<const MapNode[]> weak = modified;
+	modified.reset();
+	UASSERT(weak.expired());
+}
+#endif
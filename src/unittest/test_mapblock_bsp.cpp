@@ -0,0 +1,103 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "test.h"
+
+#include <algorithm>
+
+#include "client/mapblock_mesh.h"
+#include "noise.h"
+
+class TestMapBlockBsp : public TestBase
+{
+public:
+	TestMapBlockBsp() { TestManager::registerTestModule(this); }
+	const char *getName() override { return "TestMapBlockBsp"; }
+
+	void runTests(IGameDef *gamedef) override;
+
+	void testOrder();
+	void testSafeRadius();
+};
+
+static TestMapBlockBsp g_test_instance;
+
+void TestMapBlockBsp::runTests(IGameDef *gamedef)
+{
+	TEST(testOrder);
+	TEST(testSafeRadius);
+}
+
+static MeshTriangle make_triangle(v3f v1, v3f v2, v3f v3)
+{
+	MeshTriangle t{};
+	t.updateAttributes(v1, v2, v3);
+	return t;
+}
+
+// Horizontal triangle at height y
+static MeshTriangle make_layer(f32 y)
+{
+	return make_triangle(v3f(0, y, 0), v3f(0, y, BS), v3f(BS, y, 0));
+}
+
+void TestMapBlockBsp::testOrder()
+{
+	std::vector<MeshTriangle> triangles;
+	for (int i = 0; i < 4; i++)
+		triangles.push_back(make_layer(i * BS));
+
+	MapBlockBspTree tree;
+	tree.buildTree(&triangles, 1);
+
+	// Seen from above, the lowest layer is the farthest
+	std::vector<s32> order;
+	tree.traverse(v3f(0.5f * BS, 10 * BS, 0.5f * BS), order);
+	UASSERT(order == std::vector<s32>({0, 1, 2, 3}));
+
+	order.clear();
+	tree.traverse(v3f(0.5f * BS, -10 * BS, 0.5f * BS), order);
+	UASSERT(order == std::vector<s32>({3, 2, 1, 0}));
+
+	// Between two layers, each side is sorted towards the viewpoint
+	order.clear();
+	tree.traverse(v3f(0.5f * BS, 1.5f * BS, 0.5f * BS), order);
+	UASSERTEQ(size_t, order.size(), 4);
+	const auto index_of = [&] (s32 i) {
+		return std::find(order.begin(), order.end(), i) - order.begin();
+	};
+	UASSERT(index_of(0) < index_of(1));
+	UASSERT(index_of(3) < index_of(2));
+}
+
+void TestMapBlockBsp::testSafeRadius()
+{
+	PcgRandom pr(1234);
+	const auto random_pos = [&] () {
+		return v3f(pr.range(0, 1000), pr.range(0, 1000), pr.range(0, 1000))
+				* (MAP_BLOCKSIZE * BS / 1000.0f);
+	};
+
+	std::vector<MeshTriangle> triangles;
+	for (int i = 0; i < 50; i++)
+		triangles.push_back(make_triangle(random_pos(), random_pos(), random_pos()));
+
+	MapBlockBspTree tree;
+	tree.buildTree(&triangles, MAP_BLOCKSIZE);
+
+	for (int i = 0; i < 100; i++) {
+		v3f viewpoint = random_pos();
+		std::vector<s32> order;
+		f32 radius = tree.traverse(viewpoint, order);
+		UASSERT(radius >= 0);
+
+		// Moving within the radius keeps the order
+		v3f dir = random_pos() - v3f(MAP_BLOCKSIZE * BS / 2);
+		if (dir.getLengthSQ() == 0)
+			continue;
+		dir.setLength(radius * 0.99f);
+		std::vector<s32> moved;
+		tree.traverse(viewpoint + dir, moved);
+		UASSERT(moved == order);
+	}
+}
@@ -0,0 +1,139 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "test.h"
+
+#include "client/shader_binary_cache.h"
+#include "filesys.h"
+
+class TestShaderBinaryCache : public TestBase
+{
+public:
+	TestShaderBinaryCache() { TestManager::registerTestModule(this); }
+	const char *getName() override { return "TestShaderBinaryCache"; }
+
+	void runTests(IGameDef *gamedef) override;
+
+	void testRoundTrip();
+	void testDriverChange();
+	void testSourceChange();
+	void testOverwrite();
+	void testDamagedEntry();
+
+private:
+	std::string m_dir;
+};
+
+static TestShaderBinaryCache g_test_instance;
+
+static const std::string SOURCE = "void main() { gl_FragColor = vec4(1.0); }";
+static const std::string BINARY("\x01\x00\x02\xff binary", 11);
+
+void TestShaderBinaryCache::runTests(IGameDef *gamedef)
+{
+	m_dir = getTestTempDirectory() + DIR_DELIM + "shader_binary_cache";
+
+	TEST(testRoundTrip);
+	TEST(testDriverChange);
+	TEST(testSourceChange);
+	TEST(testOverwrite);
+	TEST(testDamagedEntry);
+
+	fs::RecursiveDelete(m_dir);
+}
+
+void TestShaderBinaryCache::testRoundTrip()
+{
+	fs::RecursiveDelete(m_dir);
+	ShaderBinaryCache cache(m_dir, "vendor\nrenderer\n1.0\n");
+
+	u32 format = 0;
+	std::string binary;
+	UASSERT(!cache.loadProgram(SOURCE, format, binary));
+
+	cache.storeProgram(SOURCE, 0x8741, BINARY);
+	UASSERT(cache.loadProgram(SOURCE, format, binary));
+	UASSERTEQ(u32, format, 0x8741);
+	UASSERT(binary == BINARY);
+
+	// A new instance sees the same entry
+	ShaderBinaryCache cache2(m_dir, "vendor\nrenderer\n1.0\n");
+	binary.clear();
+	UASSERT(cache2.loadProgram(SOURCE, format, binary));
+	UASSERT(binary == BINARY);
+}
+
+void TestShaderBinaryCache::testDriverChange()
+{
+	fs::RecursiveDelete(m_dir);
+	ShaderBinaryCache(m_dir, "vendor\nrenderer\n1.0\n").storeProgram(SOURCE, 1, BINARY);
+
+	u32 format;
+	std::string binary;
+	ShaderBinaryCache updated(m_dir, "vendor\nrenderer\n1.1\n");
+	UASSERT(!updated.loadProgram(SOURCE, format, binary));
+	ShaderBinaryCache other(m_dir, "other\nrenderer\n1.0\n");
+	UASSERT(!other.loadProgram(SOURCE, format, binary));
+}
+
+void TestShaderBinaryCache::testSourceChange()
+{
+	fs::RecursiveDelete(m_dir);
+	ShaderBinaryCache cache(m_dir, "driver");
+	cache.storeProgram(SOURCE, 1, BINARY);
+
+	u32 format;
+	std::string binary;
+	UASSERT(!cache.loadProgram(SOURCE + "\n", format, binary));
+	UASSERT(!cache.loadProgram("", format, binary));
+	UASSERT(cache.loadProgram(SOURCE, format, binary));
+}
+
+void TestShaderBinaryCache::testOverwrite()
+{
+	fs::RecursiveDelete(m_dir);
+	ShaderBinaryCache cache(m_dir, "driver");
+	cache.storeProgram(SOURCE, 1, BINARY);
+	cache.storeProgram(SOURCE, 2, "newer");
+
+	u32 format;
+	std::string binary;
+	UASSERT(cache.loadProgram(SOURCE, format, binary));
+	UASSERTEQ(u32, format, 2);
+	UASSERT(binary == "newer");
+
+	// Empty binaries are not stored
+	cache.storeProgram(SOURCE, 3, "");
+	UASSERT(cache.loadProgram(SOURCE, format, binary));
+	UASSERTEQ(u32, format, 2);
+}
+
+void TestShaderBinaryCache::testDamagedEntry()
+{
+	fs::RecursiveDelete(m_dir);
+	ShaderBinaryCache cache(m_dir, "driver");
+	cache.storeProgram(SOURCE, 1, BINARY);
+
+	auto entries = fs::GetDirListing(m_dir);
+	UASSERTEQ(size_t, entries.size(), 1);
+	const std::string path = m_dir + DIR_DELIM + entries[0].name;
+	std::string data;
+	UASSERT(fs::ReadFile(path, data));
+
+	u32 format;
+	std::string binary;
+
+	// Truncated in the middle of the binary
+	UASSERT(fs::safeWriteToFile(path, data.substr(0, data.size() - 3)));
+	UASSERT(!cache.loadProgram(SOURCE, format, binary));
+	UASSERT(binary.empty());
+
+	// Unknown format version
+	std::string changed = data;
+	changed[4] = 99;
+	UASSERT(fs::safeWriteToFile(path, changed));
+	UASSERT(!cache.loadProgram(SOURCE, format, binary));
+
+	UASSERT(fs::safeWriteToFile(path, data));
+	UASSERT(cache.loadProgram(SOURCE, format, binary));
+}
@@ -22,6 +22,7 @@ class TestSocket : public TestBase {
 
 	void testIPv4Socket();
 	void testIPv6Socket();
+	void testBatchedIO();
 
 	static const int port = 30003;
 };
@@ -34,6 +35,8 @@ void TestSocket::runTests(IGameDef *gamedef)
 
 	if (g_settings->getBool("enable_ipv6"))
 		TEST(testIPv6Socket);
+
+	TEST(testBatchedIO);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -132,3 +135,42 @@ void TestSocket::testIPv6Socket()
 				Address(&bytes, 0).getAddress6().s6_addr, 16) == 0);
 	}
 }
+
+void TestSocket::testBatchedIO()
+{
+	const Address loopback(127, 0, 0, 1, port + 1);
+	UDPSocket socket(false);
+	socket.Bind(Address(0, 0, 0, 0, port + 1));
+	socket.setTimeoutMs(50);
+
+	std::vector<UDPDatagram> out(5);
+	for (size_t i = 0; i < out.size(); i++) {
+		out[i].address = loopback;
+		out[i].data.assign(10 + i, 'a' + i);
+		out[i].size = out[i].data.size();
+	}
+	// Can't be sent on an IPv4 socket
+	UDPDatagram &bad = out.emplace_back();
+	bad.address = Address((IPv6AddressBytes *)NULL, port + 1);
+	bad.data.assign(4, 'x');
+	bad.size = 4;
+
+	UASSERTEQ(int, socket.SendMany(out.data(), out.size()), 1);
+
+	sleep_ms(50);
+
+	std::vector<UDPDatagram> in(8);
+	for (UDPDatagram &datagram : in)
+		datagram.data.resize(256);
+	size_t received = 0;
+	// Not every platform receives more than one at once
+	for (int tries = 0; tries < 10 && received < 5; tries++)
+		received += socket.ReceiveMany(&in[received], in.size() - received);
+
+	UASSERTEQ(size_t, received, 5);
+	for (size_t i = 0; i < received; i++) {
+		UASSERTEQ(size_t, in[i].size, out[i].size);
+		UASSERT(memcmp(in[i].data.data(), out[i].data.data(), in[i].size) == 0);
+		UASSERT(in[i].address == loopback);
+	}
+}
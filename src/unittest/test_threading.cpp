@@ -8,6 +8,7 @@
 #include <iostream>
 #include "threading/semaphore.h"
 #include "threading/thread.h"
+#include "threading/thread_pool.h"
 
 
 class TestThreading : public TestBase {
@@ -19,6 +20,7 @@ class TestThreading : public TestBase {
 	void testStartStopWait();
 	void testAtomicSemaphoreThread();
 	void testTLS();
+	void testThreadPool();
 };
 
 static TestThreading g_test_instance;
@@ -28,6 +30,7 @@ void TestThreading::runTests(IGameDef *gamedef)
 	TEST(testStartStopWait);
 	TEST(testAtomicSemaphoreThread);
 	TEST(testTLS);
+	TEST(testThreadPool);
 }
 
 class SimpleTestThread : public Thread {
@@ -227,3 +230,21 @@ void TestThreading::testTLS()
 		}
 	}
 }
+
+void TestThreading::testThreadPool()
+{
+	for (unsigned int num_workers : {0, 1, 3}) {
+		ThreadPool pool(num_workers, "TestPool");
+		UASSERTEQ(size_t, pool.getConcurrency(), num_workers + 1);
+
+		// Every index runs exactly once, for several jobs in a row
+		for (size_t count : {0, 1, 7, 1000}) {
+			std::vector<std::atomic<u32>> calls(count);
+			pool.run(count, [&] (size_t i) {
+				calls[i].fetch_add(1);
+			});
+			for (auto &c : calls)
+				UASSERTEQ(u32, c.load(), 1);
+		}
+	}
+}
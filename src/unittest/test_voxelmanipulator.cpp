@@ -19,6 +19,7 @@ class TestVoxelManipulator : public TestBase {
 
 	void testVoxelArea();
 	void testVoxelManipulator(const NodeDefManager *nodedef);
+	void testCopyFrom();
 };
 
 static TestVoxelManipulator g_test_instance;
@@ -27,6 +28,7 @@ void TestVoxelManipulator::runTests(IGameDef *gamedef)
 {
 	TEST(testVoxelArea);
 	TEST(testVoxelManipulator, gamedef->getNodeDefManager());
+	TEST(testCopyFrom);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -89,3 +91,31 @@ void TestVoxelManipulator::testVoxelManipulator(const NodeDefManager *nodedef)
 	UASSERT(v.getNode(v3s16(-1,0,-1)).getContent() == t_CONTENT_GRASS);
 	EXCEPTION_CHECK(InvalidPositionException, v.getNode(v3s16(0,1,1)));
 }
+
+void TestVoxelManipulator::testCopyFrom()
+{
+	// 4x4x4 source, each node tagged with its index
+	VoxelArea src_area(v3s16(0, 0, 0), v3s16(3, 3, 3));
+	std::vector<MapNode> src(src_area.getVolume());
+	for (u32 i = 0; i < src.size(); i++)
+		src[i] = MapNode(i);
+
+	VoxelManipulator v;
+	v.addArea(VoxelArea(v3s16(10, 10, 10), v3s16(14, 14, 14)));
+
+	// Copy only a 2x3x2 part of the source
+	v.copyFrom(src.data(), src_area, v3s16(1, 0, 2), v3s16(11, 12, 10),
+			v3s16(2, 3, 2));
+
+	v3s16 p;
+	for (p.Z = 0; p.Z < 2; p.Z++)
+	for (p.Y = 0; p.Y < 3; p.Y++)
+	for (p.X = 0; p.X < 2; p.X++) {
+		MapNode n = v.getNodeNoExNoEmerge(v3s16(11, 12, 10) + p);
+		UASSERTEQ(content_t, n.getContent(),
+				src_area.index(v3s16(1, 0, 2) + p));
+	}
+	// Outside of the copied box nothing was written
+	UASSERT(v.getNodeNoExNoEmerge(v3s16(13, 12, 10)).getContent() == CONTENT_IGNORE);
+	UASSERT(v.getNodeNoExNoEmerge(v3s16(11, 12, 12)).getContent() == CONTENT_IGNORE);
+}
@@ -140,6 +140,20 @@ inline constexpr core::vector3d<T> componentwise_max(const core::vector3d<T> &a,
 	return {std::max(a.X, b.X), std::max(a.Y, b.Y), std::max(a.Z, b.Z)};
 }
 
+template <typename T>
+inline constexpr core::vector2d<T> componentwise_min(const core::vector2d<T> &a,
+	const core::vector2d<T> &b)
+{
+	return {std::min(a.X, b.X), std::min(a.Y, b.Y)};
+}
+
+template <typename T>
+inline constexpr core::vector2d<T> componentwise_max(const core::vector2d<T> &a,
+	const core::vector2d<T> &b)
+{
+	return {std::max(a.X, b.X), std::max(a.Y, b.Y)};
+}
+
 /// @brief Describes a grid with given step, oirginating at (0,0,0)
 struct MeshGrid {
 	u16 cell_size;
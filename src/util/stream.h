@@ -60,3 +60,53 @@ class DummyStreamBuffer : public std::streambuf {
 		return n;
 	}
 };
+
+/*
+	Read-only stream buffer over memory owned by someone else, e.g. a
+	NetworkPacket. Nothing is copied; the memory must outlive the buffer.
+*/
+class StringViewStreamBuffer : public std::streambuf {
+public:
+	StringViewStreamBuffer(std::string_view data) {
+		char *begin = const_cast<char *>(data.data());
+		setg(begin, begin, begin + data.size());
+	}
+
+	// Data that was not read yet
+	std::string_view remaining() const {
+		return std::string_view(gptr(), egptr() - gptr());
+	}
+
+protected:
+	std::streamsize showmanyc() override {
+		return egptr() - gptr();
+	}
+
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+			std::ios_base::openmode which) override {
+		if (!(which & std::ios_base::in))
+			return pos_type(off_type(-1));
+		off_type base = dir == std::ios_base::beg ? 0 :
+			dir == std::ios_base::end ? egptr() - eback() : gptr() - eback();
+		off_type pos = base + off;
+		if (pos < 0 || pos > egptr() - eback())
+			return pos_type(off_type(-1));
+		setg(eback(), eback() + pos, egptr());
+		return pos_type(pos);
+	}
+
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+		return seekoff(off_type(pos), std::ios_base::beg, which);
+	}
+};
+
+// std::istream counterpart of StringViewStreamBuffer
+class StringViewStream : private StringViewStreamBuffer, public std::istream {
+public:
+	StringViewStream(std::string_view data) :
+		StringViewStreamBuffer(data),
+		std::istream(static_cast<StringViewStreamBuffer *>(this))
+	{}
+
+	using StringViewStreamBuffer::remaining;
+};